@@ -34,6 +34,8 @@ For discussion please visit http://box2d.org/forum
 #include "Box2D/Common/b2Settings.h"
 #include "Box2D/Common/b2Draw.h"
 #include "Box2D/Common/b2Timer.h"
+#include "Box2D/Common/b2ThreadPool.h"
+#include "Box2D/Common/b2ConcurrentBlockAllocator.h"
 
 #include "Box2D/Collision/Shapes/b2CircleShape.h"
 #include "Box2D/Collision/Shapes/b2EdgeShape.h"
@@ -44,12 +46,14 @@ For discussion please visit http://box2d.org/forum
 #include "Box2D/Collision/b2Distance.h"
 #include "Box2D/Collision/b2DynamicTree.h"
 #include "Box2D/Collision/b2TimeOfImpact.h"
+#include "Box2D/Collision/b2WideTree.h"
 
 #include "Box2D/Dynamics/b2Body.h"
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Dynamics/b2WorldCallbacks.h"
 #include "Box2D/Dynamics/b2TimeStep.h"
 #include "Box2D/Dynamics/b2World.h"
+#include "Box2D/Dynamics/b2WorldSnapshot.h"
 
 #include "Box2D/Dynamics/Contacts/b2Contact.h"
 
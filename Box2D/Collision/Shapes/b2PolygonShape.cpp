@@ -24,9 +24,23 @@ b2Shape* b2PolygonShape::Clone(b2BlockAllocator* allocator) const
 	void* mem = allocator->Allocate(sizeof(b2PolygonShape));
 	b2PolygonShape* clone = new (mem) b2PolygonShape;
 	*clone = *this;
+	clone->UpdateCoordinates();
 	return clone;
 }
 
+void b2PolygonShape::UpdateCoordinates()
+{
+	b2Assert(m_count > 0);
+	for (int32 i = 0; i < b2_maxPolygonVertices; ++i)
+	{
+		int32 j = i < m_count ? i : 0;
+		m_vertexX[i] = m_vertices[j].x;
+		m_vertexY[i] = m_vertices[j].y;
+		m_normalX[i] = m_normals[j].x;
+		m_normalY[i] = m_normals[j].y;
+	}
+}
+
 void b2PolygonShape::SetAsBox(float32 hx, float32 hy)
 {
 	m_count = 4;
@@ -39,6 +53,7 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy)
 	m_normals[2].Set(0.0f, 1.0f);
 	m_normals[3].Set(-1.0f, 0.0f);
 	m_centroid.SetZero();
+	UpdateCoordinates();
 }
 
 void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, float32 angle)
@@ -64,6 +79,8 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, floa
 		m_vertices[i] = b2Mul(xf, m_vertices[i]);
 		m_normals[i] = b2Mul(xf.q, m_normals[i]);
 	}
+
+	UpdateCoordinates();
 }
 
 int32 b2PolygonShape::GetChildCount() const
@@ -247,6 +264,8 @@ void b2PolygonShape::Set(const b2Vec2* vertices, int32 count)
 
 	// Compute the polygon centroid.
 	m_centroid = ComputeCentroid(m_vertices, m);
+
+	UpdateCoordinates();
 }
 
 bool b2PolygonShape::TestPoint(const b2Transform& xf, const b2Vec2& p) const
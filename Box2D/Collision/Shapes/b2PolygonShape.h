@@ -72,10 +72,22 @@ public:
 	/// @returns true if valid
 	bool Validate() const;
 
+	/// Copy the vertices and normals to the coordinate arrays. Set, SetAsBox
+	/// and Clone do this, so only call it after changing m_vertices or
+	/// m_normals directly on a shape that is used without a fixture.
+	void UpdateCoordinates();
+
 	b2Vec2 m_centroid;
 	b2Vec2 m_vertices[b2_maxPolygonVertices];
 	b2Vec2 m_normals[b2_maxPolygonVertices];
 	int32 m_count;
+
+	/// The vertices and normals by coordinate, for collision code that works
+	/// on several edges at once. Past m_count they repeat the first entry.
+	float32 m_vertexX[b2_maxPolygonVertices];
+	float32 m_vertexY[b2_maxPolygonVertices];
+	float32 m_normalX[b2_maxPolygonVertices];
+	float32 m_normalY[b2_maxPolygonVertices];
 };
 
 inline b2PolygonShape::b2PolygonShape()
@@ -17,10 +17,30 @@
 */
 
 #include "Box2D/Collision/b2BroadPhase.h"
+#include "Box2D/Common/b2ThreadPool.h"
+
+// The number of moved proxies a thread takes at a time.
+#define b2_pairQueryRangeSize 64
+
+// The pairs found by one thread.
+struct b2ThreadPairs
+{
+	b2Pair* pairs;
+	int32 count;
+	int32 capacity;
+};
 
 b2BroadPhase::b2BroadPhase()
 {
-	m_proxyCount = 0;
+	for (int32 i = 0; i < e_proxyTypeCount; ++i)
+	{
+		m_proxyCounts[i] = 0;
+		m_changeCounts[i] = 0;
+		m_wideTreeValid[i] = false;
+	}
+	m_wideTreesEnabled = false;
+	m_staticTreeEnabled = false;
+	m_pairMethod = e_treeQueries;
 
 	m_pairCapacity = 16;
 	m_pairCount = 0;
@@ -29,35 +49,94 @@ b2BroadPhase::b2BroadPhase()
 	m_moveCapacity = 16;
 	m_moveCount = 0;
 	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+
+	m_threadPool = nullptr;
+	m_threadPairs = nullptr;
+	m_threadCount = 0;
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
+	SetThreadPool(nullptr);
 	b2Free(m_moveBuffer);
 	b2Free(m_pairBuffer);
 }
 
-int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
+int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData, ProxyType type)
 {
-	int32 proxyId = m_tree.CreateProxy(aabb, userData);
-	++m_proxyCount;
+	if (m_staticTreeEnabled == false)
+	{
+		type = e_dynamicProxy;
+	}
+
+	int32 proxyId = MakeProxyId(m_trees[type].CreateProxy(aabb, userData), type);
+	++m_proxyCounts[type];
+	++m_changeCounts[type];
+	m_wideTreeValid[type] = false;
+	if (m_pairMethod == e_sweepAndPrune)
+	{
+		m_sweepAndPrune.AddProxy(proxyId, GetFatAABB(proxyId), type == e_staticProxy);
+	}
 	BufferMove(proxyId);
 	return proxyId;
 }
 
+void b2BroadPhase::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds,
+								 ProxyType type)
+{
+	if (m_staticTreeEnabled == false)
+	{
+		type = e_dynamicProxy;
+	}
+
+	m_trees[type].CreateProxies(aabbs, userData, count, proxyIds);
+	m_proxyCounts[type] += count;
+	m_changeCounts[type] = 0;
+	m_wideTreeValid[type] = false;
+	for (int32 i = 0; i < count; ++i)
+	{
+		proxyIds[i] = MakeProxyId(proxyIds[i], type);
+		if (m_pairMethod == e_sweepAndPrune)
+		{
+			m_sweepAndPrune.AddProxy(proxyIds[i], GetFatAABB(proxyIds[i]), type == e_staticProxy);
+		}
+		BufferMove(proxyIds[i]);
+	}
+}
+
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
 	UnBufferMove(proxyId);
-	--m_proxyCount;
-	m_tree.DestroyProxy(proxyId);
+	if (m_pairMethod == e_sweepAndPrune)
+	{
+		m_sweepAndPrune.RemoveProxy(proxyId);
+	}
+	ProxyType type = GetProxyType(proxyId);
+	--m_proxyCounts[type];
+	m_wideTreeValid[type] = false;
+	m_trees[type].DestroyProxy(GetNodeId(proxyId));
 }
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
-	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
+	ProxyType type = GetProxyType(proxyId);
+	bool buffer = m_trees[type].MoveProxy(GetNodeId(proxyId), aabb, displacement);
 	if (buffer)
 	{
-		BufferMove(proxyId);
+		if (type == e_staticProxy)
+		{
+			++m_changeCounts[type];
+		}
+		m_wideTreeValid[type] = false;
+
+		if (m_pairMethod == e_sweepAndPrune)
+		{
+			m_sweepAndPrune.MoveProxy(proxyId, GetFatAABB(proxyId));
+		}
+		else
+		{
+			BufferMove(proxyId);
+		}
 	}
 }
 
@@ -66,6 +145,101 @@ void b2BroadPhase::TouchProxy(int32 proxyId)
 	BufferMove(proxyId);
 }
 
+void b2BroadPhase::SetWideTreesEnabled(bool flag)
+{
+	m_wideTreesEnabled = flag;
+	if (flag == false)
+	{
+		for (int32 i = 0; i < e_proxyTypeCount; ++i)
+		{
+			m_wideTreeValid[i] = false;
+		}
+	}
+}
+
+void b2BroadPhase::SetThreadPool(b2ThreadPool* pool)
+{
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		b2Free(m_threadPairs[i].pairs);
+	}
+	b2Free(m_threadPairs);
+	m_threadPairs = nullptr;
+	m_threadCount = 0;
+
+	m_threadPool = pool;
+	if (pool == nullptr)
+	{
+		return;
+	}
+
+	m_threadCount = pool->GetThreadCount();
+	m_threadPairs = (b2ThreadPairs*)b2Alloc(m_threadCount * sizeof(b2ThreadPairs));
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		m_threadPairs[i].capacity = 16;
+		m_threadPairs[i].count = 0;
+		m_threadPairs[i].pairs = (b2Pair*)b2Alloc(m_threadPairs[i].capacity * sizeof(b2Pair));
+	}
+}
+
+// Gathers the ids of all proxies.
+struct b2BroadPhaseProxyGatherer
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		proxyIds[count] = proxyId;
+		++count;
+		return true;
+	}
+
+	int32* proxyIds;
+	int32 count;
+};
+
+void b2BroadPhase::SetPairMethod(PairMethod method)
+{
+	if (method == m_pairMethod)
+	{
+		return;
+	}
+
+	b2BroadPhaseProxyGatherer gatherer;
+	gatherer.proxyIds = (int32*)b2Alloc(b2Max(GetProxyCount(), 1) * sizeof(int32));
+	gatherer.count = 0;
+
+	b2AABB aabb;
+	aabb.lowerBound.Set(-b2_maxFloat, -b2_maxFloat);
+	aabb.upperBound.Set(b2_maxFloat, b2_maxFloat);
+	Query(&gatherer, aabb);
+	b2Assert(gatherer.count == GetProxyCount());
+
+	if (method == e_sweepAndPrune)
+	{
+		// The proxies that moved since the last UpdatePairs are still in the
+		// move buffer. Sort the boxes now, so the sort sees every later move.
+		for (int32 i = 0; i < gatherer.count; ++i)
+		{
+			int32 proxyId = gatherer.proxyIds[i];
+			m_sweepAndPrune.AddProxy(proxyId, GetFatAABB(proxyId), GetProxyType(proxyId) == e_staticProxy);
+		}
+		m_sweepAndPrune.UpdatePairs();
+	}
+	else
+	{
+		// The sort did not buffer the proxies that moved since the last
+		// UpdatePairs, so query the trees with all of them once.
+		m_sweepAndPrune.Clear();
+		for (int32 i = 0; i < gatherer.count; ++i)
+		{
+			BufferMove(gatherer.proxyIds[i]);
+		}
+	}
+
+	b2Free(gatherer.proxyIds);
+	m_pairMethod = method;
+}
+
 void b2BroadPhase::BufferMove(int32 proxyId)
 {
 	if (m_moveCount == m_moveCapacity)
@@ -92,15 +266,154 @@ void b2BroadPhase::UnBufferMove(int32 proxyId)
 	}
 }
 
+// Gathers the pairs of one moved proxy into the pairs of a thread.
+struct b2PairQueryCallback
+{
+	bool QueryCallback(int32 nodeId)
+	{
+		int32 proxyId = b2BroadPhase::MakeProxyId(nodeId, queryType);
+
+		// A proxy cannot form a pair with itself.
+		if (proxyId == queryProxyId)
+		{
+			return true;
+		}
+
+		if (pairs->count == pairs->capacity)
+		{
+			b2Pair* oldPairs = pairs->pairs;
+			pairs->capacity *= 2;
+			pairs->pairs = (b2Pair*)b2Alloc(pairs->capacity * sizeof(b2Pair));
+			memcpy(pairs->pairs, oldPairs, pairs->count * sizeof(b2Pair));
+			b2Free(oldPairs);
+		}
+
+		b2Pair* pair = pairs->pairs + pairs->count;
+		pair->proxyIdA = b2Min(proxyId, queryProxyId);
+		pair->proxyIdB = b2Max(proxyId, queryProxyId);
+		++pairs->count;
+
+		return true;
+	}
+
+	b2ThreadPairs* pairs;
+	int32 queryProxyId;
+	b2BroadPhase::ProxyType queryType;
+};
+
+class b2PairQueryTask : public b2ParallelTask
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		b2PairQueryCallback callback;
+		callback.pairs = m_broadPhase->m_threadPairs + threadIndex;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			callback.queryProxyId = m_broadPhase->m_moveBuffer[i];
+			if (callback.queryProxyId == b2BroadPhase::e_nullProxy)
+			{
+				continue;
+			}
+
+			const b2AABB& fatAABB = m_broadPhase->GetFatAABB(callback.queryProxyId);
+
+			callback.queryType = b2BroadPhase::e_dynamicProxy;
+			m_broadPhase->m_trees[b2BroadPhase::e_dynamicProxy].Query(&callback, fatAABB);
+
+			if (m_broadPhase->GetProxyType(callback.queryProxyId) == b2BroadPhase::e_dynamicProxy)
+			{
+				callback.queryType = b2BroadPhase::e_staticProxy;
+				m_broadPhase->m_trees[b2BroadPhase::e_staticProxy].Query(&callback, fatAABB);
+			}
+		}
+	}
+
+	const b2BroadPhase* m_broadPhase;
+};
+
+void b2BroadPhase::QueryMoveBuffer()
+{
+	if (m_threadPool != nullptr && m_threadCount > 1 && m_moveCount > b2_pairQueryRangeSize)
+	{
+		for (int32 i = 0; i < m_threadCount; ++i)
+		{
+			m_threadPairs[i].count = 0;
+		}
+
+		b2PairQueryTask task;
+		task.m_broadPhase = this;
+		m_threadPool->ParallelFor(&task, m_moveCount, b2_pairQueryRangeSize);
+
+		// The threads found the pairs in any order, but they are sorted
+		// before they are reported.
+		int32 pairCount = m_pairCount;
+		for (int32 i = 0; i < m_threadCount; ++i)
+		{
+			pairCount += m_threadPairs[i].count;
+		}
+
+		if (pairCount > m_pairCapacity)
+		{
+			b2Pair* oldBuffer = m_pairBuffer;
+			m_pairCapacity = b2Max(2 * m_pairCapacity, pairCount);
+			m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+			memcpy(m_pairBuffer, oldBuffer, m_pairCount * sizeof(b2Pair));
+			b2Free(oldBuffer);
+		}
+
+		for (int32 i = 0; i < m_threadCount; ++i)
+		{
+			memcpy(m_pairBuffer + m_pairCount, m_threadPairs[i].pairs, m_threadPairs[i].count * sizeof(b2Pair));
+			m_pairCount += m_threadPairs[i].count;
+		}
+
+		return;
+	}
+
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		m_queryProxyId = m_moveBuffer[i];
+		if (m_queryProxyId == e_nullProxy)
+		{
+			continue;
+		}
+
+		// We have to query the tree with the fat AABB so that
+		// we don't fail to create a pair that may touch later.
+		const b2AABB& fatAABB = GetFatAABB(m_queryProxyId);
+
+		// Query the trees, create pairs and add them pair buffer. Static
+		// proxies never pair with each other.
+		m_queryType = e_dynamicProxy;
+		m_trees[e_dynamicProxy].Query(this, fatAABB);
+
+		if (GetProxyType(m_queryProxyId) == e_dynamicProxy)
+		{
+			m_queryType = e_staticProxy;
+			m_trees[e_staticProxy].Query(this, fatAABB);
+		}
+	}
+}
+
 // This is called from b2DynamicTree::Query when we are gathering pairs.
-bool b2BroadPhase::QueryCallback(int32 proxyId)
+bool b2BroadPhase::QueryCallback(int32 nodeId)
 {
+	int32 proxyId = MakeProxyId(nodeId, m_queryType);
+
 	// A proxy cannot form a pair with itself.
 	if (proxyId == m_queryProxyId)
 	{
 		return true;
 	}
 
+	BufferPair(proxyId, m_queryProxyId);
+	return true;
+}
+
+void b2BroadPhase::BufferPair(int32 proxyIdA, int32 proxyIdB)
+{
 	// Grow the pair buffer as needed.
 	if (m_pairCount == m_pairCapacity)
 	{
@@ -111,9 +424,34 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 		b2Free(oldBuffer);
 	}
 
-	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyId, m_queryProxyId);
-	m_pairBuffer[m_pairCount].proxyIdB = b2Max(proxyId, m_queryProxyId);
+	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyIdA, proxyIdB);
+	m_pairBuffer[m_pairCount].proxyIdB = b2Max(proxyIdA, proxyIdB);
 	++m_pairCount;
+}
 
-	return true;
+void b2BroadPhase::CopyFrom(const b2BroadPhase& other)
+{
+	for (int32 i = 0; i < e_proxyTypeCount; ++i)
+	{
+		m_trees[i].CopyFrom(other.m_trees[i]);
+		m_proxyCounts[i] = other.m_proxyCounts[i];
+		m_changeCounts[i] = other.m_changeCounts[i];
+
+		// The wide trees are refreshed by the next UpdatePairs.
+		m_wideTreeValid[i] = false;
+	}
+
+	if (m_moveCapacity < other.m_moveCount)
+	{
+		b2Free(m_moveBuffer);
+		m_moveCapacity = other.m_moveCapacity;
+		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	}
+
+	memcpy(m_moveBuffer, other.m_moveBuffer, other.m_moveCount * sizeof(int32));
+	m_moveCount = other.m_moveCount;
+
+	m_sweepAndPrune.CopyFrom(other.m_sweepAndPrune);
+	m_pairMethod = other.m_pairMethod;
+	m_staticTreeEnabled = other.m_staticTreeEnabled;
 }
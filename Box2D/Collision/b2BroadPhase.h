@@ -22,8 +22,13 @@
 #include "Box2D/Common/b2Settings.h"
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Collision/b2DynamicTree.h"
+#include "Box2D/Collision/b2WideTree.h"
+#include "Box2D/Collision/b2SweepAndPrune.h"
 #include <algorithm>
 
+class b2ThreadPool;
+struct b2ThreadPairs;
+
 struct b2Pair
 {
 	int32 proxyIdA;
@@ -33,6 +38,18 @@ struct b2Pair
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
+///
+/// Static proxies can live in their own tree, see SetStaticTreeEnabled. It is rebuilt
+/// from scratch after a batch of changes instead of being balanced on every insertion,
+/// and moving proxies query it without static proxies ever querying each other. The
+/// lowest bit of a proxy id selects the tree and the remaining bits are the node in
+/// that tree.
+///
+/// By default the pairs of moved proxies are found by querying the trees. The
+/// sweep and prune method instead keeps the proxy bounds sorted incrementally
+/// and only reports pairs that start to overlap, which is cheaper when many
+/// similar sized proxies move a little every step. The trees are kept for the
+/// queries and ray casts either way.
 class b2BroadPhase
 {
 public:
@@ -42,12 +59,32 @@ public:
 		e_nullProxy = -1
 	};
 
+	enum ProxyType
+	{
+		e_dynamicProxy = 0,
+		e_staticProxy = 1,
+		e_proxyTypeCount = 2
+	};
+
+	/// How UpdatePairs finds the pairs of moved proxies.
+	enum PairMethod
+	{
+		e_treeQueries = 0,	///< query the trees with each moved proxy
+		e_sweepAndPrune = 1	///< sort the proxy bounds along both axes
+	};
+
 	b2BroadPhase();
 	~b2BroadPhase();
 
 	/// Create a proxy with an initial AABB. Pairs are not reported until
-	/// UpdatePairs is called.
-	int32 CreateProxy(const b2AABB& aabb, void* userData);
+	/// UpdatePairs is called. Static proxies are not paired with each other.
+	/// Without the static tree every proxy is created as a dynamic proxy.
+	int32 CreateProxy(const b2AABB& aabb, void* userData, ProxyType type = e_dynamicProxy);
+
+	/// Create many proxies at once from arrays of AABBs and user data. The tree is
+	/// rebuilt around them. The ids are written to proxyIds.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds,
+					   ProxyType type = e_dynamicProxy);
 
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
@@ -57,6 +94,8 @@ public:
 	void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement);
 
 	/// Call to trigger a re-processing of it's pairs on the next call to UpdatePairs.
+	/// With sweep and prune this is the only way to have a pair reported again
+	/// while the proxies keep overlapping, for example after a filter change.
 	void TouchProxy(int32 proxyId);
 
 	/// Get the fat AABB for a proxy.
@@ -65,6 +104,9 @@ public:
 	/// Get user data from a proxy. Returns nullptr if the id is invalid.
 	void* GetUserData(int32 proxyId) const;
 
+	/// Get the type of a proxy.
+	ProxyType GetProxyType(int32 proxyId) const;
+
 	/// Test overlap of fat AABBs.
 	bool TestOverlap(int32 proxyIdA, int32 proxyIdB) const;
 
@@ -90,32 +132,97 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
-	/// Get the height of the embedded tree.
+	/// Ray-cast a packet of up to b2_rayPacketSize rays against the proxies in the
+	/// trees. See b2DynamicTree::RayCastPacket.
+	template <typename T>
+	void RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const;
+
+	/// Get the height of the embedded trees.
 	int32 GetTreeHeight() const;
 
-	/// Get the balance of the embedded tree.
+	/// Get the balance of the embedded trees.
 	int32 GetTreeBalance() const;
 
-	/// Get the quality metric of the embedded tree.
+	/// Get the quality metric of the embedded trees, the worse of the two.
 	float32 GetTreeQuality() const;
 
+	/// Rebuild the embedded trees from scratch. Proxy ids are preserved. UpdatePairs
+	/// does this by itself after a large batch of changes.
+	void RebuildTree();
+
+	/// Enable/disable the wide trees. When enabled, UpdatePairs refreshes a
+	/// b2WideTree copy of each tree that has changed, and Query and RayCast use
+	/// the copies while they are up to date. Callbacks may come in another order.
+	void SetWideTreesEnabled(bool flag);
+	bool GetWideTreesEnabled() const;
+
+	/// Enable/disable the static tree. When enabled, static proxies are created
+	/// in a tree of their own. When disabled, which is the default, all proxies
+	/// share one tree and proxy ids, and so the pair order, follow its node ids.
+	/// Existing proxies keep their tree until they are recreated.
+	void SetStaticTreeEnabled(bool flag);
+	bool GetStaticTreeEnabled() const;
+
+	/// Select how UpdatePairs finds the pairs of moved proxies. Switching
+	/// method between steps does not lose any pairs.
+	void SetPairMethod(PairMethod method);
+	PairMethod GetPairMethod() const;
+
+	/// Set a thread pool for UpdatePairs to query the trees with the moved
+	/// proxies in parallel. The pairs are sorted before they are reported, so
+	/// the callbacks do not depend on the thread count. Pass nullptr to query
+	/// on the calling thread only.
+	void SetThreadPool(b2ThreadPool* pool);
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Make this broad-phase an exact copy of another one, including the trees
+	/// and the pending move buffer.
+	void CopyFrom(const b2BroadPhase& other);
+
 private:
 
 	friend class b2DynamicTree;
 
+	template <typename T>
+	friend struct b2BroadPhaseQueryWrapper;
+
+	template <typename T>
+	friend struct b2BroadPhaseRayCastWrapper;
+
+	template <typename T>
+	friend struct b2BroadPhaseRayPacketWrapper;
+
+	friend struct b2PairQueryCallback;
+	friend class b2PairQueryTask;
+
+	static int32 MakeProxyId(int32 nodeId, ProxyType type);
+	const b2DynamicTree& GetTree(int32 proxyId) const;
+	static int32 GetNodeId(int32 proxyId);
+
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
+	void BufferPair(int32 proxyIdA, int32 proxyIdB);
+
+	void QueryMoveBuffer();
+	bool QueryCallback(int32 nodeId);
+
+	b2DynamicTree m_trees[e_proxyTypeCount];
 
-	bool QueryCallback(int32 proxyId);
+	b2WideTree m_wideTrees[e_proxyTypeCount];
+	bool m_wideTreeValid[e_proxyTypeCount];
+	bool m_wideTreesEnabled;
 
-	b2DynamicTree m_tree;
+	bool m_staticTreeEnabled;
 
-	int32 m_proxyCount;
+	int32 m_proxyCounts[e_proxyTypeCount];
+
+	// The number of proxies created, or static proxies reinserted, since the
+	// tree was last rebuilt.
+	int32 m_changeCounts[e_proxyTypeCount];
 
 	int32* m_moveBuffer;
 	int32 m_moveCapacity;
@@ -126,6 +233,14 @@ private:
 	int32 m_pairCount;
 
 	int32 m_queryProxyId;
+	ProxyType m_queryType;
+
+	b2SweepAndPrune m_sweepAndPrune;
+	PairMethod m_pairMethod;
+
+	b2ThreadPool* m_threadPool;
+	b2ThreadPairs* m_threadPairs;
+	int32 m_threadCount;
 };
 
 /// This is used to sort pairs.
@@ -144,66 +259,198 @@ inline bool b2PairLessThan(const b2Pair& pair1, const b2Pair& pair2)
 	return false;
 }
 
+/// Maps the node ids of a tree query back to proxy ids.
+template <typename T>
+struct b2BroadPhaseQueryWrapper
+{
+	bool QueryCallback(int32 nodeId)
+	{
+		return callback->QueryCallback(b2BroadPhase::MakeProxyId(nodeId, type));
+	}
+
+	T* callback;
+	b2BroadPhase::ProxyType type;
+};
+
+/// Maps the node ids of a tree ray-cast back to proxy ids and keeps the clipped
+/// fraction, so the ray continues into the next tree where it left off.
+template <typename T>
+struct b2BroadPhaseRayCastWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 nodeId)
+	{
+		float32 value = callback->RayCastCallback(input, b2BroadPhase::MakeProxyId(nodeId, type));
+		if (value == 0.0f)
+		{
+			terminated = true;
+		}
+		else if (value > 0.0f)
+		{
+			maxFraction = value;
+		}
+		return value;
+	}
+
+	T* callback;
+	b2BroadPhase::ProxyType type;
+	float32 maxFraction;
+	bool terminated;
+};
+
+/// Like b2BroadPhaseRayCastWrapper for each ray of a packet.
+template <typename T>
+struct b2BroadPhaseRayPacketWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 nodeId, int32 rayIndex)
+	{
+		if (terminated[rayIndex])
+		{
+			return 0.0f;
+		}
+
+		int32 proxyId = b2BroadPhase::MakeProxyId(nodeId, type);
+		float32 value = callback->RayCastCallback(input, proxyId, rayIndex);
+		if (value == 0.0f)
+		{
+			terminated[rayIndex] = true;
+			--activeCount;
+		}
+		else if (value > 0.0f)
+		{
+			maxFractions[rayIndex] = value;
+		}
+		return value;
+	}
+
+	T* callback;
+	b2BroadPhase::ProxyType type;
+	float32 maxFractions[b2_rayPacketSize];
+	bool terminated[b2_rayPacketSize];
+	int32 activeCount;
+};
+
+inline int32 b2BroadPhase::MakeProxyId(int32 nodeId, ProxyType type)
+{
+	return (nodeId << 1) | type;
+}
+
+inline const b2DynamicTree& b2BroadPhase::GetTree(int32 proxyId) const
+{
+	return m_trees[proxyId & 1];
+}
+
+inline int32 b2BroadPhase::GetNodeId(int32 proxyId)
+{
+	return proxyId >> 1;
+}
+
 inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 {
-	return m_tree.GetUserData(proxyId);
+	return GetTree(proxyId).GetUserData(GetNodeId(proxyId));
+}
+
+inline b2BroadPhase::ProxyType b2BroadPhase::GetProxyType(int32 proxyId) const
+{
+	return ProxyType(proxyId & 1);
 }
 
 inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
 {
-	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
-	const b2AABB& aabbB = m_tree.GetFatAABB(proxyIdB);
+	const b2AABB& aabbA = GetFatAABB(proxyIdA);
+	const b2AABB& aabbB = GetFatAABB(proxyIdB);
 	return b2TestOverlap(aabbA, aabbB);
 }
 
 inline const b2AABB& b2BroadPhase::GetFatAABB(int32 proxyId) const
 {
-	return m_tree.GetFatAABB(proxyId);
+	return GetTree(proxyId).GetFatAABB(GetNodeId(proxyId));
 }
 
 inline int32 b2BroadPhase::GetProxyCount() const
 {
-	return m_proxyCount;
+	return m_proxyCounts[e_dynamicProxy] + m_proxyCounts[e_staticProxy];
 }
 
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
-	return m_tree.GetHeight();
+	return b2Max(m_trees[e_dynamicProxy].GetHeight(), m_trees[e_staticProxy].GetHeight());
 }
 
 inline int32 b2BroadPhase::GetTreeBalance() const
 {
-	return m_tree.GetMaxBalance();
+	return b2Max(m_trees[e_dynamicProxy].GetMaxBalance(), m_trees[e_staticProxy].GetMaxBalance());
 }
 
 inline float32 b2BroadPhase::GetTreeQuality() const
 {
-	return m_tree.GetAreaRatio();
+	return b2Max(m_trees[e_dynamicProxy].GetAreaRatio(), m_trees[e_staticProxy].GetAreaRatio());
+}
+
+inline void b2BroadPhase::RebuildTree()
+{
+	for (int32 i = 0; i < e_proxyTypeCount; ++i)
+	{
+		m_trees[i].RebuildTopDown();
+		m_changeCounts[i] = 0;
+		m_wideTreeValid[i] = false;
+	}
+}
+
+inline bool b2BroadPhase::GetWideTreesEnabled() const
+{
+	return m_wideTreesEnabled;
+}
+
+inline void b2BroadPhase::SetStaticTreeEnabled(bool flag)
+{
+	m_staticTreeEnabled = flag;
+}
+
+inline bool b2BroadPhase::GetStaticTreeEnabled() const
+{
+	return m_staticTreeEnabled;
+}
+
+inline b2BroadPhase::PairMethod b2BroadPhase::GetPairMethod() const
+{
+	return m_pairMethod;
 }
 
 template <typename T>
 void b2BroadPhase::UpdatePairs(T* callback)
 {
+	// A large batch of changes, such as a level being loaded, leaves an
+	// incrementally built tree far from optimal. Rebuild it in one go. The pairs
+	// are sorted below, so the tree layout does not change the pair order.
+	for (int32 i = 0; i < e_proxyTypeCount; ++i)
+	{
+		if (m_changeCounts[i] >= b2_treeRebuildCount && 4 * m_changeCounts[i] >= m_proxyCounts[i])
+		{
+			m_trees[i].RebuildTopDown();
+			m_changeCounts[i] = 0;
+			m_wideTreeValid[i] = false;
+		}
+	}
+
 	// Reset pair buffer
 	m_pairCount = 0;
 
-	// Perform tree queries for all moving proxies.
-	for (int32 i = 0; i < m_moveCount; ++i)
+	// With sweep and prune the sort finds the new pairs of moved proxies, and
+	// the move buffer only holds new and touched proxies.
+	if (m_pairMethod == e_sweepAndPrune)
 	{
-		m_queryProxyId = m_moveBuffer[i];
-		if (m_queryProxyId == e_nullProxy)
+		m_sweepAndPrune.UpdatePairs();
+		const b2Pair* pairs = m_sweepAndPrune.GetPairs();
+		int32 pairCount = m_sweepAndPrune.GetPairCount();
+		for (int32 i = 0; i < pairCount; ++i)
 		{
-			continue;
+			BufferPair(pairs[i].proxyIdA, pairs[i].proxyIdB);
 		}
-
-		// We have to query the tree with the fat AABB so that
-		// we don't fail to create a pair that may touch later.
-		const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
-
-		// Query tree, create pairs and add them pair buffer.
-		m_tree.Query(this, fatAABB);
 	}
 
+	// Perform tree queries for all moving proxies.
+	QueryMoveBuffer();
+
 	// Reset move buffer
 	m_moveCount = 0;
 
@@ -215,10 +462,15 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	while (i < m_pairCount)
 	{
 		b2Pair* primaryPair = m_pairBuffer + i;
-		void* userDataA = m_tree.GetUserData(primaryPair->proxyIdA);
-		void* userDataB = m_tree.GetUserData(primaryPair->proxyIdB);
 
-		callback->AddPair(userDataA, userDataB);
+		// The sort may report pairs that stopped overlapping later on.
+		if (m_pairMethod == e_treeQueries || TestOverlap(primaryPair->proxyIdA, primaryPair->proxyIdB))
+		{
+			void* userDataA = GetUserData(primaryPair->proxyIdA);
+			void* userDataB = GetUserData(primaryPair->proxyIdB);
+
+			callback->AddPair(userDataA, userDataB);
+		}
 		++i;
 
 		// Skip any duplicate pairs.
@@ -235,23 +487,105 @@ void b2BroadPhase::UpdatePairs(T* callback)
 
 	// Try to keep the tree balanced.
 	//m_tree.Rebalance(4);
+
+	// The proxies have been moved for this step, so refresh the wide trees for
+	// the queries made until the next step.
+	if (m_wideTreesEnabled)
+	{
+		for (int32 j = 0; j < e_proxyTypeCount; ++j)
+		{
+			if (m_wideTreeValid[j] == false)
+			{
+				m_wideTrees[j].Build(m_trees[j]);
+				m_wideTreeValid[j] = true;
+			}
+		}
+	}
 }
 
 template <typename T>
 inline void b2BroadPhase::Query(T* callback, const b2AABB& aabb) const
 {
-	m_tree.Query(callback, aabb);
+	b2BroadPhaseQueryWrapper<T> wrapper;
+	wrapper.callback = callback;
+	for (int32 i = 0; i < e_proxyTypeCount; ++i)
+	{
+		wrapper.type = ProxyType(i);
+		if (m_wideTreeValid[i])
+		{
+			m_wideTrees[i].Query(&wrapper, aabb);
+		}
+		else
+		{
+			m_trees[i].Query(&wrapper, aabb);
+		}
+	}
 }
 
 template <typename T>
 inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) const
 {
-	m_tree.RayCast(callback, input);
+	b2BroadPhaseRayCastWrapper<T> wrapper;
+	wrapper.callback = callback;
+	wrapper.maxFraction = input.maxFraction;
+	wrapper.terminated = false;
+
+	b2RayCastInput subInput = input;
+	for (int32 i = 0; i < e_proxyTypeCount && wrapper.terminated == false; ++i)
+	{
+		wrapper.type = ProxyType(i);
+		subInput.maxFraction = wrapper.maxFraction;
+		if (m_wideTreeValid[i])
+		{
+			m_wideTrees[i].RayCast(&wrapper, subInput);
+		}
+		else
+		{
+			m_trees[i].RayCast(&wrapper, subInput);
+		}
+	}
+}
+
+template <typename T>
+inline void b2BroadPhase::RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const
+{
+	b2Assert(0 < count && count <= b2_rayPacketSize);
+
+	b2BroadPhaseRayPacketWrapper<T> wrapper;
+	wrapper.callback = callback;
+	wrapper.activeCount = count;
+
+	b2RayCastInput subInputs[b2_rayPacketSize];
+	for (int32 i = 0; i < count; ++i)
+	{
+		subInputs[i] = inputs[i];
+		wrapper.maxFractions[i] = inputs[i].maxFraction;
+		wrapper.terminated[i] = false;
+	}
+
+	for (int32 i = 0; i < e_proxyTypeCount && wrapper.activeCount > 0; ++i)
+	{
+		wrapper.type = ProxyType(i);
+		for (int32 j = 0; j < count; ++j)
+		{
+			subInputs[j].maxFraction = wrapper.maxFractions[j];
+		}
+		m_trees[i].RayCastPacket(&wrapper, subInputs, count);
+	}
 }
 
 inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
 {
-	m_tree.ShiftOrigin(newOrigin);
+	for (int32 i = 0; i < e_proxyTypeCount; ++i)
+	{
+		m_trees[i].ShiftOrigin(newOrigin);
+		m_wideTreeValid[i] = false;
+	}
+
+	if (m_pairMethod == e_sweepAndPrune)
+	{
+		m_sweepAndPrune.ShiftOrigin(newOrigin);
+	}
 }
 
 #endif
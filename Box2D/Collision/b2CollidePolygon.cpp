@@ -18,41 +18,62 @@
 
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
+#include "Box2D/Common/b2Simd.h"
+
+#if b2_maxPolygonVertices % b2_simdWidth != 0
+#error b2_maxPolygonVertices must be a multiple of b2_simdWidth
+#endif
 
 // Find the max separation between poly1 and poly2 using edge normals from poly1.
+// The edges of poly1 go in SIMD lanes and the vertices of poly2 are broadcast
+// one at a time. Each lane does the same operations as the scalar version.
 static float32 b2FindMaxSeparation(int32* edgeIndex,
 								 const b2PolygonShape* poly1, const b2Transform& xf1,
 								 const b2PolygonShape* poly2, const b2Transform& xf2)
 {
 	int32 count1 = poly1->m_count;
 	int32 count2 = poly2->m_count;
-	const b2Vec2* n1s = poly1->m_normals;
-	const b2Vec2* v1s = poly1->m_vertices;
 	const b2Vec2* v2s = poly2->m_vertices;
 	b2Transform xf = b2MulT(xf2, xf1);
 
-	int32 bestIndex = 0;
-	float32 maxSeparation = -b2_maxFloat;
-	for (int32 i = 0; i < count1; ++i)
-	{
-		// Get poly1 normal in frame2.
-		b2Vec2 n = b2Mul(xf.q, n1s[i]);
-		b2Vec2 v1 = b2Mul(xf, v1s[i]);
+	b2FloatW c = b2SplatW(xf.q.c);
+	b2FloatW s = b2SplatW(xf.q.s);
+	b2FloatW px = b2SplatW(xf.p.x);
+	b2FloatW py = b2SplatW(xf.p.y);
 
-		// Find deepest point for normal i.
-		float32 si = b2_maxFloat;
+	float32 separations[b2_maxPolygonVertices];
+	for (int32 i = 0; i < count1; i += b2_simdWidth)
+	{
+		// Get poly1 normals and vertices in frame2.
+		b2FloatW n1x = b2LoadW(poly1->m_normalX + i);
+		b2FloatW n1y = b2LoadW(poly1->m_normalY + i);
+		b2FloatW nx = c * n1x - s * n1y;
+		b2FloatW ny = s * n1x + c * n1y;
+
+		b2FloatW v1x = b2LoadW(poly1->m_vertexX + i);
+		b2FloatW v1y = b2LoadW(poly1->m_vertexY + i);
+		b2FloatW x1 = (c * v1x - s * v1y) + px;
+		b2FloatW y1 = (s * v1x + c * v1y) + py;
+
+		// Find deepest point for each normal.
+		b2FloatW si = b2SplatW(b2_maxFloat);
 		for (int32 j = 0; j < count2; ++j)
 		{
-			float32 sij = b2Dot(n, v2s[j] - v1);
-			if (sij < si)
-			{
-				si = sij;
-			}
+			b2FloatW dx = b2SplatW(v2s[j].x) - x1;
+			b2FloatW dy = b2SplatW(v2s[j].y) - y1;
+			si = b2MinW(si, nx * dx + ny * dy);
 		}
 
-		if (si > maxSeparation)
+		b2StoreW(separations + i, si);
+	}
+
+	int32 bestIndex = 0;
+	float32 maxSeparation = -b2_maxFloat;
+	for (int32 i = 0; i < count1; ++i)
+	{
+		if (separations[i] > maxSeparation)
 		{
-			maxSeparation = si;
+			maxSeparation = separations[i];
 			bestIndex = i;
 		}
 	}
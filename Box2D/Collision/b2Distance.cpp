@@ -21,9 +21,12 @@
 #include "Box2D/Collision/Shapes/b2EdgeShape.h"
 #include "Box2D/Collision/Shapes/b2ChainShape.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
+#include "Box2D/Common/b2Simd.h"
 
 // GJK using Voronoi regions (Christer Ericson) and Barycentric coordinates.
-int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+
+// The statistics are per thread so that worlds can step on several threads.
+thread_local int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
 
 void b2DistanceProxy::Set(const b2Shape* shape, int32 index)
 {
@@ -441,6 +444,48 @@ void b2Simplex::Solve3()
 	m_count = 3;
 }
 
+// Prepare the output from the final simplex.
+static void b2FinishDistance(b2DistanceOutput* output, b2SimplexCache* cache, const b2DistanceInput* input,
+							 const b2Simplex& simplex, int32 iter)
+{
+	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
+
+	// Prepare output.
+	simplex.GetWitnessPoints(&output->pointA, &output->pointB);
+	output->distance = b2Distance(output->pointA, output->pointB);
+	output->iterations = iter;
+
+	// Cache the simplex.
+	simplex.WriteCache(cache);
+
+	// Apply radii if requested.
+	if (input->useRadii)
+	{
+		float32 rA = input->proxyA.m_radius;
+		float32 rB = input->proxyB.m_radius;
+
+		if (output->distance > rA + rB && output->distance > b2_epsilon)
+		{
+			// Shapes are still no overlapped.
+			// Move the witness points to the outer surface.
+			output->distance -= rA + rB;
+			b2Vec2 normal = output->pointB - output->pointA;
+			normal.Normalize();
+			output->pointA += rA * normal;
+			output->pointB -= rB * normal;
+		}
+		else
+		{
+			// Shapes are overlapped when radii are considered.
+			// Move the witness points to the middle.
+			b2Vec2 p = 0.5f * (output->pointA + output->pointB);
+			output->pointA = p;
+			output->pointB = p;
+			output->distance = 0.0f;
+		}
+	}
+}
+
 void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input)
@@ -550,40 +595,442 @@ void b2Distance(b2DistanceOutput* output,
 		++simplex.m_count;
 	}
 
-	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
+	b2FinishDistance(output, cache, input, simplex, iter);
+}
 
-	// Prepare output.
-	simplex.GetWitnessPoints(&output->pointA, &output->pointB);
-	output->distance = b2Distance(output->pointA, output->pointB);
-	output->iterations = iter;
+// The batched queries run one query per lane. Each lane follows the scalar
+// GJK above operation for operation, so a lane gives bit for bit the result of
+// the scalar call. Branches become blends under a lane mask and a lane that
+// terminates is masked out until the whole group is done. Without SIMD the
+// lanes are plain loops, which lose to the scalar path, so the batch calls just
+// loop over it.
 
-	// Cache the simplex.
-	simplex.WriteCache(cache);
+#if defined(B2_SIMD_AVX) || defined(B2_SIMD_SSE2)
 
-	// Apply radii if requested.
-	if (input->useRadii)
+// A simplex vertex of b2_simdWidth queries. Indices are held as floats. The
+// support points are not kept: they are recomputed from the indices at the end,
+// which gives the same bits and halves the blending.
+struct b2SimplexVertexW
+{
+	b2FloatW wx, wy;
+	b2FloatW a;
+	b2FloatW indexA, indexB;
+};
+
+static inline void b2BlendVertex(b2SimplexVertexW* v, const b2SimplexVertexW& u, b2FloatW mask)
+{
+	v->wx = b2BlendW(v->wx, u.wx, mask);
+	v->wy = b2BlendW(v->wy, u.wy, mask);
+	v->a = b2BlendW(v->a, u.a, mask);
+	v->indexA = b2BlendW(v->indexA, u.indexA, mask);
+	v->indexB = b2BlendW(v->indexB, u.indexB, mask);
+}
+
+// Blend the barycentric coordinates of a segment into the masked lanes.
+static inline void b2SolveSegmentW(b2FloatW* a1, b2FloatW* a2, b2FloatW d_1, b2FloatW d_2, b2FloatW mask)
+{
+	b2FloatW inv_d = b2SplatW(1.0f) / (d_1 + d_2);
+	*a1 = b2BlendW(*a1, d_1 * inv_d, mask);
+	*a2 = b2BlendW(*a2, d_2 * inv_d, mask);
+}
+
+// The vertices of the proxies of one side, transposed so that vertex i of
+// lane j is at i * b2_simdWidth + j. Short proxies are padded with their first
+// vertex, which can never win the strict comparison of the support search.
+struct b2ProxiesW
+{
+	void Set(const b2DistanceProxy* const* proxies)
 	{
-		float32 rA = proxyA->m_radius;
-		float32 rB = proxyB->m_radius;
+		m_count = 0;
+		for (int32 j = 0; j < b2_simdWidth; ++j)
+		{
+			m_count = b2Max(m_count, proxies[j]->m_count);
+		}
+		b2Assert(m_count <= b2_maxPolygonVertices);
 
-		if (output->distance > rA + rB && output->distance > b2_epsilon)
+		for (int32 j = 0; j < b2_simdWidth; ++j)
 		{
-			// Shapes are still no overlapped.
-			// Move the witness points to the outer surface.
-			output->distance -= rA + rB;
-			b2Vec2 normal = output->pointB - output->pointA;
-			normal.Normalize();
-			output->pointA += rA * normal;
-			output->pointB -= rB * normal;
+			const b2DistanceProxy* proxy = proxies[j];
+			for (int32 i = 0; i < m_count; ++i)
+			{
+				const b2Vec2& v = proxy->m_vertices[i < proxy->m_count ? i : 0];
+				m_x[i * b2_simdWidth + j] = v.x;
+				m_y[i * b2_simdWidth + j] = v.y;
+			}
 		}
-		else
+	}
+
+	// Find the support vertex in direction d and transform it. xf holds p.x,
+	// p.y, q.s and q.c.
+	void GetSupport(b2FloatW* index, b2FloatW* wx, b2FloatW* wy, b2FloatW dx, b2FloatW dy,
+					const b2FloatW* xf) const
+	{
+		b2FloatW bestX = b2LoadW(m_x);
+		b2FloatW bestY = b2LoadW(m_y);
+		b2FloatW bestIndex = b2ZeroW();
+		b2FloatW bestValue = bestX * dx + bestY * dy;
+		for (int32 i = 1; i < m_count; ++i)
 		{
-			// Shapes are overlapped when radii are considered.
-			// Move the witness points to the middle.
-			b2Vec2 p = 0.5f * (output->pointA + output->pointB);
-			output->pointA = p;
-			output->pointB = p;
-			output->distance = 0.0f;
+			b2FloatW x = b2LoadW(m_x + i * b2_simdWidth);
+			b2FloatW y = b2LoadW(m_y + i * b2_simdWidth);
+			b2FloatW value = x * dx + y * dy;
+			b2FloatW better = b2GreaterW(value, bestValue);
+			bestX = b2BlendW(bestX, x, better);
+			bestY = b2BlendW(bestY, y, better);
+			bestIndex = b2BlendW(bestIndex, b2SplatW(float32(i)), better);
+			bestValue = b2BlendW(bestValue, value, better);
+		}
+
+		*index = bestIndex;
+		*wx = (xf[3] * bestX - xf[2] * bestY) + xf[0];
+		*wy = (xf[2] * bestX + xf[3] * bestY) + xf[1];
+	}
+
+	float32 m_x[b2_maxPolygonVertices * b2_simdWidth];
+	float32 m_y[b2_maxPolygonVertices * b2_simdWidth];
+	int32 m_count;
+};
+
+// Run up to b2_simdWidth queries. The lanes past count repeat the first query
+// and their results are dropped.
+static void b2DistanceW(b2DistanceOutput* outputs, b2SimplexCache* caches, const b2DistanceInput* inputs,
+						int32 count)
+{
+	b2_gjkCalls += count;
+
+	const b2DistanceInput* laneInputs[b2_simdWidth];
+	const b2DistanceProxy* proxiesA[b2_simdWidth];
+	const b2DistanceProxy* proxiesB[b2_simdWidth];
+	b2Simplex simplices[b2_simdWidth];
+	for (int32 j = 0; j < b2_simdWidth; ++j)
+	{
+		int32 k = j < count ? j : 0;
+		const b2DistanceInput* input = inputs + k;
+		laneInputs[j] = input;
+		proxiesA[j] = &input->proxyA;
+		proxiesB[j] = &input->proxyB;
+		simplices[j].ReadCache(caches + k, &input->proxyA, input->transformA, &input->proxyB, input->transformB);
+	}
+
+	b2ProxiesW proxyA, proxyB;
+	proxyA.Set(proxiesA);
+	proxyB.Set(proxiesB);
+
+	// Transpose the transforms and the simplices. The vertices past a simplex
+	// are zeroed, since the lane still computes with them and garbage could
+	// hold slow denormals.
+	b2FloatW xfA[4], xfB[4];
+	b2SimplexVertexW vertices[3];
+	b2FloatW simplexCount;
+	{
+		float32 lanes[9][b2_simdWidth];
+		for (int32 j = 0; j < b2_simdWidth; ++j)
+		{
+			const b2Transform& transformA = laneInputs[j]->transformA;
+			const b2Transform& transformB = laneInputs[j]->transformB;
+			lanes[0][j] = transformA.p.x;
+			lanes[1][j] = transformA.p.y;
+			lanes[2][j] = transformA.q.s;
+			lanes[3][j] = transformA.q.c;
+			lanes[4][j] = transformB.p.x;
+			lanes[5][j] = transformB.p.y;
+			lanes[6][j] = transformB.q.s;
+			lanes[7][j] = transformB.q.c;
+			lanes[8][j] = float32(simplices[j].m_count);
+		}
+
+		for (int32 i = 0; i < 4; ++i)
+		{
+			xfA[i] = b2LoadW(lanes[i]);
+			xfB[i] = b2LoadW(lanes[4 + i]);
+		}
+		simplexCount = b2LoadW(lanes[8]);
+
+		for (int32 i = 0; i < 3; ++i)
+		{
+			for (int32 j = 0; j < b2_simdWidth; ++j)
+			{
+				const b2SimplexVertex* v = &simplices[j].m_v1 + i;
+				bool used = i < simplices[j].m_count;
+				lanes[0][j] = used ? v->w.x : 0.0f;
+				lanes[1][j] = used ? v->w.y : 0.0f;
+				lanes[2][j] = used ? v->a : 0.0f;
+				lanes[3][j] = used ? float32(v->indexA) : 0.0f;
+				lanes[4][j] = used ? float32(v->indexB) : 0.0f;
+			}
+
+			b2SimplexVertexW* v = vertices + i;
+			v->wx = b2LoadW(lanes[0]);
+			v->wy = b2LoadW(lanes[1]);
+			v->a = b2LoadW(lanes[2]);
+			v->indexA = b2LoadW(lanes[3]);
+			v->indexB = b2LoadW(lanes[4]);
+		}
+	}
+
+	const b2FloatW zero = b2ZeroW();
+	const b2FloatW one = b2SplatW(1.0f);
+	const b2FloatW two = b2SplatW(2.0f);
+	const b2FloatW three = b2SplatW(3.0f);
+	const int32 k_maxIters = 20;
+
+	b2SimplexVertexW& v1 = vertices[0];
+	b2SimplexVertexW& v2 = vertices[1];
+	b2SimplexVertexW& v3 = vertices[2];
+
+	// Main iteration loop. Every active lane takes a support point in every
+	// iteration, so the iteration count is shared.
+	b2FloatW active = b2EqualW(zero, zero);
+	b2FloatW iters = zero;
+	int32 iter = 0;
+	while (iter < k_maxIters)
+	{
+		// Copy simplex so we can identify duplicates.
+		b2FloatW saveCount = simplexCount;
+		b2FloatW saveA[3], saveB[3];
+		for (int32 i = 0; i < 3; ++i)
+		{
+			saveA[i] = vertices[i].indexA;
+			saveB[i] = vertices[i].indexB;
+		}
+
+		// Solve2
+		b2FloatW mask = b2AndW(active, b2EqualW(simplexCount, two));
+		if (b2AnyW(mask))
+		{
+			b2FloatW e12x = v2.wx - v1.wx;
+			b2FloatW e12y = v2.wy - v1.wy;
+
+			// w1 region
+			b2FloatW d12_2 = -(v1.wx * e12x + v1.wy * e12y);
+			b2FloatW region = b2AndW(mask, b2GreaterEqualW(zero, d12_2));
+			v1.a = b2BlendW(v1.a, one, region);
+			simplexCount = b2BlendW(simplexCount, one, region);
+			mask = b2AndNotW(mask, region);
+
+			// w2 region
+			b2FloatW d12_1 = v2.wx * e12x + v2.wy * e12y;
+			region = b2AndW(mask, b2GreaterEqualW(zero, d12_1));
+			v2.a = b2BlendW(v2.a, one, region);
+			simplexCount = b2BlendW(simplexCount, one, region);
+			b2BlendVertex(&v1, v2, region);
+			mask = b2AndNotW(mask, region);
+
+			// Must be in e12 region.
+			b2SolveSegmentW(&v1.a, &v2.a, d12_1, d12_2, mask);
+		}
+
+		// Solve3
+		mask = b2AndW(active, b2EqualW(simplexCount, three));
+		if (b2AnyW(mask))
+		{
+			b2FloatW e12x = v2.wx - v1.wx;
+			b2FloatW e12y = v2.wy - v1.wy;
+			b2FloatW d12_1 = v2.wx * e12x + v2.wy * e12y;
+			b2FloatW d12_2 = -(v1.wx * e12x + v1.wy * e12y);
+
+			b2FloatW e13x = v3.wx - v1.wx;
+			b2FloatW e13y = v3.wy - v1.wy;
+			b2FloatW d13_1 = v3.wx * e13x + v3.wy * e13y;
+			b2FloatW d13_2 = -(v1.wx * e13x + v1.wy * e13y);
+
+			b2FloatW e23x = v3.wx - v2.wx;
+			b2FloatW e23y = v3.wy - v2.wy;
+			b2FloatW d23_1 = v3.wx * e23x + v3.wy * e23y;
+			b2FloatW d23_2 = -(v2.wx * e23x + v2.wy * e23y);
+
+			b2FloatW n123 = e12x * e13y - e12y * e13x;
+			b2FloatW d123_1 = n123 * (v2.wx * v3.wy - v2.wy * v3.wx);
+			b2FloatW d123_2 = n123 * (v3.wx * v1.wy - v3.wy * v1.wx);
+			b2FloatW d123_3 = n123 * (v1.wx * v2.wy - v1.wy * v2.wx);
+
+			// w1 region
+			b2FloatW region = b2AndW(mask, b2AndW(b2GreaterEqualW(zero, d12_2), b2GreaterEqualW(zero, d13_2)));
+			v1.a = b2BlendW(v1.a, one, region);
+			simplexCount = b2BlendW(simplexCount, one, region);
+			mask = b2AndNotW(mask, region);
+
+			// e12
+			region = b2AndW(b2GreaterW(d12_1, zero), b2GreaterW(d12_2, zero));
+			region = b2AndW(mask, b2AndW(region, b2GreaterEqualW(zero, d123_3)));
+			b2SolveSegmentW(&v1.a, &v2.a, d12_1, d12_2, region);
+			simplexCount = b2BlendW(simplexCount, two, region);
+			mask = b2AndNotW(mask, region);
+
+			// e13
+			region = b2AndW(b2GreaterW(d13_1, zero), b2GreaterW(d13_2, zero));
+			region = b2AndW(mask, b2AndW(region, b2GreaterEqualW(zero, d123_2)));
+			b2SolveSegmentW(&v1.a, &v3.a, d13_1, d13_2, region);
+			simplexCount = b2BlendW(simplexCount, two, region);
+			b2BlendVertex(&v2, v3, region);
+			mask = b2AndNotW(mask, region);
+
+			// w2 region
+			region = b2AndW(mask, b2AndW(b2GreaterEqualW(zero, d12_1), b2GreaterEqualW(zero, d23_2)));
+			v2.a = b2BlendW(v2.a, one, region);
+			simplexCount = b2BlendW(simplexCount, one, region);
+			b2BlendVertex(&v1, v2, region);
+			mask = b2AndNotW(mask, region);
+
+			// w3 region
+			region = b2AndW(mask, b2AndW(b2GreaterEqualW(zero, d13_1), b2GreaterEqualW(zero, d23_1)));
+			v3.a = b2BlendW(v3.a, one, region);
+			simplexCount = b2BlendW(simplexCount, one, region);
+			b2BlendVertex(&v1, v3, region);
+			mask = b2AndNotW(mask, region);
+
+			// e23
+			region = b2AndW(b2GreaterW(d23_1, zero), b2GreaterW(d23_2, zero));
+			region = b2AndW(mask, b2AndW(region, b2GreaterEqualW(zero, d123_1)));
+			b2SolveSegmentW(&v2.a, &v3.a, d23_1, d23_2, region);
+			simplexCount = b2BlendW(simplexCount, two, region);
+			b2BlendVertex(&v1, v3, region);
+			mask = b2AndNotW(mask, region);
+
+			// Must be in triangle123
+			b2FloatW inv_d123 = one / (d123_1 + d123_2 + d123_3);
+			v1.a = b2BlendW(v1.a, d123_1 * inv_d123, mask);
+			v2.a = b2BlendW(v2.a, d123_2 * inv_d123, mask);
+			v3.a = b2BlendW(v3.a, d123_3 * inv_d123, mask);
+		}
+
+		// If we have 3 points, then the origin is in the corresponding triangle.
+		active = b2AndNotW(active, b2EqualW(simplexCount, three));
+
+		// Get search direction.
+		b2FloatW e12x = v2.wx - v1.wx;
+		b2FloatW e12y = v2.wy - v1.wy;
+		b2FloatW sgn = e12x * -v1.wy - e12y * -v1.wx;
+		b2FloatW left = b2GreaterW(sgn, zero);
+		b2FloatW segment = b2EqualW(simplexCount, two);
+		b2FloatW dx = b2BlendW(-v1.wx, b2BlendW(e12y, -e12y, left), segment);
+		b2FloatW dy = b2BlendW(-v1.wy, b2BlendW(-e12x, e12x, left), segment);
+
+		// Ensure the search direction is numerically fit.
+		b2FloatW lengthSquared = dx * dx + dy * dy;
+		active = b2AndNotW(active, b2GreaterW(b2SplatW(b2_epsilon * b2_epsilon), lengthSquared));
+		if (b2AnyW(active) == false)
+		{
+			break;
+		}
+
+		// Compute a tentative new simplex vertex using support points.
+		b2SimplexVertexW vertex;
+		b2FloatW wAx, wAy, wBx, wBy;
+		b2FloatW ax = xfA[3] * -dx + xfA[2] * -dy;
+		b2FloatW ay = -xfA[2] * -dx + xfA[3] * -dy;
+		proxyA.GetSupport(&vertex.indexA, &wAx, &wAy, ax, ay, xfA);
+		b2FloatW bx = xfB[3] * dx + xfB[2] * dy;
+		b2FloatW by = -xfB[2] * dx + xfB[3] * dy;
+		proxyB.GetSupport(&vertex.indexB, &wBx, &wBy, bx, by, xfB);
+		vertex.wx = wBx - wAx;
+		vertex.wy = wBy - wAy;
+
+		// The new vertex goes to the slot past the simplex. The slot keeps its
+		// barycentric coordinate, as in the scalar path.
+		for (int32 i = 0; i < 3; ++i)
+		{
+			b2FloatW slot = b2AndW(active, b2EqualW(simplexCount, b2SplatW(float32(i))));
+			vertex.a = vertices[i].a;
+			b2BlendVertex(vertices + i, vertex, slot);
+		}
+
+		// Iteration count is equated to the number of support point calls.
+		++iter;
+		iters = b2BlendW(iters, iters + one, active);
+
+		// Check for duplicate support points. This is the main termination criteria.
+		b2FloatW duplicate = zero;
+		for (int32 i = 0; i < 3; ++i)
+		{
+			b2FloatW same = b2AndW(b2EqualW(vertex.indexA, saveA[i]), b2EqualW(vertex.indexB, saveB[i]));
+			duplicate = b2OrW(duplicate, b2AndW(same, b2GreaterW(saveCount, b2SplatW(float32(i)))));
+		}
+		active = b2AndNotW(active, duplicate);
+
+		// New vertex is ok and needed.
+		simplexCount = b2BlendW(simplexCount, simplexCount + one, active);
+		if (b2AnyW(active) == false)
+		{
+			break;
+		}
+	}
+
+	// Transpose back and finish each query like the scalar path.
+	float32 lanes[5][b2_simdWidth];
+	for (int32 i = 0; i < 3; ++i)
+	{
+		const b2SimplexVertexW* v = vertices + i;
+		b2StoreW(lanes[0], v->wx);
+		b2StoreW(lanes[1], v->wy);
+		b2StoreW(lanes[2], v->a);
+		b2StoreW(lanes[3], v->indexA);
+		b2StoreW(lanes[4], v->indexB);
+		for (int32 j = 0; j < count; ++j)
+		{
+			b2SimplexVertex* u = &simplices[j].m_v1 + i;
+			u->w.Set(lanes[0][j], lanes[1][j]);
+			u->a = lanes[2][j];
+			u->indexA = int32(lanes[3][j]);
+			u->indexB = int32(lanes[4][j]);
+		}
+	}
+
+	b2StoreW(lanes[0], simplexCount);
+	b2StoreW(lanes[1], iters);
+	for (int32 j = 0; j < count; ++j)
+	{
+		const b2DistanceInput* input = inputs + j;
+		b2Simplex* simplex = simplices + j;
+		simplex->m_count = int32(lanes[0][j]);
+		b2SimplexVertex* u = &simplex->m_v1;
+		for (int32 i = 0; i < simplex->m_count; ++i)
+		{
+			u[i].wA = b2Mul(input->transformA, input->proxyA.GetVertex(u[i].indexA));
+			u[i].wB = b2Mul(input->transformB, input->proxyB.GetVertex(u[i].indexB));
+		}
+
+		int32 laneIters = int32(lanes[1][j]);
+		b2_gjkIters += laneIters;
+		b2FinishDistance(outputs + j, caches + j, input, *simplex, laneIters);
+	}
+}
+
+#endif
+
+void b2Distance(b2DistanceOutput* outputs, b2SimplexCache* caches, const b2DistanceInput* inputs, int32 count)
+{
+#if defined(B2_SIMD_AVX) || defined(B2_SIMD_SSE2)
+	for (int32 i = 0; i < count; i += b2_simdWidth)
+	{
+		b2DistanceW(outputs + i, caches + i, inputs + i, b2Min(count - i, b2_simdWidth));
+	}
+#else
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Distance(outputs + i, caches + i, inputs + i);
+	}
+#endif
+}
+
+void b2TestOverlap(bool* overlaps, const b2DistanceInput* inputs, int32 count)
+{
+	b2SimplexCache caches[b2_simdWidth];
+	b2DistanceOutput outputs[b2_simdWidth];
+	for (int32 i = 0; i < count; i += b2_simdWidth)
+	{
+		int32 n = b2Min(count - i, b2_simdWidth);
+		for (int32 j = 0; j < n; ++j)
+		{
+			b2Assert(inputs[i + j].useRadii);
+			caches[j].count = 0;
+		}
+
+		b2Distance(outputs, caches, inputs + i, n);
+
+		for (int32 j = 0; j < n; ++j)
+		{
+			overlaps[i + j] = outputs[j].distance < 10.0f * b2_epsilon;
 		}
 	}
 }
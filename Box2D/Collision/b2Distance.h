@@ -90,6 +90,16 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache, 
 				const b2DistanceInput* input);
 
+/// Compute the closest points of count shape pairs. The queries run together in
+/// SIMD lanes and each gives the same result as the single b2Distance.
+void b2Distance(b2DistanceOutput* outputs,
+				b2SimplexCache* caches,
+				const b2DistanceInput* inputs, int32 count);
+
+/// Test count shape pairs for overlap, as b2TestOverlap does for shapes. The
+/// inputs must use the radii.
+void b2TestOverlap(bool* overlaps, const b2DistanceInput* inputs, int32 count);
+
 
 //////////////////////////////////////////////////////////////////////////
 
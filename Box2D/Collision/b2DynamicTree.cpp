@@ -118,6 +118,24 @@ int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 	return proxyId;
 }
 
+void b2DynamicTree::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = AllocateNode();
+		m_nodes[proxyId].aabb.lowerBound = aabbs[i].lowerBound - r;
+		m_nodes[proxyId].aabb.upperBound = aabbs[i].upperBound + r;
+		m_nodes[proxyId].userData = userData[i];
+		m_nodes[proxyId].height = 0;
+		proxyIds[i] = proxyId;
+	}
+
+	m_insertionCount += count;
+
+	RebuildTopDown();
+}
+
 void b2DynamicTree::DestroyProxy(int32 proxyId)
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -769,6 +787,328 @@ void b2DynamicTree::RebuildBottomUp()
 	Validate();
 }
 
+// The number of buckets the centers are sorted into when looking for a split.
+#define b2_treeBinCount 12
+
+struct b2TreeBin
+{
+	b2AABB aabb;
+	int32 count;
+};
+
+inline int32 b2FindBin(float32 x, float32 lower, float32 scale)
+{
+	return b2Min(int32((x - lower) * scale), b2_treeBinCount - 1);
+}
+
+// Reorder the leaves so that the first half has the lower centers along the axis.
+// This is a quickselect for the median. The size of the first half is returned.
+static int32 b2SplitAtMedian(int32* leaves, b2Vec2* centers, int32 count, int32 axis)
+{
+	int32 median = count / 2;
+	int32 left = 0;
+	int32 right = count - 1;
+	while (left < right)
+	{
+		float32 pivot = centers[(left + right) / 2](axis);
+		int32 i = left;
+		int32 j = right;
+		while (i <= j)
+		{
+			while (centers[i](axis) < pivot)
+			{
+				++i;
+			}
+			while (centers[j](axis) > pivot)
+			{
+				--j;
+			}
+			if (i <= j)
+			{
+				b2Swap(leaves[i], leaves[j]);
+				b2Swap(centers[i], centers[j]);
+				++i;
+				--j;
+			}
+		}
+
+		if (median <= j)
+		{
+			right = j;
+		}
+		else if (median >= i)
+		{
+			left = i;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return median;
+}
+
+// Split the leaves in two with the surface area heuristic. The centers are binned
+// along the longest axis of their bounds and the cheapest split between bins wins.
+// The leaves are reordered in place and the size of the first group is returned.
+static int32 b2PartitionLeaves(const b2TreeNode* nodes, int32* leaves, b2Vec2* centers, int32 count)
+{
+	b2Assert(count > 1);
+
+	b2Vec2 lower = centers[0];
+	b2Vec2 upper = centers[0];
+	for (int32 i = 1; i < count; ++i)
+	{
+		lower = b2Min(lower, centers[i]);
+		upper = b2Max(upper, centers[i]);
+	}
+
+	b2Vec2 d = upper - lower;
+	int32 axis = d.x >= d.y ? 0 : 1;
+	if (d(axis) < b2_epsilon)
+	{
+		// The centers (nearly) coincide. Binning would divide by a vanishing
+		// extent, so split at the median instead.
+		return b2SplitAtMedian(leaves, centers, count, axis);
+	}
+
+	float32 lowerBound = lower(axis);
+	float32 scale = b2_treeBinCount / d(axis);
+
+	b2TreeBin bins[b2_treeBinCount];
+	for (int32 i = 0; i < b2_treeBinCount; ++i)
+	{
+		bins[i].count = 0;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2TreeBin* bin = bins + b2FindBin(centers[i](axis), lowerBound, scale);
+		const b2AABB& aabb = nodes[leaves[i]].aabb;
+		if (bin->count == 0)
+		{
+			bin->aabb = aabb;
+		}
+		else
+		{
+			bin->aabb.Combine(aabb);
+		}
+		++bin->count;
+	}
+
+	// Sweep from the right to get the cost of the upper group for every split.
+	float32 rightCosts[b2_treeBinCount - 1];
+	int32 rightCounts[b2_treeBinCount - 1];
+	b2AABB aabb;
+	int32 n = 0;
+	for (int32 i = b2_treeBinCount - 1; i > 0; --i)
+	{
+		if (bins[i].count > 0)
+		{
+			if (n == 0)
+			{
+				aabb = bins[i].aabb;
+			}
+			else
+			{
+				aabb.Combine(bins[i].aabb);
+			}
+			n += bins[i].count;
+		}
+		rightCounts[i - 1] = n;
+		rightCosts[i - 1] = n > 0 ? n * aabb.GetPerimeter() : 0.0f;
+	}
+
+	// Sweep from the left and keep the cheapest split. The first and last bins
+	// are never empty, so some split always has leaves on both sides.
+	float32 minCost = b2_maxFloat;
+	int32 splitBin = 0;
+	n = 0;
+	for (int32 i = 0; i < b2_treeBinCount - 1; ++i)
+	{
+		if (bins[i].count > 0)
+		{
+			if (n == 0)
+			{
+				aabb = bins[i].aabb;
+			}
+			else
+			{
+				aabb.Combine(bins[i].aabb);
+			}
+			n += bins[i].count;
+		}
+
+		if (n == 0 || rightCounts[i] == 0)
+		{
+			continue;
+		}
+
+		float32 cost = n * aabb.GetPerimeter() + rightCosts[i];
+		if (cost < minCost)
+		{
+			minCost = cost;
+			splitBin = i;
+		}
+	}
+
+	int32 i = 0;
+	int32 j = count;
+	while (i < j)
+	{
+		if (b2FindBin(centers[i](axis), lowerBound, scale) <= splitBin)
+		{
+			++i;
+		}
+		else
+		{
+			--j;
+			b2Swap(leaves[i], leaves[j]);
+			b2Swap(centers[i], centers[j]);
+		}
+	}
+
+	b2Assert(0 < i && i < count);
+	return i;
+}
+
+struct b2TreeBuildItem
+{
+	int32 parent;
+	int32 childIndex;
+	int32 begin;
+	int32 count;
+};
+
+// Build a subtree over the given leaves and return its root. Internal nodes are
+// allocated from the pool. The leaves are reordered.
+int32 b2DynamicTree::BuildTopDown(int32* leaves, int32 count)
+{
+	b2Assert(count > 0);
+
+	if (count == 1)
+	{
+		m_nodes[leaves[0]].parent = b2_nullNode;
+		return leaves[0];
+	}
+
+	b2Vec2* centers = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+	for (int32 i = 0; i < count; ++i)
+	{
+		centers[i] = m_nodes[leaves[i]].aabb.GetCenter();
+	}
+
+	// A binary tree over count leaves has count - 1 internal nodes.
+	int32* internalNodes = (int32*)b2Alloc((count - 1) * sizeof(int32));
+	int32 internalCount = 0;
+
+	int32 root = b2_nullNode;
+
+	b2GrowableStack<b2TreeBuildItem, 256> stack;
+	b2TreeBuildItem item;
+	item.parent = b2_nullNode;
+	item.childIndex = 0;
+	item.begin = 0;
+	item.count = count;
+	stack.Push(item);
+
+	while (stack.GetCount() > 0)
+	{
+		item = stack.Pop();
+
+		int32 nodeId;
+		if (item.count == 1)
+		{
+			nodeId = leaves[item.begin];
+		}
+		else
+		{
+			nodeId = AllocateNode();
+			internalNodes[internalCount] = nodeId;
+			++internalCount;
+
+			int32 split = b2PartitionLeaves(m_nodes, leaves + item.begin, centers + item.begin, item.count);
+
+			b2TreeBuildItem child;
+			child.parent = nodeId;
+			child.childIndex = 2;
+			child.begin = item.begin + split;
+			child.count = item.count - split;
+			stack.Push(child);
+
+			child.childIndex = 1;
+			child.begin = item.begin;
+			child.count = split;
+			stack.Push(child);
+		}
+
+		m_nodes[nodeId].parent = item.parent;
+		if (item.parent == b2_nullNode)
+		{
+			root = nodeId;
+		}
+		else if (item.childIndex == 1)
+		{
+			m_nodes[item.parent].child1 = nodeId;
+		}
+		else
+		{
+			m_nodes[item.parent].child2 = nodeId;
+		}
+	}
+
+	b2Assert(internalCount == count - 1);
+
+	// Parents were allocated before their children, so walking the internal
+	// nodes backwards fits every child before its parent.
+	for (int32 i = internalCount - 1; i >= 0; --i)
+	{
+		b2TreeNode* node = m_nodes + internalNodes[i];
+		const b2TreeNode* child1 = m_nodes + node->child1;
+		const b2TreeNode* child2 = m_nodes + node->child2;
+		node->aabb.Combine(child1->aabb, child2->aabb);
+		node->height = 1 + b2Max(child1->height, child2->height);
+	}
+
+	b2Free(internalNodes);
+	b2Free(centers);
+
+	return root;
+}
+
+void b2DynamicTree::RebuildTopDown()
+{
+	int32* leaves = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest. The same number of internal nodes is
+	// allocated again, so the free list is left as it was.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			leaves[count] = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	m_root = count > 0 ? BuildTopDown(leaves, count) : b2_nullNode;
+	b2Free(leaves);
+
+	Validate();
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
@@ -778,3 +1118,20 @@ void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 		m_nodes[i].aabb.upperBound -= newOrigin;
 	}
 }
+
+void b2DynamicTree::CopyFrom(const b2DynamicTree& other)
+{
+	if (m_nodeCapacity != other.m_nodeCapacity)
+	{
+		b2Free(m_nodes);
+		m_nodeCapacity = other.m_nodeCapacity;
+		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	}
+
+	memcpy(m_nodes, other.m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+	m_root = other.m_root;
+	m_nodeCount = other.m_nodeCount;
+	m_freeList = other.m_freeList;
+	m_path = other.m_path;
+	m_insertionCount = other.m_insertionCount;
+}
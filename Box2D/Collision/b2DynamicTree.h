@@ -21,9 +21,13 @@
 
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Common/b2GrowableStack.h"
+#include "Box2D/Common/b2Simd.h"
 
 #define b2_nullNode (-1)
 
+/// The most rays in a packet for b2DynamicTree::RayCastPacket.
+#define b2_rayPacketSize 4
+
 /// A node in the dynamic tree. The client does not interact with this directly.
 struct b2TreeNode
 {
@@ -70,6 +74,11 @@ public:
 	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create many proxies at once. Provide tight fitting AABBs and userData pointers.
+	/// The ids are written to proxyIds. The tree is rebuilt with RebuildTopDown, which
+	/// is faster than inserting the proxies one by one and gives a better tree.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
@@ -101,6 +110,14 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
+	/// Ray-cast a packet of up to b2_rayPacketSize rays. Each node is tested against
+	/// all rays at once, which pays off when the rays are close together, such as a fan
+	/// cast from one point. Every ray visits the same proxies as with RayCast.
+	/// @param callback called as RayCastCallback(input, proxyId, rayIndex). The return
+	/// value clips or terminates that ray only, as in RayCast.
+	template <typename T>
+	void RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const;
+
 	/// Validate this tree. For testing.
 	void Validate() const;
 
@@ -118,13 +135,23 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Build a good tree from the current leaves in O(N log N) time, splitting
+	/// top down with a binned surface area heuristic. Proxy ids are preserved.
+	void RebuildTopDown();
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Make this tree an exact copy of another tree, including the node pool
+	/// layout and free list. Proxy ids and user data are preserved.
+	void CopyFrom(const b2DynamicTree& other);
+
 private:
 
+	friend class b2WideTree;
+
 	int32 AllocateNode();
 	void FreeNode(int32 node);
 
@@ -133,6 +160,8 @@ private:
 
 	int32 Balance(int32 index);
 
+	int32 BuildTopDown(int32* leaves, int32 count);
+
 	int32 ComputeHeight() const;
 	int32 ComputeHeight(int32 nodeId) const;
 
@@ -286,4 +315,148 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 	}
 }
 
+template <typename T>
+inline void b2DynamicTree::RayCastPacket(T* callback, const b2RayCastInput* inputs, int32 count) const
+{
+	b2Assert(0 < count && count <= b2_rayPacketSize);
+
+	// The rays are kept in lanes. Unused lanes are never active.
+	float32 p1X[4], p1Y[4], vX[4], vY[4], absVX[4], absVY[4];
+	float32 lowerX[4], lowerY[4], upperX[4], upperY[4];
+	float32 maxFractions[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		const b2RayCastInput& input = inputs[b2Min(i, count - 1)];
+		b2Vec2 p1 = input.p1;
+		b2Vec2 p2 = input.p2;
+		b2Vec2 r = p2 - p1;
+		b2Assert(r.LengthSquared() > 0.0f);
+		r.Normalize();
+
+		// v is perpendicular to the segment.
+		b2Vec2 v = b2Cross(1.0f, r);
+		p1X[i] = p1.x;
+		p1Y[i] = p1.y;
+		vX[i] = v.x;
+		vY[i] = v.y;
+		absVX[i] = b2Abs(v.x);
+		absVY[i] = b2Abs(v.y);
+
+		// Build a bounding box for the segment.
+		maxFractions[i] = input.maxFraction;
+		b2Vec2 t = p1 + input.maxFraction * (p2 - p1);
+		lowerX[i] = b2Min(p1.x, t.x);
+		lowerY[i] = b2Min(p1.y, t.y);
+		upperX[i] = b2Max(p1.x, t.x);
+		upperY[i] = b2Max(p1.y, t.y);
+	}
+
+	b2Float4 p1XW = b2Load4(p1X);
+	b2Float4 p1YW = b2Load4(p1Y);
+	b2Float4 vXW = b2Load4(vX);
+	b2Float4 vYW = b2Load4(vY);
+	b2Float4 absVXW = b2Load4(absVX);
+	b2Float4 absVYW = b2Load4(absVY);
+	b2Float4 lowerXW = b2Load4(lowerX);
+	b2Float4 lowerYW = b2Load4(lowerY);
+	b2Float4 upperXW = b2Load4(upperX);
+	b2Float4 upperYW = b2Load4(upperY);
+	b2Float4 zero = b2Splat4(0.0f);
+
+	int32 active = (1 << count) - 1;
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		if (nodeId == b2_nullNode)
+		{
+			continue;
+		}
+
+		const b2TreeNode* node = m_nodes + nodeId;
+
+		int32 mask = active;
+		mask &= b2LessEqual4(b2Splat4(node->aabb.lowerBound.x), upperXW);
+		mask &= b2LessEqual4(b2Splat4(node->aabb.lowerBound.y), upperYW);
+		mask &= b2LessEqual4(lowerXW, b2Splat4(node->aabb.upperBound.x));
+		mask &= b2LessEqual4(lowerYW, b2Splat4(node->aabb.upperBound.y));
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		// Separating axis for segment (Gino, p80).
+		// |dot(v, p1 - c)| > dot(|v|, h)
+		b2Vec2 c = node->aabb.GetCenter();
+		b2Vec2 h = node->aabb.GetExtents();
+		b2Float4 dX = p1XW - b2Splat4(c.x);
+		b2Float4 dY = p1YW - b2Splat4(c.y);
+		b2Float4 separation = b2Abs4(vXW * dX + vYW * dY) - (absVXW * b2Splat4(h.x) + absVYW * b2Splat4(h.y));
+		mask &= b2LessEqual4(separation, zero);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf() == false)
+		{
+			stack.Push(node->child1);
+			stack.Push(node->child2);
+			continue;
+		}
+
+		bool clipped = false;
+		for (int32 i = 0; i < count; ++i)
+		{
+			if ((mask & (1 << i)) == 0)
+			{
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = inputs[i].p1;
+			subInput.p2 = inputs[i].p2;
+			subInput.maxFraction = maxFractions[i];
+
+			float32 value = callback->RayCastCallback(subInput, nodeId, i);
+
+			if (value == 0.0f)
+			{
+				// The client has terminated this ray.
+				active &= ~(1 << i);
+				continue;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFractions[i] = value;
+				b2Vec2 p1 = subInput.p1;
+				b2Vec2 t = p1 + value * (subInput.p2 - p1);
+				lowerX[i] = b2Min(p1.x, t.x);
+				lowerY[i] = b2Min(p1.y, t.y);
+				upperX[i] = b2Max(p1.x, t.x);
+				upperY[i] = b2Max(p1.y, t.y);
+				clipped = true;
+			}
+		}
+
+		if (active == 0)
+		{
+			return;
+		}
+
+		if (clipped)
+		{
+			lowerXW = b2Load4(lowerX);
+			lowerYW = b2Load4(lowerY);
+			upperXW = b2Load4(upperX);
+			upperYW = b2Load4(upperY);
+		}
+	}
+}
+
 #endif
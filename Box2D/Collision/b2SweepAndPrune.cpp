@@ -0,0 +1,513 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Collision/b2SweepAndPrune.h"
+#include "Box2D/Collision/b2BroadPhase.h"
+
+#include <string.h>
+#include <algorithm>
+
+// Lower ends come first at equal values, so touching boxes overlap like they
+// do for b2TestOverlap.
+static inline bool b2EndpointLessThan(const b2SapEndpoint& a, const b2SapEndpoint& b)
+{
+	if (a.value < b.value)
+	{
+		return true;
+	}
+
+	return a.value == b.value && (a.data & 1) < (b.data & 1);
+}
+
+template <typename T>
+static void b2Grow(T** buffer, int32* capacity, int32 count, int32 required)
+{
+	if (required <= *capacity)
+	{
+		return;
+	}
+
+	int32 newCapacity = b2Max(2 * *capacity, required);
+	T* newBuffer = (T*)b2Alloc(newCapacity * sizeof(T));
+	memcpy(newBuffer, *buffer, count * sizeof(T));
+	b2Free(*buffer);
+	*buffer = newBuffer;
+	*capacity = newCapacity;
+}
+
+b2SweepAndPrune::b2SweepAndPrune()
+{
+	m_boxCapacity = 16;
+	m_boxes = (b2SapBox*)b2Alloc(m_boxCapacity * sizeof(b2SapBox));
+	m_freeList = b2_nullNode;
+	for (int32 i = m_boxCapacity - 1; i >= 0; --i)
+	{
+		m_boxes[i].state = e_freeBox;
+		m_boxes[i].next = m_freeList;
+		m_freeList = i;
+	}
+	m_boxCount = 0;
+
+	m_proxyMapCapacity = 16;
+	m_proxyMap = (int32*)b2Alloc(m_proxyMapCapacity * sizeof(int32));
+
+	m_endpointCapacity = 32;
+	m_endpointCount = 0;
+	m_endpoints[0] = (b2SapEndpoint*)b2Alloc(m_endpointCapacity * sizeof(b2SapEndpoint));
+	m_endpoints[1] = (b2SapEndpoint*)b2Alloc(m_endpointCapacity * sizeof(b2SapEndpoint));
+
+	m_newCapacity = 16;
+	m_newCount = 0;
+	m_newBoxes = (int32*)b2Alloc(m_newCapacity * sizeof(int32));
+
+	m_moveCapacity = 16;
+	m_moveCount = 0;
+	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+
+	m_removedCount = 0;
+
+	m_pairCapacity = 16;
+	m_pairCount = 0;
+	m_pairs = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+}
+
+b2SweepAndPrune::~b2SweepAndPrune()
+{
+	b2Free(m_pairs);
+	b2Free(m_moveBuffer);
+	b2Free(m_newBoxes);
+	b2Free(m_endpoints[1]);
+	b2Free(m_endpoints[0]);
+	b2Free(m_proxyMap);
+	b2Free(m_boxes);
+}
+
+int32 b2SweepAndPrune::AllocateBox()
+{
+	if (m_freeList == b2_nullNode)
+	{
+		int32 oldCapacity = m_boxCapacity;
+		b2Grow(&m_boxes, &m_boxCapacity, oldCapacity, oldCapacity + 1);
+		for (int32 i = m_boxCapacity - 1; i >= oldCapacity; --i)
+		{
+			m_boxes[i].state = e_freeBox;
+			m_boxes[i].next = m_freeList;
+			m_freeList = i;
+		}
+	}
+
+	int32 index = m_freeList;
+	m_freeList = m_boxes[index].next;
+	++m_boxCount;
+	return index;
+}
+
+void b2SweepAndPrune::FreeBox(int32 index)
+{
+	m_boxes[index].state = e_freeBox;
+	m_boxes[index].next = m_freeList;
+	m_freeList = index;
+	--m_boxCount;
+}
+
+void b2SweepAndPrune::AddProxy(int32 proxyId, const b2AABB& aabb, bool isStatic)
+{
+	b2Assert(0 <= proxyId);
+
+	int32 index = AllocateBox();
+	b2SapBox* box = m_boxes + index;
+	box->aabb = aabb;
+	box->proxyId = proxyId;
+	box->state = e_newBox;
+	box->isStatic = isStatic;
+	box->moved = false;
+
+	b2Grow(&m_proxyMap, &m_proxyMapCapacity, m_proxyMapCapacity, proxyId + 1);
+	m_proxyMap[proxyId] = index;
+
+	b2Grow(&m_newBoxes, &m_newCapacity, m_newCount, m_newCount + 1);
+	m_newBoxes[m_newCount] = index;
+	++m_newCount;
+}
+
+void b2SweepAndPrune::RemoveProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyMapCapacity);
+
+	// The box stays in its array until the next UpdatePairs, so its index
+	// cannot be reused before then.
+	b2SapBox* box = m_boxes + m_proxyMap[proxyId];
+	b2Assert(box->state == e_newBox || box->state == e_sortedBox);
+	if (box->state == e_sortedBox)
+	{
+		++m_removedCount;
+	}
+	box->state = e_removedBox;
+}
+
+void b2SweepAndPrune::MoveProxy(int32 proxyId, const b2AABB& aabb)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyMapCapacity);
+
+	int32 index = m_proxyMap[proxyId];
+	b2SapBox* box = m_boxes + index;
+	b2Assert(box->state == e_newBox || box->state == e_sortedBox);
+	box->aabb = aabb;
+
+	if (box->state == e_sortedBox && box->moved == false)
+	{
+		box->moved = true;
+		b2Grow(&m_moveBuffer, &m_moveCapacity, m_moveCount, m_moveCount + 1);
+		m_moveBuffer[m_moveCount] = index;
+		++m_moveCount;
+	}
+}
+
+void b2SweepAndPrune::Clear()
+{
+	m_freeList = b2_nullNode;
+	for (int32 i = m_boxCapacity - 1; i >= 0; --i)
+	{
+		m_boxes[i].state = e_freeBox;
+		m_boxes[i].next = m_freeList;
+		m_freeList = i;
+	}
+	m_boxCount = 0;
+	m_endpointCount = 0;
+	m_newCount = 0;
+	m_moveCount = 0;
+	m_removedCount = 0;
+	m_pairCount = 0;
+}
+
+void b2SweepAndPrune::UpdatePairs()
+{
+	m_pairCount = 0;
+
+	if (m_removedCount > 0)
+	{
+		RemoveEndpoints();
+		UpdateIndices();
+	}
+
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		int32 index = m_moveBuffer[i];
+		b2SapBox* box = m_boxes + index;
+		box->moved = false;
+		if (box->state == e_sortedBox)
+		{
+			SortBox(index);
+		}
+	}
+	m_moveCount = 0;
+
+	if (m_newCount > 0)
+	{
+		MergeNewBoxes();
+		UpdateIndices();
+	}
+}
+
+// Compact the arrays without reordering them, then free the removed boxes.
+void b2SweepAndPrune::RemoveEndpoints()
+{
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2SapEndpoint* endpoints = m_endpoints[axis];
+		int32 count = 0;
+		for (int32 i = 0; i < m_endpointCount; ++i)
+		{
+			b2SapEndpoint endpoint = endpoints[i];
+			b2SapBox* box = m_boxes + (endpoint.data >> 1);
+			if (box->state == e_removedBox)
+			{
+				// Free the box once, at its last endpoint.
+				if (axis == 1 && (endpoint.data & 1) == 1)
+				{
+					FreeBox(endpoint.data >> 1);
+				}
+				continue;
+			}
+
+			endpoints[count] = endpoint;
+			++count;
+		}
+
+		if (axis == 1)
+		{
+			m_endpointCount = count;
+		}
+	}
+
+	m_removedCount = 0;
+}
+
+// Write the new bounds of a box into the arrays and sort its endpoints into
+// place. The end that moves away from the other one goes first, so neither
+// end has to pass the other one.
+void b2SweepAndPrune::SortBox(int32 index)
+{
+	const b2SapBox* box = m_boxes + index;
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2SapEndpoint* endpoints = m_endpoints[axis];
+		int32 lowerIndex = box->lowerIndex[axis];
+		int32 upperIndex = box->upperIndex[axis];
+		float32 oldLower = endpoints[lowerIndex].value;
+		endpoints[lowerIndex].value = box->aabb.lowerBound(axis);
+		endpoints[upperIndex].value = box->aabb.upperBound(axis);
+
+		if (endpoints[lowerIndex].value < oldLower)
+		{
+			SortEndpoint(axis, lowerIndex);
+			SortEndpoint(axis, box->upperIndex[axis]);
+		}
+		else
+		{
+			SortEndpoint(axis, upperIndex);
+			SortEndpoint(axis, box->lowerIndex[axis]);
+		}
+	}
+}
+
+// Insertion sort of a single endpoint. A lower end passing below an upper end,
+// or an upper end passing above a lower end, starts an overlap on this axis.
+// The opposite passes stop one, which the client finds by itself.
+void b2SweepAndPrune::SortEndpoint(int32 axis, int32 position)
+{
+	b2SapEndpoint* endpoints = m_endpoints[axis];
+	b2SapEndpoint key = endpoints[position];
+	int32 keyIndex = key.data >> 1;
+	bool keyIsUpper = (key.data & 1) == 1;
+
+	int32 i = position;
+	while (i > 0 && b2EndpointLessThan(key, endpoints[i - 1]))
+	{
+		b2SapEndpoint other = endpoints[i - 1];
+		if (keyIsUpper == false && (other.data & 1) == 1)
+		{
+			AddPair(keyIndex, other.data >> 1, 1 - axis);
+		}
+
+		endpoints[i] = other;
+		SetIndex(other, axis, i);
+		--i;
+	}
+
+	while (i < m_endpointCount - 1 && b2EndpointLessThan(endpoints[i + 1], key))
+	{
+		b2SapEndpoint other = endpoints[i + 1];
+		if (keyIsUpper && (other.data & 1) == 0)
+		{
+			AddPair(keyIndex, other.data >> 1, 1 - axis);
+		}
+
+		endpoints[i] = other;
+		SetIndex(other, axis, i);
+		++i;
+	}
+
+	endpoints[i] = key;
+	SetIndex(key, axis, i);
+}
+
+// The boxes overlap on the other axis if their endpoints interleave there.
+void b2SweepAndPrune::AddPair(int32 indexA, int32 indexB, int32 otherAxis)
+{
+	const b2SapBox* boxA = m_boxes + indexA;
+	const b2SapBox* boxB = m_boxes + indexB;
+	if (boxA->isStatic && boxB->isStatic)
+	{
+		return;
+	}
+
+	if (boxA->upperIndex[otherAxis] < boxB->lowerIndex[otherAxis] ||
+		boxB->upperIndex[otherAxis] < boxA->lowerIndex[otherAxis])
+	{
+		return;
+	}
+
+	b2Grow(&m_pairs, &m_pairCapacity, m_pairCount, m_pairCount + 1);
+	m_pairs[m_pairCount].proxyIdA = b2Min(boxA->proxyId, boxB->proxyId);
+	m_pairs[m_pairCount].proxyIdB = b2Max(boxA->proxyId, boxB->proxyId);
+	++m_pairCount;
+}
+
+// Append the endpoints of the new boxes, sort them and merge them into the
+// arrays. This costs O(n + k log k) instead of sorting each new box into place.
+void b2SweepAndPrune::MergeNewBoxes()
+{
+	int32 oldCount = m_endpointCount;
+	int32 totalCount = oldCount;
+	for (int32 i = 0; i < m_newCount; ++i)
+	{
+		b2SapBox* box = m_boxes + m_newBoxes[i];
+		if (box->state == e_removedBox)
+		{
+			FreeBox(m_newBoxes[i]);
+		}
+		else
+		{
+			totalCount += 2;
+		}
+	}
+
+	if (totalCount > m_endpointCapacity)
+	{
+		int32 capacity = m_endpointCapacity;
+		b2Grow(&m_endpoints[0], &capacity, oldCount, totalCount);
+		capacity = m_endpointCapacity;
+		b2Grow(&m_endpoints[1], &capacity, oldCount, totalCount);
+		m_endpointCapacity = capacity;
+	}
+
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2SapEndpoint* endpoints = m_endpoints[axis];
+		int32 count = oldCount;
+		for (int32 i = 0; i < m_newCount; ++i)
+		{
+			int32 index = m_newBoxes[i];
+			b2SapBox* box = m_boxes + index;
+			if (box->state != e_newBox)
+			{
+				continue;
+			}
+
+			endpoints[count].value = box->aabb.lowerBound(axis);
+			endpoints[count].data = index << 1;
+			endpoints[count + 1].value = box->aabb.upperBound(axis);
+			endpoints[count + 1].data = (index << 1) | 1;
+			count += 2;
+		}
+
+		std::sort(endpoints + oldCount, endpoints + totalCount, b2EndpointLessThan);
+		std::inplace_merge(endpoints, endpoints + oldCount, endpoints + totalCount, b2EndpointLessThan);
+	}
+
+	for (int32 i = 0; i < m_newCount; ++i)
+	{
+		b2SapBox* box = m_boxes + m_newBoxes[i];
+		if (box->state == e_newBox)
+		{
+			box->state = e_sortedBox;
+		}
+	}
+
+	m_endpointCount = totalCount;
+	m_newCount = 0;
+}
+
+void b2SweepAndPrune::UpdateIndices()
+{
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		const b2SapEndpoint* endpoints = m_endpoints[axis];
+		for (int32 i = 0; i < m_endpointCount; ++i)
+		{
+			SetIndex(endpoints[i], axis, i);
+		}
+	}
+}
+
+void b2SweepAndPrune::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < m_boxCapacity; ++i)
+	{
+		if (m_boxes[i].state != e_freeBox)
+		{
+			m_boxes[i].aabb.lowerBound -= newOrigin;
+			m_boxes[i].aabb.upperBound -= newOrigin;
+		}
+	}
+
+	// Rounding may reorder endpoints with almost equal values.
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		b2SapEndpoint* endpoints = m_endpoints[axis];
+		for (int32 i = 0; i < m_endpointCount; ++i)
+		{
+			endpoints[i].value -= newOrigin(axis);
+		}
+		std::sort(endpoints, endpoints + m_endpointCount, b2EndpointLessThan);
+	}
+	UpdateIndices();
+}
+
+void b2SweepAndPrune::CopyFrom(const b2SweepAndPrune& other)
+{
+	if (m_boxCapacity < other.m_boxCapacity)
+	{
+		b2Free(m_boxes);
+		m_boxCapacity = other.m_boxCapacity;
+		m_boxes = (b2SapBox*)b2Alloc(m_boxCapacity * sizeof(b2SapBox));
+	}
+
+	// Keep the surplus boxes on the free list behind the copied ones.
+	memcpy(m_boxes, other.m_boxes, other.m_boxCapacity * sizeof(b2SapBox));
+	m_freeList = other.m_freeList;
+	for (int32 i = m_boxCapacity - 1; i >= other.m_boxCapacity; --i)
+	{
+		m_boxes[i].state = e_freeBox;
+		m_boxes[i].next = m_freeList;
+		m_freeList = i;
+	}
+	m_boxCount = other.m_boxCount;
+
+	if (m_proxyMapCapacity < other.m_proxyMapCapacity)
+	{
+		b2Free(m_proxyMap);
+		m_proxyMapCapacity = other.m_proxyMapCapacity;
+		m_proxyMap = (int32*)b2Alloc(m_proxyMapCapacity * sizeof(int32));
+	}
+	memcpy(m_proxyMap, other.m_proxyMap, other.m_proxyMapCapacity * sizeof(int32));
+
+	if (m_endpointCapacity < other.m_endpointCount)
+	{
+		b2Free(m_endpoints[0]);
+		b2Free(m_endpoints[1]);
+		m_endpointCapacity = other.m_endpointCapacity;
+		m_endpoints[0] = (b2SapEndpoint*)b2Alloc(m_endpointCapacity * sizeof(b2SapEndpoint));
+		m_endpoints[1] = (b2SapEndpoint*)b2Alloc(m_endpointCapacity * sizeof(b2SapEndpoint));
+	}
+	memcpy(m_endpoints[0], other.m_endpoints[0], other.m_endpointCount * sizeof(b2SapEndpoint));
+	memcpy(m_endpoints[1], other.m_endpoints[1], other.m_endpointCount * sizeof(b2SapEndpoint));
+	m_endpointCount = other.m_endpointCount;
+
+	if (m_newCapacity < other.m_newCount)
+	{
+		b2Free(m_newBoxes);
+		m_newCapacity = other.m_newCapacity;
+		m_newBoxes = (int32*)b2Alloc(m_newCapacity * sizeof(int32));
+	}
+	memcpy(m_newBoxes, other.m_newBoxes, other.m_newCount * sizeof(int32));
+	m_newCount = other.m_newCount;
+
+	if (m_moveCapacity < other.m_moveCount)
+	{
+		b2Free(m_moveBuffer);
+		m_moveCapacity = other.m_moveCapacity;
+		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	}
+	memcpy(m_moveBuffer, other.m_moveBuffer, other.m_moveCount * sizeof(int32));
+	m_moveCount = other.m_moveCount;
+
+	m_removedCount = other.m_removedCount;
+	m_pairCount = 0;
+}
@@ -0,0 +1,169 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SWEEP_AND_PRUNE_H
+#define B2_SWEEP_AND_PRUNE_H
+
+#include "Box2D/Collision/b2Collision.h"
+
+struct b2Pair;
+
+/// One end of a box on an axis. The low bit of data is set for the upper end
+/// and the remaining bits are the box index.
+struct b2SapEndpoint
+{
+	float32 value;
+	int32 data;
+};
+
+/// The bounds of a proxy and where its endpoints are in the sorted arrays.
+struct b2SapBox
+{
+	b2AABB aabb;
+	int32 proxyId;
+	int32 lowerIndex[2];
+	int32 upperIndex[2];
+	int32 next;
+	int32 state;
+	bool isStatic;
+	bool moved;
+};
+
+/// Incremental sweep and prune on both axes. The endpoints of all boxes are
+/// kept sorted from one step to the next, and the endpoints of moved boxes are
+/// insertion sorted from where they were, so small moves cost little. Every
+/// time two boxes start to overlap on one axis while they overlap on the other
+/// axis, the two form a candidate pair. Pairs that overlapped before are not
+/// reported again.
+///
+/// Boxes are addressed with the proxy ids of the owning broad-phase. New boxes
+/// are merged into the arrays without reporting pairs, so the owner must find
+/// the pairs of new proxies by itself.
+class b2SweepAndPrune
+{
+public:
+	b2SweepAndPrune();
+	~b2SweepAndPrune();
+
+	/// Add a box. It joins the sorted arrays at the next UpdatePairs.
+	void AddProxy(int32 proxyId, const b2AABB& aabb, bool isStatic);
+
+	/// Remove a box. Static boxes are never paired with each other.
+	void RemoveProxy(int32 proxyId);
+
+	/// Change the bounds of a box. It is sorted again at the next UpdatePairs.
+	void MoveProxy(int32 proxyId, const b2AABB& aabb);
+
+	/// Remove all boxes.
+	void Clear();
+
+	/// Sort the endpoints and gather the pairs that started to overlap since the
+	/// last call. A pair may be reported more than once and it may have stopped
+	/// overlapping again later in the sort, so the caller must test the pairs.
+	void UpdatePairs();
+
+	/// Get the pairs gathered by UpdatePairs, with proxyIdA < proxyIdB.
+	const b2Pair* GetPairs() const;
+	int32 GetPairCount() const;
+
+	/// Get the number of boxes.
+	int32 GetProxyCount() const;
+
+	/// Shift the world origin. Useful for large worlds.
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Make this an exact copy of another one.
+	void CopyFrom(const b2SweepAndPrune& other);
+
+private:
+
+	enum
+	{
+		e_freeBox = 0,
+		e_newBox = 1,
+		e_sortedBox = 2,
+		e_removedBox = 3
+	};
+
+	int32 AllocateBox();
+	void FreeBox(int32 index);
+	void RemoveEndpoints();
+	void SortBox(int32 index);
+	void SortEndpoint(int32 axis, int32 position);
+	void SetIndex(const b2SapEndpoint& endpoint, int32 axis, int32 index);
+	void MergeNewBoxes();
+	void UpdateIndices();
+	void AddPair(int32 indexA, int32 indexB, int32 otherAxis);
+
+	b2SapBox* m_boxes;
+	int32 m_boxCapacity;
+	int32 m_freeList;
+	int32 m_boxCount;
+
+	// Maps proxy ids to box indices.
+	int32* m_proxyMap;
+	int32 m_proxyMapCapacity;
+
+	b2SapEndpoint* m_endpoints[2];
+	int32 m_endpointCount;
+	int32 m_endpointCapacity;
+
+	int32* m_newBoxes;
+	int32 m_newCount;
+	int32 m_newCapacity;
+
+	int32* m_moveBuffer;
+	int32 m_moveCount;
+	int32 m_moveCapacity;
+
+	int32 m_removedCount;
+
+	b2Pair* m_pairs;
+	int32 m_pairCount;
+	int32 m_pairCapacity;
+};
+
+inline const b2Pair* b2SweepAndPrune::GetPairs() const
+{
+	return m_pairs;
+}
+
+inline int32 b2SweepAndPrune::GetPairCount() const
+{
+	return m_pairCount;
+}
+
+inline int32 b2SweepAndPrune::GetProxyCount() const
+{
+	return m_boxCount;
+}
+
+inline void b2SweepAndPrune::SetIndex(const b2SapEndpoint& endpoint, int32 axis, int32 index)
+{
+	b2SapBox* box = m_boxes + (endpoint.data >> 1);
+	if (endpoint.data & 1)
+	{
+		box->upperIndex[axis] = index;
+	}
+	else
+	{
+		box->lowerIndex[axis] = index;
+	}
+}
+
+#endif
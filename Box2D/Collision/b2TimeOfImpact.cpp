@@ -25,9 +25,10 @@
 
 #include <stdio.h>
 
-float32 b2_toiTime, b2_toiMaxTime;
-int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
-int32 b2_toiRootIters, b2_toiMaxRootIters;
+// The statistics are per thread so that worlds can step on several threads.
+thread_local float32 b2_toiTime, b2_toiMaxTime;
+thread_local int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
+thread_local int32 b2_toiRootIters, b2_toiMaxRootIters;
 
 //
 struct b2SeparationFunction
@@ -249,9 +250,27 @@ struct b2SeparationFunction
 	b2Vec2 m_axis;
 };
 
+// The largest distance of a proxy vertex from the center of rotation.
+static float32 b2GetProxyExtent(const b2DistanceProxy* proxy, const b2Vec2& center)
+{
+	float32 extentSqr = 0.0f;
+	for (int32 i = 0; i < proxy->m_count; ++i)
+	{
+		extentSqr = b2Max(extentSqr, b2DistanceSquared(proxy->m_vertices[i], center));
+	}
+	return b2Sqrt(extentSqr);
+}
+
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
+{
+	b2SimplexCache cache;
+	cache.count = 0;
+	b2TimeOfImpact(output, input, &cache);
+}
+
 // CCD via the local separating axis method. This seeks progression
 // by computing the largest time at which separation is maintained.
-void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2SimplexCache* cache)
 {
 	b2Timer timer;
 
@@ -259,6 +278,8 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
+	output->iterations = 0;
+	output->rootIterations = 0;
 
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
@@ -278,13 +299,21 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 	float32 tolerance = 0.25f * b2_linearSlop;
 	b2Assert(target > tolerance);
 
+	// A vertex moves at most by the translation of the sweep plus the arc of
+	// its rotation. This bounds how fast the shapes can approach each other
+	// over the sweep interval. The bound is tight for a circle, which does not
+	// rotate about its center, and for a static body, which does not move.
+	b2Vec2 dc = (sweepA.c - sweepA.c0) - (sweepB.c - sweepB.c0);
+	float32 maxApproach = dc.Length();
+	maxApproach += b2Abs(sweepA.a - sweepA.a0) * b2GetProxyExtent(proxyA, sweepA.localCenter);
+	maxApproach += b2Abs(sweepB.a - sweepB.a0) * b2GetProxyExtent(proxyB, sweepB.localCenter);
+
 	float32 t1 = 0.0f;
 	const int32 k_maxIterations = 20;	// TODO_ERIN b2Settings
 	int32 iter = 0;
+	int32 rootIters = 0;
 
 	// Prepare input for distance query.
-	b2SimplexCache cache;
-	cache.count = 0;
 	b2DistanceInput distanceInput;
 	distanceInput.proxyA = input->proxyA;
 	distanceInput.proxyB = input->proxyB;
@@ -303,7 +332,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		distanceInput.transformA = xfA;
 		distanceInput.transformB = xfB;
 		b2DistanceOutput distanceOutput;
-		b2Distance(&distanceOutput, &cache, &distanceInput);
+		b2Distance(&distanceOutput, cache, &distanceInput);
 
 		// If the shapes are overlapped, we give up on continuous collision.
 		if (distanceOutput.distance <= 0.0f)
@@ -322,9 +351,18 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 			break;
 		}
 
+		// Can the shapes not reach the target before the end of the sweep?
+		// Then no separating axis is needed.
+		if (distanceOutput.distance - (tMax - t1) * maxApproach > target + tolerance)
+		{
+			output->state = b2TOIOutput::e_separated;
+			output->t = tMax;
+			break;
+		}
+
 		// Initialize the separating axis.
 		b2SeparationFunction fcn;
-		fcn.Initialize(&cache, proxyA, sweepA, proxyB, sweepB, t1);
+		fcn.Initialize(cache, proxyA, sweepA, proxyB, sweepB, t1);
 #if 0
 		// Dump the curve seen by the root finder
 		{
@@ -422,6 +460,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
+				++rootIters;
 				++b2_toiRootIters;
 
 				float32 s = fcn.Evaluate(indexA, indexB, t);
@@ -480,6 +519,9 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 
 	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
 
+	output->iterations = iter;
+	output->rootIterations = rootIters;
+
 	float32 time = timer.GetMilliseconds();
 	b2_toiMaxTime = b2Max(b2_toiMaxTime, time);
 	b2_toiTime += time;
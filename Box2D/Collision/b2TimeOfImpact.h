@@ -46,6 +46,8 @@ struct b2TOIOutput
 
 	State state;
 	float32 t;
+	int32 iterations;		///< the separating axes that were tried
+	int32 rootIterations;	///< the root finder iterations over all axes
 };
 
 /// Compute the upper bound on time before two shapes penetrate. Time is represented as
@@ -55,4 +57,10 @@ struct b2TOIOutput
 /// Note: use b2Distance to compute the contact point and normal at the time of impact.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input);
 
+/// Compute the time of impact starting from a simplex cache. The cache warm starts
+/// the distance queries and receives the last simplex, so it can be kept for the next
+/// call on the same proxies, for example across time steps. Set count to zero on the
+/// first call.
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2SimplexCache* cache);
+
 #endif
@@ -0,0 +1,144 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Collision/b2WideTree.h"
+#include <string.h>
+
+b2WideTree::b2WideTree()
+{
+	m_nodes = nullptr;
+	m_nodeCount = 0;
+	m_nodeCapacity = 0;
+}
+
+b2WideTree::~b2WideTree()
+{
+	b2Free(m_nodes);
+}
+
+struct b2WideBuildItem
+{
+	int32 wideNode;
+	int32 treeNode;
+};
+
+void b2WideTree::Build(const b2DynamicTree& tree)
+{
+	m_nodeCount = 0;
+
+	if (tree.m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	// Every wide node but a lone root leaf has at least two children, so there
+	// are fewer wide nodes than leaves.
+	int32 capacity = tree.m_nodeCount / 2 + 1;
+	if (m_nodeCapacity < capacity)
+	{
+		b2Free(m_nodes);
+		m_nodeCapacity = b2Max(capacity, 2 * m_nodeCapacity);
+		m_nodes = (b2WideNode*)b2Alloc(m_nodeCapacity * sizeof(b2WideNode));
+	}
+
+	const b2TreeNode* nodes = tree.m_nodes;
+
+	b2GrowableStack<b2WideBuildItem, 256> stack;
+	b2WideBuildItem item;
+	item.wideNode = 0;
+	item.treeNode = tree.m_root;
+	stack.Push(item);
+	m_nodeCount = 1;
+
+	while (stack.GetCount() > 0)
+	{
+		item = stack.Pop();
+
+		int32 children[4];
+		int32 count;
+
+		const b2TreeNode* treeNode = nodes + item.treeNode;
+		if (treeNode->IsLeaf())
+		{
+			children[0] = item.treeNode;
+			count = 1;
+		}
+		else
+		{
+			children[0] = treeNode->child1;
+			children[1] = treeNode->child2;
+			count = 2;
+
+			// Open the internal child with the largest perimeter until there are four.
+			while (count < 4)
+			{
+				int32 best = -1;
+				float32 bestPerimeter = -1.0f;
+				for (int32 i = 0; i < count; ++i)
+				{
+					const b2TreeNode* child = nodes + children[i];
+					if (child->IsLeaf() == false && child->aabb.GetPerimeter() > bestPerimeter)
+					{
+						best = i;
+						bestPerimeter = child->aabb.GetPerimeter();
+					}
+				}
+
+				if (best == -1)
+				{
+					break;
+				}
+
+				const b2TreeNode* child = nodes + children[best];
+				children[best] = child->child1;
+				children[count] = child->child2;
+				++count;
+			}
+		}
+
+		b2WideNode* wideNode = m_nodes + item.wideNode;
+		memset(wideNode, 0, sizeof(b2WideNode));
+		wideNode->childCount = count;
+
+		for (int32 i = 0; i < count; ++i)
+		{
+			const b2TreeNode* child = nodes + children[i];
+			wideNode->lowerX[i] = child->aabb.lowerBound.x;
+			wideNode->lowerY[i] = child->aabb.lowerBound.y;
+			wideNode->upperX[i] = child->aabb.upperBound.x;
+			wideNode->upperY[i] = child->aabb.upperBound.y;
+
+			if (child->IsLeaf())
+			{
+				wideNode->children[i] = children[i];
+				wideNode->leafMask |= 1 << i;
+			}
+			else
+			{
+				b2Assert(m_nodeCount < m_nodeCapacity);
+				b2WideBuildItem childItem;
+				childItem.wideNode = m_nodeCount;
+				childItem.treeNode = children[i];
+				stack.Push(childItem);
+
+				wideNode->children[i] = m_nodeCount;
+				++m_nodeCount;
+			}
+		}
+	}
+}
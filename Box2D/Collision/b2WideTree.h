@@ -0,0 +1,256 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WIDE_TREE_H
+#define B2_WIDE_TREE_H
+
+#include "Box2D/Collision/b2DynamicTree.h"
+#include "Box2D/Common/b2Simd.h"
+
+/// A node of the wide tree. The child AABBs are stored per coordinate so that
+/// all four are tested at once.
+struct b2WideNode
+{
+	float32 lowerX[4];
+	float32 lowerY[4];
+	float32 upperX[4];
+	float32 upperY[4];
+
+	/// A wide node index, or a proxy id if the child's bit is set in leafMask.
+	int32 children[4];
+	int32 childCount;
+	int32 leafMask;
+};
+
+/// A four-wide copy of a b2DynamicTree for fast queries and ray casts. It is
+/// collapsed from the binary tree, so it has the same proxy ids, and it must be
+/// built again after the binary tree changes.
+class b2WideTree
+{
+public:
+	b2WideTree();
+	~b2WideTree();
+
+	/// Collapse a binary tree in O(N) time. Each wide node opens the largest of
+	/// the binary nodes below it until it has four children.
+	void Build(const b2DynamicTree& tree);
+
+	/// Query an AABB for overlapping proxies. The callback class
+	/// is called for each proxy that overlaps the supplied AABB.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Ray-cast against the proxies in the tree. This works like b2DynamicTree::RayCast.
+	template <typename T>
+	void RayCast(T* callback, const b2RayCastInput& input) const;
+
+	/// Cast an AABB with the given half extents along a ray traced by its center.
+	/// Every proxy the box may hit is reported through RayCastCallback, which
+	/// performs the exact shape cast and clips the ray like a ray-cast hit.
+	template <typename T>
+	void ShapeCast(T* callback, const b2RayCastInput& input, const b2Vec2& extents) const;
+
+	/// Get the number of wide nodes.
+	int32 GetNodeCount() const;
+
+private:
+
+	b2WideNode* m_nodes;
+	int32 m_nodeCount;
+	int32 m_nodeCapacity;
+};
+
+inline int32 b2WideTree::GetNodeCount() const
+{
+	return m_nodeCount;
+}
+
+template <typename T>
+inline void b2WideTree::Query(T* callback, const b2AABB& aabb) const
+{
+	if (m_nodeCount == 0)
+	{
+		return;
+	}
+
+	b2Float4 lowerX = b2Splat4(aabb.lowerBound.x);
+	b2Float4 lowerY = b2Splat4(aabb.lowerBound.y);
+	b2Float4 upperX = b2Splat4(aabb.upperBound.x);
+	b2Float4 upperY = b2Splat4(aabb.upperBound.y);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideNode* node = m_nodes + stack.Pop();
+
+		int32 mask = (1 << node->childCount) - 1;
+		mask &= b2LessEqual4(b2Load4(node->lowerX), upperX);
+		mask &= b2LessEqual4(b2Load4(node->lowerY), upperY);
+		mask &= b2LessEqual4(lowerX, b2Load4(node->upperX));
+		mask &= b2LessEqual4(lowerY, b2Load4(node->upperY));
+
+		for (int32 i = 0; i < node->childCount; ++i)
+		{
+			if ((mask & (1 << i)) == 0)
+			{
+				continue;
+			}
+
+			if (node->leafMask & (1 << i))
+			{
+				bool proceed = callback->QueryCallback(node->children[i]);
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+			else
+			{
+				stack.Push(node->children[i]);
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2WideTree::RayCast(T* callback, const b2RayCastInput& input) const
+{
+	ShapeCast(callback, input, b2Vec2_zero);
+}
+
+template <typename T>
+inline void b2WideTree::ShapeCast(T* callback, const b2RayCastInput& input, const b2Vec2& extents) const
+{
+	if (m_nodeCount == 0)
+	{
+		return;
+	}
+
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the swept box.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t) - extents;
+		segmentAABB.upperBound = b2Max(p1, t) + extents;
+	}
+
+	b2Float4 p1X = b2Splat4(p1.x);
+	b2Float4 p1Y = b2Splat4(p1.y);
+	b2Float4 vX = b2Splat4(v.x);
+	b2Float4 vY = b2Splat4(v.y);
+	b2Float4 absVX = b2Splat4(abs_v.x);
+	b2Float4 absVY = b2Splat4(abs_v.y);
+	b2Float4 extentX = b2Splat4(extents.x);
+	b2Float4 extentY = b2Splat4(extents.y);
+	b2Float4 half = b2Splat4(0.5f);
+	b2Float4 zero = b2Splat4(0.0f);
+
+	b2Float4 segmentLowerX = b2Splat4(segmentAABB.lowerBound.x);
+	b2Float4 segmentLowerY = b2Splat4(segmentAABB.lowerBound.y);
+	b2Float4 segmentUpperX = b2Splat4(segmentAABB.upperBound.x);
+	b2Float4 segmentUpperY = b2Splat4(segmentAABB.upperBound.y);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(0);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideNode* node = m_nodes + stack.Pop();
+
+		// Grow the children by the extents of the box.
+		b2Float4 lowerX = b2Load4(node->lowerX) - extentX;
+		b2Float4 lowerY = b2Load4(node->lowerY) - extentY;
+		b2Float4 upperX = b2Load4(node->upperX) + extentX;
+		b2Float4 upperY = b2Load4(node->upperY) + extentY;
+
+		int32 mask = (1 << node->childCount) - 1;
+		mask &= b2LessEqual4(lowerX, segmentUpperX);
+		mask &= b2LessEqual4(lowerY, segmentUpperY);
+		mask &= b2LessEqual4(segmentLowerX, upperX);
+		mask &= b2LessEqual4(segmentLowerY, upperY);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		// Separating axis for segment (Gino, p80).
+		// |dot(v, p1 - c)| > dot(|v|, h)
+		b2Float4 cX = half * (lowerX + upperX);
+		b2Float4 cY = half * (lowerY + upperY);
+		b2Float4 hX = half * (upperX - lowerX);
+		b2Float4 hY = half * (upperY - lowerY);
+		b2Float4 separation = b2Abs4(vX * (p1X - cX) + vY * (p1Y - cY)) - (absVX * hX + absVY * hY);
+		mask &= b2LessEqual4(separation, zero);
+
+		for (int32 i = 0; i < node->childCount; ++i)
+		{
+			if ((mask & (1 << i)) == 0)
+			{
+				continue;
+			}
+
+			if ((node->leafMask & (1 << i)) == 0)
+			{
+				stack.Push(node->children[i]);
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float32 value = callback->RayCastCallback(subInput, node->children[i]);
+
+			if (value == 0.0f)
+			{
+				// The client has terminated the ray cast.
+				return;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t) - extents;
+				segmentAABB.upperBound = b2Max(p1, t) + extents;
+				segmentLowerX = b2Splat4(segmentAABB.lowerBound.x);
+				segmentLowerY = b2Splat4(segmentAABB.lowerBound.y);
+				segmentUpperX = b2Splat4(segmentAABB.upperBound.x);
+				segmentUpperY = b2Splat4(segmentAABB.upperBound.y);
+			}
+		}
+	}
+}
+
+#endif
@@ -39,7 +39,6 @@ int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] =
 	640,	// 13
 };
 uint8 b2BlockAllocator::s_blockSizeLookup[b2_maxBlockSize + 1];
-bool b2BlockAllocator::s_blockSizeLookupInitialized;
 
 struct b2Chunk
 {
@@ -63,25 +62,35 @@ b2BlockAllocator::b2BlockAllocator()
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
 
-	if (s_blockSizeLookupInitialized == false)
+	InitializeBlockSizes();
+}
+
+void b2BlockAllocator::InitializeBlockSizes()
+{
+	// A function local static is initialized exactly once, even when
+	// allocators are constructed on several threads at the same time.
+	static bool lookupInitialized = InitializeBlockSizeLookup();
+	B2_NOT_USED(lookupInitialized);
+}
+
+bool b2BlockAllocator::InitializeBlockSizeLookup()
+{
+	int32 j = 0;
+	for (int32 i = 1; i <= b2_maxBlockSize; ++i)
 	{
-		int32 j = 0;
-		for (int32 i = 1; i <= b2_maxBlockSize; ++i)
+		b2Assert(j < b2_blockSizes);
+		if (i <= s_blockSizes[j])
 		{
-			b2Assert(j < b2_blockSizes);
-			if (i <= s_blockSizes[j])
-			{
-				s_blockSizeLookup[i] = (uint8)j;
-			}
-			else
-			{
-				++j;
-				s_blockSizeLookup[i] = (uint8)j;
-			}
+			s_blockSizeLookup[i] = (uint8)j;
+		}
+		else
+		{
+			++j;
+			s_blockSizeLookup[i] = (uint8)j;
 		}
-
-		s_blockSizeLookupInitialized = true;
 	}
+
+	return true;
 }
 
 b2BlockAllocator::~b2BlockAllocator()
@@ -0,0 +1,317 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Common/b2ConcurrentBlockAllocator.h"
+#include <new>
+#include <string.h>
+
+// A free block also knows how many blocks its list holds from it on, so a
+// thread can tell when a magazine is full without a separate count.
+struct b2Block
+{
+	b2Block* next;
+	int32 count;
+};
+
+// The free blocks of one thread and block size: a partly filled magazine and
+// an optional full spare.
+struct b2BlockCache
+{
+	b2Block* blocks;
+	b2Block* spare;
+};
+
+// A full magazine of b2_magazineSize blocks in the shared pool. The records
+// live in chunks of their own and are never handed out, so a thread that read
+// a stale head can still read its link.
+struct b2Magazine
+{
+	std::atomic<b2Magazine*> next;
+	b2Block* blocks;
+};
+
+// The header in front of every chunk. The chunks are only freed by Clear and
+// the destructor.
+struct b2ConcurrentChunk
+{
+	b2ConcurrentChunk* next;
+};
+
+// Keep the blocks as aligned as b2Alloc returns them.
+const int32 b2_chunkHeaderSize = 16;
+
+// Give the caches of each thread cache lines of their own. The stride is rounded
+// up to whole cache lines with at least one line to spare, so threads do not
+// share a line however b2Alloc aligns the caches.
+const int32 b2_cacheLineSize = 64;
+const int32 b2_cacheStride = (int32)(((b2_blockSizes * sizeof(b2BlockCache) + 2 * b2_cacheLineSize - 1)
+	/ b2_cacheLineSize) * b2_cacheLineSize / sizeof(b2BlockCache));
+
+// A stack head packs the top record with a tag that every push increments, so
+// a pop that read a head which was popped and pushed again fails its exchange.
+// User space addresses fit in 48 bits on 64 bit targets.
+const int32 b2_tagShift = sizeof(void*) == 8 ? 48 : 32;
+const uint64_t b2_pointerMask = (uint64_t(1) << b2_tagShift) - 1;
+
+static inline b2Magazine* b2GetTop(uint64_t head)
+{
+	return (b2Magazine*)(uintptr_t)(head & b2_pointerMask);
+}
+
+static void b2PushMagazine(std::atomic<uint64_t>* head, b2Magazine* magazine)
+{
+	b2Assert(((uint64_t)(uintptr_t)magazine & ~b2_pointerMask) == 0);
+
+	uint64_t oldHead = head->load(std::memory_order_relaxed);
+	uint64_t newHead;
+	do
+	{
+		magazine->next.store(b2GetTop(oldHead), std::memory_order_relaxed);
+		uint64_t tag = (oldHead >> b2_tagShift) + 1;
+		newHead = (tag << b2_tagShift) | (uint64_t)(uintptr_t)magazine;
+	}
+	while (head->compare_exchange_weak(oldHead, newHead, std::memory_order_release, std::memory_order_relaxed) == false);
+}
+
+static b2Magazine* b2PopMagazine(std::atomic<uint64_t>* head)
+{
+	uint64_t oldHead = head->load(std::memory_order_acquire);
+	for (;;)
+	{
+		b2Magazine* top = b2GetTop(oldHead);
+		if (top == nullptr)
+		{
+			return nullptr;
+		}
+
+		// Keep the tag so the head of an emptied stack is not reused as is.
+		b2Magazine* next = top->next.load(std::memory_order_relaxed);
+		uint64_t newHead = (oldHead & ~b2_pointerMask) | (uint64_t)(uintptr_t)next;
+		if (head->compare_exchange_weak(oldHead, newHead, std::memory_order_acquire, std::memory_order_acquire))
+		{
+			return top;
+		}
+	}
+}
+
+b2ConcurrentBlockAllocator::b2ConcurrentBlockAllocator(int32 threadCount)
+{
+	b2Assert(threadCount > 0);
+
+	b2BlockAllocator::InitializeBlockSizes();
+
+	m_threadCount = threadCount;
+	m_caches = (b2BlockCache*)b2Alloc(threadCount * b2_cacheStride * sizeof(b2BlockCache));
+	memset(m_caches, 0, threadCount * b2_cacheStride * sizeof(b2BlockCache));
+
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		m_magazines[i].store(0, std::memory_order_relaxed);
+	}
+	m_freeMagazines.store(0, std::memory_order_relaxed);
+
+	m_chunks.store(nullptr, std::memory_order_relaxed);
+	m_chunkCount.store(0, std::memory_order_relaxed);
+}
+
+b2ConcurrentBlockAllocator::~b2ConcurrentBlockAllocator()
+{
+	Clear();
+	b2Free(m_caches);
+}
+
+void* b2ConcurrentBlockAllocator::AllocateChunk()
+{
+	b2ConcurrentChunk* chunk = (b2ConcurrentChunk*)b2Alloc(b2_chunkHeaderSize + b2_chunkSize);
+	int8* memory = (int8*)chunk + b2_chunkHeaderSize;
+#if defined(_DEBUG)
+	memset(memory, 0xcd, b2_chunkSize);
+#endif
+
+	b2ConcurrentChunk* next = m_chunks.load(std::memory_order_relaxed);
+	do
+	{
+		chunk->next = next;
+	}
+	while (m_chunks.compare_exchange_weak(next, chunk, std::memory_order_relaxed) == false);
+
+	m_chunkCount.fetch_add(1, std::memory_order_relaxed);
+	return memory;
+}
+
+void b2ConcurrentBlockAllocator::Refill(b2BlockCache* cache, int32 index)
+{
+	b2Assert(cache->blocks == nullptr);
+
+	if (cache->spare)
+	{
+		cache->blocks = cache->spare;
+		cache->spare = nullptr;
+		return;
+	}
+
+	b2Magazine* magazine = b2PopMagazine(m_magazines + index);
+	if (magazine)
+	{
+		cache->blocks = magazine->blocks;
+		b2PushMagazine(&m_freeMagazines, magazine);
+		return;
+	}
+
+	// Link a new chunk as magazines. The thread keeps the first, which holds
+	// the blocks that do not fill a magazine, and shares the others.
+	int8* memory = (int8*)AllocateChunk();
+	int32 blockSize = b2BlockAllocator::s_blockSizes[index];
+	int32 blockCount = b2_chunkSize / blockSize;
+	b2Assert(blockCount * blockSize <= b2_chunkSize);
+
+	int32 count = blockCount - ((blockCount - 1) / b2_magazineSize) * b2_magazineSize;
+	for (int32 begin = 0; begin < blockCount; begin += count, count = b2_magazineSize)
+	{
+		for (int32 i = begin; i < begin + count; ++i)
+		{
+			b2Block* block = (b2Block*)(memory + blockSize * i);
+			block->next = (b2Block*)(memory + blockSize * (i + 1));
+			block->count = begin + count - i;
+		}
+		b2Block* last = (b2Block*)(memory + blockSize * (begin + count - 1));
+		last->next = nullptr;
+
+		b2Block* first = (b2Block*)(memory + blockSize * begin);
+		if (begin == 0)
+		{
+			cache->blocks = first;
+		}
+		else
+		{
+			Share(first, index);
+		}
+	}
+}
+
+void b2ConcurrentBlockAllocator::Share(b2Block* blocks, int32 index)
+{
+	b2Magazine* magazine = b2PopMagazine(&m_freeMagazines);
+	if (magazine == nullptr)
+	{
+		// Carve a chunk into magazine records and keep the first.
+		magazine = (b2Magazine*)AllocateChunk();
+		int32 magazineCount = b2_chunkSize / sizeof(b2Magazine);
+		for (int32 i = 1; i < magazineCount; ++i)
+		{
+			b2PushMagazine(&m_freeMagazines, new (magazine + i) b2Magazine);
+		}
+		new (magazine) b2Magazine;
+	}
+
+	magazine->blocks = blocks;
+	b2PushMagazine(m_magazines + index, magazine);
+}
+
+void* b2ConcurrentBlockAllocator::Allocate(int32 size, int32 threadIndex)
+{
+	if (size == 0)
+		return nullptr;
+
+	b2Assert(0 < size);
+	b2Assert(0 <= threadIndex && threadIndex < m_threadCount);
+
+	if (size > b2_maxBlockSize)
+	{
+		return b2Alloc(size);
+	}
+
+	int32 index = b2BlockAllocator::s_blockSizeLookup[size];
+	b2Assert(0 <= index && index < b2_blockSizes);
+
+	b2BlockCache* cache = m_caches + threadIndex * b2_cacheStride + index;
+	if (cache->blocks == nullptr)
+	{
+		Refill(cache, index);
+	}
+
+	b2Block* block = cache->blocks;
+	cache->blocks = block->next;
+	return block;
+}
+
+void b2ConcurrentBlockAllocator::Free(void* p, int32 size, int32 threadIndex)
+{
+	if (size == 0)
+	{
+		return;
+	}
+
+	b2Assert(0 < size);
+	b2Assert(0 <= threadIndex && threadIndex < m_threadCount);
+
+	if (size > b2_maxBlockSize)
+	{
+		b2Free(p);
+		return;
+	}
+
+	int32 index = b2BlockAllocator::s_blockSizeLookup[size];
+	b2Assert(0 <= index && index < b2_blockSizes);
+
+#ifdef _DEBUG
+	memset(p, 0xfd, b2BlockAllocator::s_blockSizes[index]);
+#endif
+
+	b2BlockCache* cache = m_caches + threadIndex * b2_cacheStride + index;
+	b2Block* next = cache->blocks;
+	int32 count = next ? next->count : 0;
+	if (count == b2_magazineSize)
+	{
+		// Keep the full magazine as the spare so a thread that alternates
+		// between allocating and freeing does not trade a magazine every time.
+		if (cache->spare)
+		{
+			Share(cache->spare, index);
+		}
+		cache->spare = next;
+		next = nullptr;
+		count = 0;
+	}
+
+	b2Block* block = (b2Block*)p;
+	block->next = next;
+	block->count = count + 1;
+	cache->blocks = block;
+}
+
+void b2ConcurrentBlockAllocator::Clear()
+{
+	b2ConcurrentChunk* chunk = m_chunks.load(std::memory_order_relaxed);
+	while (chunk)
+	{
+		b2ConcurrentChunk* next = chunk->next;
+		b2Free(chunk);
+		chunk = next;
+	}
+
+	m_chunks.store(nullptr, std::memory_order_relaxed);
+	m_chunkCount.store(0, std::memory_order_relaxed);
+
+	memset(m_caches, 0, m_threadCount * b2_cacheStride * sizeof(b2BlockCache));
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		m_magazines[i].store(0, std::memory_order_relaxed);
+	}
+	m_freeMagazines.store(0, std::memory_order_relaxed);
+}
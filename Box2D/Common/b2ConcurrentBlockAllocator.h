@@ -0,0 +1,82 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_CONCURRENT_BLOCK_ALLOCATOR_H
+#define B2_CONCURRENT_BLOCK_ALLOCATOR_H
+
+#include "Box2D/Common/b2BlockAllocator.h"
+
+#include <atomic>
+#include <stdint.h>
+
+/// The number of blocks a thread moves to or from the shared pool at once.
+const int32 b2_magazineSize = 32;
+
+struct b2Block;
+struct b2BlockCache;
+struct b2ConcurrentChunk;
+
+/// A small object allocator that several threads can use at the same time. It
+/// has the block sizes of b2BlockAllocator. Each thread keeps its own free
+/// blocks, up to two magazines of b2_magazineSize blocks per block size, and
+/// only touches shared state to trade a full magazine with a lock-free pool or
+/// to add a chunk. A block may be freed by a different thread than the one
+/// that allocated it.
+class b2ConcurrentBlockAllocator
+{
+public:
+	/// @param threadCount the number of threads, such as b2ThreadPool::GetThreadCount().
+	b2ConcurrentBlockAllocator(int32 threadCount);
+	~b2ConcurrentBlockAllocator();
+
+	/// Get the number of threads.
+	int32 GetThreadCount() const { return m_threadCount; }
+
+	/// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
+	/// @param threadIndex the calling thread in [0, GetThreadCount()). Two threads
+	/// must not use the same index at the same time.
+	void* Allocate(int32 size, int32 threadIndex);
+
+	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
+	void Free(void* p, int32 size, int32 threadIndex);
+
+	/// Free all chunks. No other thread may use the allocator during this.
+	void Clear();
+
+	/// Get the number of chunks allocated so far.
+	int32 GetChunkCount() const { return m_chunkCount.load(std::memory_order_relaxed); }
+
+private:
+
+	void Refill(b2BlockCache* cache, int32 index);
+	void Share(b2Block* blocks, int32 index);
+	void* AllocateChunk();
+
+	int32 m_threadCount;
+	b2BlockCache* m_caches;
+
+	// Tagged heads of the full magazines per block size and of the unused
+	// magazine records.
+	std::atomic<uint64_t> m_magazines[b2_blockSizes];
+	std::atomic<uint64_t> m_freeMagazines;
+
+	std::atomic<b2ConcurrentChunk*> m_chunks;
+	std::atomic<int32> m_chunkCount;
+};
+
+#endif
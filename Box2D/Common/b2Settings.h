@@ -67,6 +67,11 @@ typedef double float64;
 /// This is a dimensionless multiplier.
 #define b2_aabbMultiplier 2.0f
 
+/// When at least this many proxies were added to a broad-phase tree since it was
+/// last built, and they make up at least a quarter of the tree, the tree is rebuilt
+/// from scratch instead of keeping the incrementally built one.
+#define b2_treeRebuildCount 64
+
 /// A small length used as a collision and constraint tolerance. Usually it is
 /// chosen to be numerically significant, but visually insignificant.
 #define b2_linearSlop 0.005f
@@ -83,6 +88,10 @@ typedef double float64;
 /// Maximum number of sub-steps per contact in continuous physics simulation.
 #define b2_maxSubSteps 8
 
+/// A tolerance for the manifold cache that keeps resting contacts well inside the
+/// linear slop. See b2World::SetManifoldCacheTolerance.
+#define b2_manifoldCacheTolerance (0.1f * b2_linearSlop)
+
 // Dynamics
 
 /// Maximum number of contacts to be handled to solve a TOI impact.
@@ -0,0 +1,334 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include "Box2D/Common/b2Settings.h"
+
+/// @file
+/// A minimal wide float type for solvers that work on several constraints at
+/// once. AVX gives 8 lanes, SSE2 gives 4 lanes and other targets fall back to 4
+/// scalar lanes. Loads and stores are unaligned.
+///
+/// b2Float4 always has 4 lanes, for data laid out in fours such as the nodes
+/// of b2WideTree.
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define b2_simdWidth 8
+#define B2_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define b2_simdWidth 4
+#define B2_SIMD_SSE2
+#else
+#define b2_simdWidth 4
+#endif
+
+#if defined(B2_SIMD_AVX)
+
+struct b2FloatW
+{
+	__m256 v;
+};
+
+inline b2FloatW b2MakeW(__m256 v) { b2FloatW r; r.v = v; return r; }
+inline b2FloatW b2ZeroW() { return b2MakeW(_mm256_setzero_ps()); }
+inline b2FloatW b2SplatW(float32 a) { return b2MakeW(_mm256_set1_ps(a)); }
+inline b2FloatW b2LoadW(const float32* p) { return b2MakeW(_mm256_loadu_ps(p)); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm256_storeu_ps(p, a.v); }
+inline b2FloatW operator+(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_add_ps(a.v, b.v)); }
+inline b2FloatW operator-(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_sub_ps(a.v, b.v)); }
+inline b2FloatW operator*(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_mul_ps(a.v, b.v)); }
+inline b2FloatW operator/(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_div_ps(a.v, b.v)); }
+inline b2FloatW operator-(b2FloatW a) { return b2MakeW(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_min_ps(a.v, b.v)); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_max_ps(a.v, b.v)); }
+
+/// All bits set in the lanes where a >= b.
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+inline b2FloatW b2EqualW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_and_ps(a.v, b.v)); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_or_ps(a.v, b.v)); }
+
+/// The lanes of mask a where mask b is not set.
+inline b2FloatW b2AndNotW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm256_andnot_ps(b.v, a.v)); }
+
+/// Is the mask set in any lane?
+inline bool b2AnyW(b2FloatW mask) { return _mm256_movemask_ps(mask.v) != 0; }
+
+/// Select b in the lanes where the mask is set, otherwise a. This is spelled
+/// with bitwise ops because GCC turns blendv into a sign test on integers, which
+/// AVX without AVX2 can only do one lane at a time.
+inline b2FloatW b2BlendW(b2FloatW a, b2FloatW b, b2FloatW mask)
+{
+	return b2MakeW(_mm256_or_ps(_mm256_and_ps(mask.v, b.v), _mm256_andnot_ps(mask.v, a.v)));
+}
+
+#elif defined(B2_SIMD_SSE2)
+
+struct b2FloatW
+{
+	__m128 v;
+};
+
+inline b2FloatW b2MakeW(__m128 v) { b2FloatW r; r.v = v; return r; }
+inline b2FloatW b2ZeroW() { return b2MakeW(_mm_setzero_ps()); }
+inline b2FloatW b2SplatW(float32 a) { return b2MakeW(_mm_set1_ps(a)); }
+inline b2FloatW b2LoadW(const float32* p) { return b2MakeW(_mm_loadu_ps(p)); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a.v); }
+inline b2FloatW operator+(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_add_ps(a.v, b.v)); }
+inline b2FloatW operator-(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_sub_ps(a.v, b.v)); }
+inline b2FloatW operator*(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_mul_ps(a.v, b.v)); }
+inline b2FloatW operator/(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_div_ps(a.v, b.v)); }
+inline b2FloatW operator-(b2FloatW a) { return b2MakeW(_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_min_ps(a.v, b.v)); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_max_ps(a.v, b.v)); }
+
+/// All bits set in the lanes where a >= b.
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_cmpge_ps(a.v, b.v)); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_cmpgt_ps(a.v, b.v)); }
+inline b2FloatW b2EqualW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_cmpeq_ps(a.v, b.v)); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_and_ps(a.v, b.v)); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_or_ps(a.v, b.v)); }
+
+/// The lanes of mask a where mask b is not set.
+inline b2FloatW b2AndNotW(b2FloatW a, b2FloatW b) { return b2MakeW(_mm_andnot_ps(b.v, a.v)); }
+
+/// Is the mask set in any lane?
+inline bool b2AnyW(b2FloatW mask) { return _mm_movemask_ps(mask.v) != 0; }
+
+/// Select b in the lanes where the mask is set, otherwise a.
+inline b2FloatW b2BlendW(b2FloatW a, b2FloatW b, b2FloatW mask)
+{
+	return b2MakeW(_mm_or_ps(_mm_and_ps(mask.v, b.v), _mm_andnot_ps(mask.v, a.v)));
+}
+
+#else
+
+struct b2FloatW
+{
+	float32 v[b2_simdWidth];
+};
+
+inline b2FloatW b2ZeroW()
+{
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) { r.v[i] = 0.0f; }
+	return r;
+}
+
+inline b2FloatW b2SplatW(float32 a)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) { r.v[i] = a; }
+	return r;
+}
+
+inline b2FloatW b2LoadW(const float32* p)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < b2_simdWidth; ++i) { r.v[i] = p[i]; }
+	return r;
+}
+
+inline void b2StoreW(float32* p, b2FloatW a)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { p[i] = a.v[i]; }
+}
+
+inline b2FloatW operator+(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] += b.v[i]; }
+	return a;
+}
+
+inline b2FloatW operator-(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] -= b.v[i]; }
+	return a;
+}
+
+inline b2FloatW operator*(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] *= b.v[i]; }
+	return a;
+}
+
+inline b2FloatW operator/(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] /= b.v[i]; }
+	return a;
+}
+
+inline b2FloatW operator-(b2FloatW a)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = -a.v[i]; }
+	return a;
+}
+
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; }
+	return a;
+}
+
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; }
+	return a;
+}
+
+/// Non-zero in the lanes where a >= b.
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = a.v[i] >= b.v[i] ? 1.0f : 0.0f; }
+	return a;
+}
+
+/// Non-zero in the lanes where a > b.
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = a.v[i] > b.v[i] ? 1.0f : 0.0f; }
+	return a;
+}
+
+/// Non-zero in the lanes where a == b.
+inline b2FloatW b2EqualW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = a.v[i] == b.v[i] ? 1.0f : 0.0f; }
+	return a;
+}
+
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = (a.v[i] != 0.0f && b.v[i] != 0.0f) ? 1.0f : 0.0f; }
+	return a;
+}
+
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = (a.v[i] != 0.0f || b.v[i] != 0.0f) ? 1.0f : 0.0f; }
+	return a;
+}
+
+/// The lanes of mask a where mask b is not set.
+inline b2FloatW b2AndNotW(b2FloatW a, b2FloatW b)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = (a.v[i] != 0.0f && b.v[i] == 0.0f) ? 1.0f : 0.0f; }
+	return a;
+}
+
+/// Is the mask set in any lane?
+inline bool b2AnyW(b2FloatW mask)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		if (mask.v[i] != 0.0f)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/// Select b in the lanes where the mask is set, otherwise a.
+inline b2FloatW b2BlendW(b2FloatW a, b2FloatW b, b2FloatW mask)
+{
+	for (int32 i = 0; i < b2_simdWidth; ++i) { a.v[i] = mask.v[i] != 0.0f ? b.v[i] : a.v[i]; }
+	return a;
+}
+
+#endif
+
+#if defined(B2_SIMD_AVX) || defined(B2_SIMD_SSE2)
+
+struct b2Float4
+{
+	__m128 v;
+};
+
+inline b2Float4 b2Make4(__m128 v) { b2Float4 r; r.v = v; return r; }
+inline b2Float4 b2Splat4(float32 a) { return b2Make4(_mm_set1_ps(a)); }
+inline b2Float4 b2Load4(const float32* p) { return b2Make4(_mm_loadu_ps(p)); }
+inline b2Float4 operator+(b2Float4 a, b2Float4 b) { return b2Make4(_mm_add_ps(a.v, b.v)); }
+inline b2Float4 operator-(b2Float4 a, b2Float4 b) { return b2Make4(_mm_sub_ps(a.v, b.v)); }
+inline b2Float4 operator*(b2Float4 a, b2Float4 b) { return b2Make4(_mm_mul_ps(a.v, b.v)); }
+inline b2Float4 b2Abs4(b2Float4 a) { return b2Make4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+
+/// One bit per lane where a <= b, lane 0 in the lowest bit.
+inline int32 b2LessEqual4(b2Float4 a, b2Float4 b) { return _mm_movemask_ps(_mm_cmple_ps(a.v, b.v)); }
+
+#else
+
+struct b2Float4
+{
+	float32 v[4];
+};
+
+inline b2Float4 b2Splat4(float32 a)
+{
+	b2Float4 r;
+	for (int32 i = 0; i < 4; ++i) { r.v[i] = a; }
+	return r;
+}
+
+inline b2Float4 b2Load4(const float32* p)
+{
+	b2Float4 r;
+	for (int32 i = 0; i < 4; ++i) { r.v[i] = p[i]; }
+	return r;
+}
+
+inline b2Float4 operator+(b2Float4 a, b2Float4 b)
+{
+	for (int32 i = 0; i < 4; ++i) { a.v[i] += b.v[i]; }
+	return a;
+}
+
+inline b2Float4 operator-(b2Float4 a, b2Float4 b)
+{
+	for (int32 i = 0; i < 4; ++i) { a.v[i] -= b.v[i]; }
+	return a;
+}
+
+inline b2Float4 operator*(b2Float4 a, b2Float4 b)
+{
+	for (int32 i = 0; i < 4; ++i) { a.v[i] *= b.v[i]; }
+	return a;
+}
+
+inline b2Float4 b2Abs4(b2Float4 a)
+{
+	for (int32 i = 0; i < 4; ++i) { a.v[i] = a.v[i] < 0.0f ? -a.v[i] : a.v[i]; }
+	return a;
+}
+
+/// One bit per lane where a <= b, lane 0 in the lowest bit.
+inline int32 b2LessEqual4(b2Float4 a, b2Float4 b)
+{
+	int32 mask = 0;
+	for (int32 i = 0; i < 4; ++i) { mask |= (a.v[i] <= b.v[i] ? 1 : 0) << i; }
+	return mask;
+}
+
+#endif
+
+#endif
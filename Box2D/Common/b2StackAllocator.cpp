@@ -19,40 +19,101 @@
 #include "Box2D/Common/b2StackAllocator.h"
 #include "Box2D/Common/b2Math.h"
 
+// Double a segment capacity without overflowing.
+static int32 b2GrowCapacity(int32 capacity)
+{
+	const int32 maxCapacity = 0x7fffffff;
+	return capacity < maxCapacity / 2 ? 2 * capacity : maxCapacity;
+}
+
 b2StackAllocator::b2StackAllocator()
 {
-	m_index = 0;
+	m_segments[0].data = m_data;
+	m_segments[0].capacity = b2_stackSize;
+	m_segments[0].index = 0;
+	m_segmentCount = 1;
+
 	m_allocation = 0;
 	m_maxAllocation = 0;
+	m_peakAllocation = 0;
+	m_overflowCount = 0;
 	m_entryCount = 0;
 }
 
 b2StackAllocator::~b2StackAllocator()
 {
-	b2Assert(m_index == 0);
+	b2Assert(m_allocation == 0);
 	b2Assert(m_entryCount == 0);
+
+	for (int32 i = 1; i < m_segmentCount; ++i)
+	{
+		b2Free(m_segments[i].data);
+	}
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
 	b2Assert(m_entryCount < b2_maxStackEntries);
 
+	// Keep every allocation aligned for pointers and doubles.
+	size = (size + 7) & ~7;
+
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+
+	// Allocate after the top entry. The segments past it are empty.
+	int32 index = m_entryCount > 0 ? m_entries[m_entryCount - 1].segment : 0;
+	if (index < b2_maxStackSegments && size > m_segments[index].capacity - m_segments[index].index)
 	{
-		entry->data = (char*)b2Alloc(size);
-		entry->usedMalloc = true;
+		++index;
+		if (index < b2_maxStackSegments)
+		{
+			b2StackSegment* segment = m_segments + index;
+			b2Assert(index == m_segmentCount || segment->index == 0);
+
+			if (index == m_segmentCount || segment->capacity < size)
+			{
+				// Grow geometrically so a slowly growing allocation does not
+				// replace the segment every step.
+				int32 capacity = b2GrowCapacity(m_segments[index - 1].capacity);
+				if (index < m_segmentCount)
+				{
+					capacity = b2Max(capacity, b2GrowCapacity(segment->capacity));
+					b2Free(segment->data);
+				}
+				else
+				{
+					++m_segmentCount;
+				}
+				capacity = b2Max(capacity, size);
+
+				segment->data = (char*)b2Alloc(capacity);
+				segment->capacity = capacity;
+				segment->index = 0;
+				++m_overflowCount;
+			}
+		}
+	}
+
+	if (index < b2_maxStackSegments)
+	{
+		b2StackSegment* segment = m_segments + index;
+		entry->data = segment->data + segment->index;
+		segment->index += size;
 	}
 	else
 	{
-		entry->data = m_data + m_index;
-		entry->usedMalloc = false;
-		m_index += size;
+		// Out of segments. Fall back to b2Alloc like the stack did before it
+		// had segments.
+		index = b2_maxStackSegments;
+		entry->data = (char*)b2Alloc(size);
+		++m_overflowCount;
 	}
+	entry->segment = index;
 
 	m_allocation += size;
 	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
+	m_peakAllocation = b2Max(m_peakAllocation, m_allocation);
 	++m_entryCount;
 
 	return entry->data;
@@ -63,13 +124,13 @@ void b2StackAllocator::Free(void* p)
 	b2Assert(m_entryCount > 0);
 	b2StackEntry* entry = m_entries + m_entryCount - 1;
 	b2Assert(p == entry->data);
-	if (entry->usedMalloc)
+	if (entry->segment < b2_maxStackSegments)
 	{
-		b2Free(p);
+		m_segments[entry->segment].index -= entry->size;
 	}
 	else
 	{
-		m_index -= entry->size;
+		b2Free(p);
 	}
 	m_allocation -= entry->size;
 	--m_entryCount;
@@ -81,3 +142,9 @@ int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+void b2StackAllocator::ResetStatistics()
+{
+	m_peakAllocation = m_allocation;
+	m_overflowCount = 0;
+}
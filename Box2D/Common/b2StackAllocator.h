@@ -23,17 +23,30 @@
 
 const int32 b2_stackSize = 100 * 1024;	// 100k
 const int32 b2_maxStackEntries = 32;
+const int32 b2_maxStackSegments = 16;
 
 struct b2StackEntry
 {
 	char* data;
 	int32 size;
-	bool usedMalloc;
+	int32 segment;
+};
+
+struct b2StackSegment
+{
+	char* data;
+	int32 capacity;
+	int32 index;
 };
 
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// When an allocation does not fit, the stack continues in a new segment
+// of at least twice the size of the last one. Segments are kept, so once
+// the stack has grown to the size a world needs it no longer uses b2Alloc.
+// Once all b2_maxStackSegments segments are in use, allocations fall back to
+// b2Alloc.
 class b2StackAllocator
 {
 public:
@@ -45,13 +58,26 @@ public:
 
 	int32 GetMaxAllocation() const;
 
+	/// Get the most bytes allocated at once since the last ResetStatistics.
+	int32 GetPeakAllocation() const { return m_peakAllocation; }
+
+	/// Get the number of allocations since the last ResetStatistics that
+	/// had to add a segment.
+	int32 GetOverflowCount() const { return m_overflowCount; }
+
+	void ResetStatistics();
+
 private:
 
 	char m_data[b2_stackSize];
-	int32 m_index;
+
+	b2StackSegment m_segments[b2_maxStackSegments];
+	int32 m_segmentCount;
 
 	int32 m_allocation;
 	int32 m_maxAllocation;
+	int32 m_peakAllocation;
+	int32 m_overflowCount;
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
@@ -0,0 +1,144 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "Box2D/Common/b2ThreadPool.h"
+#include "Box2D/Common/b2Math.h"
+#include <new>
+
+b2ThreadPool::b2ThreadPool(int32 threadCount)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = int32(std::thread::hardware_concurrency());
+	}
+
+	m_threadCount = b2Max(threadCount, 1);
+	m_task = nullptr;
+	m_count = 0;
+	m_rangeSize = 1;
+	m_next = 0;
+	m_generation = 0;
+	m_busyCount = 0;
+	m_exit = false;
+
+	int32 helperCount = m_threadCount - 1;
+	m_threads = (std::thread*)b2Alloc(b2Max(helperCount, 1) * sizeof(std::thread));
+	for (int32 i = 0; i < helperCount; ++i)
+	{
+		new (m_threads + i) std::thread(&b2ThreadPool::WorkerMain, this, i + 1);
+	}
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_exit = true;
+	}
+	m_startCondition.notify_all();
+
+	int32 helperCount = m_threadCount - 1;
+	for (int32 i = 0; i < helperCount; ++i)
+	{
+		m_threads[i].join();
+		m_threads[i].~thread();
+	}
+
+	b2Free(m_threads);
+}
+
+void b2ThreadPool::ParallelFor(b2ParallelTask* task, int32 count, int32 rangeSize)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	rangeSize = b2Max(rangeSize, 1);
+
+	// Not worth waking the helpers.
+	if (m_threadCount == 1 || count <= rangeSize)
+	{
+		task->Execute(0, count, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		b2Assert(m_task == nullptr);
+		m_task = task;
+		m_count = count;
+		m_rangeSize = rangeSize;
+		m_next = 0;
+		m_busyCount = m_threadCount - 1;
+		++m_generation;
+	}
+	m_startCondition.notify_all();
+
+	Run(0);
+
+	// Wait for the helpers so the task can be released by the caller.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finishCondition.wait(lock, [this] { return m_busyCount == 0; });
+	m_task = nullptr;
+}
+
+void b2ThreadPool::Run(int32 threadIndex)
+{
+	for (;;)
+	{
+		int32 begin = m_next.fetch_add(m_rangeSize);
+		if (begin >= m_count)
+		{
+			break;
+		}
+
+		int32 end = b2Min(begin + m_rangeSize, m_count);
+		m_task->Execute(begin, end, threadIndex);
+	}
+}
+
+void b2ThreadPool::WorkerMain(int32 threadIndex)
+{
+	uint32 generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_startCondition.wait(lock, [this, generation] { return m_exit || m_generation != generation; });
+			if (m_exit)
+			{
+				return;
+			}
+
+			generation = m_generation;
+		}
+
+		Run(threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_busyCount;
+			if (m_busyCount == 0)
+			{
+				m_finishCondition.notify_one();
+			}
+		}
+	}
+}
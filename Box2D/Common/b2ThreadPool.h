@@ -0,0 +1,82 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_THREAD_POOL_H
+#define B2_THREAD_POOL_H
+
+#include "Box2D/Common/b2Settings.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/// A unit of data parallel work. Implement this to run a loop on b2ThreadPool.
+class b2ParallelTask
+{
+public:
+	virtual ~b2ParallelTask() {}
+
+	/// Process the items in [begin, end). This is called concurrently for
+	/// disjoint ranges. The thread index is in [0, b2ThreadPool::GetThreadCount())
+	/// and can be used to select per thread scratch data.
+	virtual void Execute(int32 begin, int32 end, int32 threadIndex) = 0;
+};
+
+/// A pool of persistent worker threads. The thread calling ParallelFor takes
+/// part in the work as thread index 0, so a pool with n threads starts n - 1
+/// helper threads. The threads are reused for every call.
+class b2ThreadPool
+{
+public:
+	/// @param threadCount the number of threads including the calling thread.
+	/// Zero uses the hardware concurrency.
+	b2ThreadPool(int32 threadCount);
+	~b2ThreadPool();
+
+	/// Get the number of threads including the calling thread.
+	int32 GetThreadCount() const { return m_threadCount; }
+
+	/// Run the task over [0, count) in ranges of at most rangeSize items and
+	/// wait for it to complete. This is not reentrant: do not call it from a task.
+	void ParallelFor(b2ParallelTask* task, int32 count, int32 rangeSize);
+
+private:
+
+	void WorkerMain(int32 threadIndex);
+	void Run(int32 threadIndex);
+
+	int32 m_threadCount;
+	std::thread* m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_startCondition;
+	std::condition_variable m_finishCondition;
+
+	b2ParallelTask* m_task;
+	int32 m_count;
+	int32 m_rangeSize;
+	std::atomic<int32> m_next;
+
+	uint32 m_generation;
+	int32 m_busyCount;
+	bool m_exit;
+};
+
+#endif
@@ -46,6 +46,7 @@ void b2Contact::InitializeRegisters()
 	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, b2Shape::e_edge, b2Shape::e_polygon);
 	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, b2Shape::e_chain, b2Shape::e_circle);
 	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, b2Shape::e_chain, b2Shape::e_polygon);
+	s_initialized = true;
 }
 
 void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
@@ -68,11 +69,10 @@ void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* dest
 
 b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
 {
-	if (s_initialized == false)
-	{
-		InitializeRegisters();
-		s_initialized = true;
-	}
+	// A function local static is initialized exactly once, even when worlds
+	// on several threads create their first contact at the same time.
+	static bool registersInitialized = (InitializeRegisters(), true);
+	B2_NOT_USED(registersInitialized);
 
 	b2Shape::Type type1 = fixtureA->GetType();
 	b2Shape::Type type2 = fixtureB->GetType();
@@ -134,6 +134,7 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_indexB = indexB;
 
 	m_manifold.pointCount = 0;
+	m_manifoldXf.SetIdentity();
 
 	m_prev = nullptr;
 	m_next = nullptr;
@@ -149,6 +150,7 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_nodeB.other = nullptr;
 
 	m_toiCount = 0;
+	m_toiCache.count = 0;
 
 	m_friction = b2MixFriction(m_fixtureA->m_friction, m_fixtureB->m_friction);
 	m_restitution = b2MixRestitution(m_fixtureA->m_restitution, m_fixtureB->m_restitution);
@@ -158,15 +160,70 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
-void b2Contact::Update(b2ContactListener* listener)
+void b2Contact::Update(b2ContactListener* listener, float32 tolerance, b2ManifoldCacheStats* stats)
 {
 	b2Manifold oldManifold = m_manifold;
+	bool touching = UpdateManifold(oldManifold, tolerance, stats);
+	ReportUpdate(listener, oldManifold, touching);
+}
+
+// The reference face or circle of the manifold is fixed in its own body frame,
+// so only the incident points move with the relative pose. A point p of body B
+// moves by at most |dp| + chord * |p|, where chord is the distance a unit vector
+// moves under the change of rotation. For e_faceB the incident points belong to
+// body A and are seen from body B, which adds the old offset to the lever arm.
+float32 b2Contact::GetManifoldError(const b2Transform& xf) const
+{
+	b2Vec2 dp = xf.p - m_manifoldXf.p;
+	b2Rot dq = b2MulT(m_manifoldXf.q, xf.q);
+	float32 chord = b2Sqrt(b2Max(2.0f - 2.0f * dq.c, 0.0f));
+
+	float32 radius = 0.0f;
+	for (int32 i = 0; i < m_manifold.pointCount; ++i)
+	{
+		radius = b2Max(radius, m_manifold.points[i].localPoint.Length());
+	}
+
+	if (m_manifold.type == b2Manifold::e_faceB)
+	{
+		radius += m_manifoldXf.p.Length();
+	}
+
+	return dp.Length() + chord * radius;
+}
+
+void b2Contact::UpdateSensors(b2Contact* const* contacts, int32 count, bool* touching)
+{
+	b2DistanceInput inputs[b2_simdWidth];
+	for (int32 i = 0; i < count; i += b2_simdWidth)
+	{
+		int32 n = b2Min(count - i, b2_simdWidth);
+		for (int32 j = 0; j < n; ++j)
+		{
+			b2Contact* c = contacts[i + j];
+
+			// Re-enable this contact. Sensors don't generate manifolds.
+			c->m_flags |= e_enabledFlag;
+			c->m_manifold.pointCount = 0;
+
+			b2DistanceInput* input = inputs + j;
+			input->proxyA.Set(c->m_fixtureA->GetShape(), c->m_indexA);
+			input->proxyB.Set(c->m_fixtureB->GetShape(), c->m_indexB);
+			input->transformA = c->m_fixtureA->GetBody()->GetTransform();
+			input->transformB = c->m_fixtureB->GetBody()->GetTransform();
+			input->useRadii = true;
+		}
+
+		b2TestOverlap(touching + i, inputs, n);
+	}
+}
 
+bool b2Contact::UpdateManifold(const b2Manifold& oldManifold, float32 tolerance, b2ManifoldCacheStats* stats)
+{
 	// Re-enable this contact.
 	m_flags |= e_enabledFlag;
 
 	bool touching = false;
-	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
 
 	bool sensorA = m_fixtureA->IsSensor();
 	bool sensorB = m_fixtureB->IsSensor();
@@ -180,16 +237,30 @@ void b2Contact::Update(b2ContactListener* listener)
 	// Is this contact a sensor?
 	if (sensor)
 	{
-		const b2Shape* shapeA = m_fixtureA->GetShape();
-		const b2Shape* shapeB = m_fixtureB->GetShape();
-		touching = b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
-
-		// Sensors don't generate manifolds.
-		m_manifold.pointCount = 0;
+		b2Contact* contact = this;
+		UpdateSensors(&contact, 1, &touching);
 	}
 	else
 	{
+		b2Transform xf = b2MulT(xfA, xfB);
+
+		// Keep a touching manifold while the bodies have barely moved relative
+		// to each other. It still holds the impulses the solver stored.
+		if (tolerance > 0.0f && m_manifold.pointCount > 0)
+		{
+			float32 error = GetManifoldError(xf);
+			if (error < tolerance)
+			{
+				++stats->hits;
+				stats->maxError = b2Max(stats->maxError, error);
+				return true;
+			}
+
+			++stats->misses;
+		}
+
 		Evaluate(&m_manifold, xfA, xfB);
+		m_manifoldXf = xf;
 		touching = m_manifold.pointCount > 0;
 
 		// Match old contact ids to new contact ids and copy the
@@ -203,7 +274,7 @@ void b2Contact::Update(b2ContactListener* listener)
 
 			for (int32 j = 0; j < oldManifold.pointCount; ++j)
 			{
-				b2ManifoldPoint* mp1 = oldManifold.points + j;
+				const b2ManifoldPoint* mp1 = oldManifold.points + j;
 
 				if (mp1->id.key == id2.key)
 				{
@@ -213,12 +284,21 @@ void b2Contact::Update(b2ContactListener* listener)
 				}
 			}
 		}
+	}
 
-		if (touching != wasTouching)
-		{
-			bodyA->SetAwake(true);
-			bodyB->SetAwake(true);
-		}
+	return touching;
+}
+
+void b2Contact::ReportUpdate(b2ContactListener* listener, const b2Manifold& oldManifold, bool touching)
+{
+	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
+
+	bool sensor = m_fixtureA->IsSensor() || m_fixtureB->IsSensor();
+
+	if (sensor == false && touching != wasTouching)
+	{
+		m_fixtureA->GetBody()->SetAwake(true);
+		m_fixtureB->GetBody()->SetAwake(true);
 	}
 
 	if (touching)
@@ -21,8 +21,10 @@
 
 #include "Box2D/Common/b2Math.h"
 #include "Box2D/Collision/b2Collision.h"
+#include "Box2D/Collision/b2Distance.h"
 #include "Box2D/Collision/Shapes/b2Shape.h"
 #include "Box2D/Dynamics/b2Fixture.h"
+#include "Box2D/Dynamics/b2TimeStep.h"
 
 class b2Body;
 class b2Contact;
@@ -187,7 +189,24 @@ protected:
 	b2Contact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	virtual ~b2Contact() {}
 
-	void Update(b2ContactListener* listener);
+	// A touching manifold is kept if the error bound of keeping it is below
+	// tolerance. Zero always evaluates. The stats may be null then.
+	void Update(b2ContactListener* listener, float32 tolerance, b2ManifoldCacheStats* stats);
+
+	// The two halves of Update. UpdateManifold only writes to this contact and
+	// the stats, so contacts can be updated in parallel. ReportUpdate wakes the
+	// bodies and calls the listener.
+	bool UpdateManifold(const b2Manifold& oldManifold, float32 tolerance, b2ManifoldCacheStats* stats);
+	void ReportUpdate(b2ContactListener* listener, const b2Manifold& oldManifold, bool touching);
+
+	// The sensor part of UpdateManifold for count sensor contacts, with batched
+	// overlap tests. Sensors don't generate manifolds, so this clears them and
+	// writes whether the shapes of each contact overlap to touching.
+	static void UpdateSensors(b2Contact* const* contacts, int32 count, bool* touching);
+
+	// Bound how far the points of the manifold can be from those of a manifold
+	// evaluated at the relative pose xf.
+	float32 GetManifoldError(const b2Transform& xf) const;
 
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
@@ -210,9 +229,15 @@ protected:
 
 	b2Manifold m_manifold;
 
+	// The pose of body B relative to body A when the manifold was evaluated.
+	b2Transform m_manifoldXf;
+
 	int32 m_toiCount;
 	float32 m_toi;
 
+	// The last simplex of the time of impact, which warm starts the next one.
+	b2SimplexCache m_toiCache;
+
 	float32 m_friction;
 	float32 m_restitution;
 
@@ -23,6 +23,7 @@
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Dynamics/b2World.h"
 #include "Box2D/Common/b2StackAllocator.h"
+#include "Box2D/Common/b2Simd.h"
 
 // Solver debugging is normally disabled because the block solver sometimes has to deal with a poorly conditioned effective mass matrix.
 #define B2_DEBUG_SOLVER 0
@@ -55,6 +56,16 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 	m_velocities = def->velocities;
 	m_contacts = def->contacts;
 
+	const b2ConstraintGraph* graph = def->graph;
+	m_order = graph != nullptr ? graph->m_contactOrder : nullptr;
+	m_colorStarts = graph != nullptr ? graph->m_contactStarts : nullptr;
+	m_colorCount = graph != nullptr ? graph->m_contactColorCount : 0;
+	b2Assert(graph == nullptr || graph->m_contactCount == m_count);
+
+	m_wide = m_step.wideContactSolver && graph != nullptr;
+	m_batches = nullptr;
+	m_batchCount = 0;
+
 	// Initialize position independent portions of the constraints.
 	for (int32 i = 0; i < m_count; ++i)
 	{
@@ -77,8 +88,8 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		vc->friction = contact->m_friction;
 		vc->restitution = contact->m_restitution;
 		vc->tangentSpeed = contact->m_tangentSpeed;
-		vc->indexA = bodyA->m_islandIndex;
-		vc->indexB = bodyB->m_islandIndex;
+		vc->indexA = bodyA->m_stateIndex;
+		vc->indexB = bodyB->m_stateIndex;
 		vc->invMassA = bodyA->m_invMass;
 		vc->invMassB = bodyB->m_invMass;
 		vc->invIA = bodyA->m_invI;
@@ -89,12 +100,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 		vc->normalMass.SetZero();
 
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
-		pc->indexA = bodyA->m_islandIndex;
-		pc->indexB = bodyB->m_islandIndex;
+		pc->indexA = bodyA->m_stateIndex;
+		pc->indexB = bodyB->m_stateIndex;
 		pc->invMassA = bodyA->m_invMass;
 		pc->invMassB = bodyB->m_invMass;
-		pc->localCenterA = bodyA->m_sweep.localCenter;
-		pc->localCenterB = bodyB->m_sweep.localCenter;
+		pc->localCenterA = bodyA->m_localCenter;
+		pc->localCenterB = bodyB->m_localCenter;
 		pc->invIA = bodyA->m_invI;
 		pc->invIB = bodyB->m_invI;
 		pc->localNormal = manifold->localNormal;
@@ -133,6 +144,11 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_batches != nullptr)
+	{
+		m_allocator->Free(m_batches);
+	}
+
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
@@ -247,14 +263,56 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			}
 		}
 	}
+
+	if (m_wide)
+	{
+		InitializeWide();
+	}
+}
+
+int32 b2ContactSolver::GetGroupSize(int32 group) const
+{
+	b2Assert(0 <= group && group <= m_colorCount);
+	if (m_order == nullptr)
+	{
+		return m_count;
+	}
+
+	if (group == m_colorCount)
+	{
+		return m_count - m_colorStarts[m_colorCount];
+	}
+
+	if (m_wide)
+	{
+		return m_batchStarts[group + 1] - m_batchStarts[group];
+	}
+
+	return m_colorStarts[group + 1] - m_colorStarts[group];
 }
 
 void b2ContactSolver::WarmStart()
 {
+	for (int32 group = 0; group <= m_colorCount; ++group)
+	{
+		WarmStart(group, 0, GetGroupSize(group));
+	}
+}
+
+void b2ContactSolver::WarmStart(int32 group, int32 begin, int32 end)
+{
+	if (m_wide && group < m_colorCount)
+	{
+		WarmStartWide(m_batchStarts[group] + begin, m_batchStarts[group] + end);
+		return;
+	}
+
+	const int32* order = m_order != nullptr ? m_order + m_colorStarts[group] : nullptr;
+
 	// Warm start.
-	for (int32 i = 0; i < m_count; ++i)
+	for (int32 i = begin; i < end; ++i)
 	{
-		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + (order != nullptr ? order[i] : i);
 
 		int32 indexA = vc->indexA;
 		int32 indexB = vc->indexB;
@@ -282,18 +340,42 @@ void b2ContactSolver::WarmStart()
 			vB += mB * P;
 		}
 
-		m_velocities[indexA].v = vA;
-		m_velocities[indexA].w = wA;
-		m_velocities[indexB].v = vB;
-		m_velocities[indexB].w = wB;
+		// Static and kinematic bodies keep their velocity. Leaving them alone lets
+		// the contacts of a color share them while being solved concurrently.
+		if (mA != 0.0f || iA != 0.0f)
+		{
+			m_velocities[indexA].v = vA;
+			m_velocities[indexA].w = wA;
+		}
+		if (mB != 0.0f || iB != 0.0f)
+		{
+			m_velocities[indexB].v = vB;
+			m_velocities[indexB].w = wB;
+		}
 	}
 }
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
-	for (int32 i = 0; i < m_count; ++i)
+	for (int32 group = 0; group <= m_colorCount; ++group)
 	{
-		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		SolveVelocityConstraints(group, 0, GetGroupSize(group));
+	}
+}
+
+void b2ContactSolver::SolveVelocityConstraints(int32 group, int32 begin, int32 end)
+{
+	if (m_wide && group < m_colorCount)
+	{
+		SolveWideVelocityConstraints(m_batchStarts[group] + begin, m_batchStarts[group] + end);
+		return;
+	}
+
+	const int32* order = m_order != nullptr ? m_order + m_colorStarts[group] : nullptr;
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2ContactVelocityConstraint* vc = m_velocityConstraints + (order != nullptr ? order[i] : i);
 
 		int32 indexA = vc->indexA;
 		int32 indexB = vc->indexB;
@@ -594,15 +676,28 @@ void b2ContactSolver::SolveVelocityConstraints()
 			}
 		}
 
-		m_velocities[indexA].v = vA;
-		m_velocities[indexA].w = wA;
-		m_velocities[indexB].v = vB;
-		m_velocities[indexB].w = wB;
+		// Static and kinematic bodies keep their velocity. Leaving them alone lets
+		// the contacts of a color share them while being solved concurrently.
+		if (mA != 0.0f || iA != 0.0f)
+		{
+			m_velocities[indexA].v = vA;
+			m_velocities[indexA].w = wA;
+		}
+		if (mB != 0.0f || iB != 0.0f)
+		{
+			m_velocities[indexB].v = vB;
+			m_velocities[indexB].w = wB;
+		}
 	}
 }
 
 void b2ContactSolver::StoreImpulses()
 {
+	if (m_wide)
+	{
+		StoreWideImpulses();
+	}
+
 	for (int32 i = 0; i < m_count; ++i)
 	{
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
@@ -616,6 +711,433 @@ void b2ContactSolver::StoreImpulses()
 	}
 }
 
+// The wide solver packs each color of the constraint graph into batches of
+// b2_simdWidth contacts that are solved together, one contact per lane. A color
+// is split by block solver mode so every lane of a batch takes the same path.
+struct b2WideContactBatch
+{
+	int32 constraints[b2_simdWidth];
+	int32 indexA[b2_simdWidth];
+	int32 indexB[b2_simdWidth];
+	int32 laneCount;
+	bool blockSolve;
+
+	float32 invMassA[b2_simdWidth], invIA[b2_simdWidth];
+	float32 invMassB[b2_simdWidth], invIB[b2_simdWidth];
+	float32 normalX[b2_simdWidth], normalY[b2_simdWidth];
+	float32 friction[b2_simdWidth];
+	float32 tangentSpeed[b2_simdWidth];
+
+	float32 rA1X[b2_simdWidth], rA1Y[b2_simdWidth], rB1X[b2_simdWidth], rB1Y[b2_simdWidth];
+	float32 normalImpulse1[b2_simdWidth], tangentImpulse1[b2_simdWidth];
+	float32 normalMass1[b2_simdWidth], tangentMass1[b2_simdWidth];
+	float32 velocityBias1[b2_simdWidth];
+
+	float32 rA2X[b2_simdWidth], rA2Y[b2_simdWidth], rB2X[b2_simdWidth], rB2Y[b2_simdWidth];
+	float32 normalImpulse2[b2_simdWidth], tangentImpulse2[b2_simdWidth];
+	float32 normalMass2[b2_simdWidth], tangentMass2[b2_simdWidth];
+	float32 velocityBias2[b2_simdWidth];
+
+	// Block solver: K = [k11 k12; k12 k22] and normalMass = inv(K).
+	float32 k11[b2_simdWidth], k12[b2_simdWidth], k22[b2_simdWidth];
+	float32 m11[b2_simdWidth], m12[b2_simdWidth], m21[b2_simdWidth], m22[b2_simdWidth];
+};
+
+// The velocities of the bodies in a batch, one lane per constraint.
+struct b2WideBodies
+{
+	b2FloatW vAX, vAY, wA;
+	b2FloatW vBX, vBY, wB;
+};
+
+static void b2GatherBodies(b2WideBodies* bodies, const b2WideContactBatch* batch, const b2Velocity* velocities)
+{
+	float32 vAX[b2_simdWidth], vAY[b2_simdWidth], wA[b2_simdWidth];
+	float32 vBX[b2_simdWidth], vBY[b2_simdWidth], wB[b2_simdWidth];
+
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		if (i < batch->laneCount)
+		{
+			const b2Velocity& a = velocities[batch->indexA[i]];
+			const b2Velocity& b = velocities[batch->indexB[i]];
+			vAX[i] = a.v.x; vAY[i] = a.v.y; wA[i] = a.w;
+			vBX[i] = b.v.x; vBY[i] = b.v.y; wB[i] = b.w;
+		}
+		else
+		{
+			vAX[i] = 0.0f; vAY[i] = 0.0f; wA[i] = 0.0f;
+			vBX[i] = 0.0f; vBY[i] = 0.0f; wB[i] = 0.0f;
+		}
+	}
+
+	bodies->vAX = b2LoadW(vAX);
+	bodies->vAY = b2LoadW(vAY);
+	bodies->wA = b2LoadW(wA);
+	bodies->vBX = b2LoadW(vBX);
+	bodies->vBY = b2LoadW(vBY);
+	bodies->wB = b2LoadW(wB);
+}
+
+static void b2ScatterBodies(b2Velocity* velocities, const b2WideContactBatch* batch, const b2WideBodies* bodies)
+{
+	float32 vAX[b2_simdWidth], vAY[b2_simdWidth], wA[b2_simdWidth];
+	float32 vBX[b2_simdWidth], vBY[b2_simdWidth], wB[b2_simdWidth];
+	b2StoreW(vAX, bodies->vAX);
+	b2StoreW(vAY, bodies->vAY);
+	b2StoreW(wA, bodies->wA);
+	b2StoreW(vBX, bodies->vBX);
+	b2StoreW(vBY, bodies->vBY);
+	b2StoreW(wB, bodies->wB);
+
+	// Static and kinematic bodies can be shared by several lanes and keep
+	// their velocity, so they are not written.
+	for (int32 i = 0; i < batch->laneCount; ++i)
+	{
+		if (batch->invMassA[i] != 0.0f || batch->invIA[i] != 0.0f)
+		{
+			b2Velocity& a = velocities[batch->indexA[i]];
+			a.v.Set(vAX[i], vAY[i]);
+			a.w = wA[i];
+		}
+		if (batch->invMassB[i] != 0.0f || batch->invIB[i] != 0.0f)
+		{
+			b2Velocity& b = velocities[batch->indexB[i]];
+			b.v.Set(vBX[i], vBY[i]);
+			b.w = wB[i];
+		}
+	}
+}
+
+// Apply the impulse P at the anchors rA and rB.
+static inline void b2ApplyImpulseW(b2WideBodies* b, b2FloatW mA, b2FloatW iA, b2FloatW mB, b2FloatW iB,
+								   b2FloatW rAX, b2FloatW rAY, b2FloatW rBX, b2FloatW rBY, b2FloatW PX, b2FloatW PY)
+{
+	b->vAX = b->vAX - mA * PX;
+	b->vAY = b->vAY - mA * PY;
+	b->wA = b->wA - iA * (rAX * PY - rAY * PX);
+
+	b->vBX = b->vBX + mB * PX;
+	b->vBY = b->vBY + mB * PY;
+	b->wB = b->wB + iB * (rBX * PY - rBY * PX);
+}
+
+static void b2SetWideLane(b2WideContactBatch* batch, int32 lane, const b2ContactVelocityConstraint* vc, int32 index)
+{
+	const b2VelocityConstraintPoint* cp1 = vc->points + 0;
+
+	batch->constraints[lane] = index;
+	batch->indexA[lane] = vc->indexA;
+	batch->indexB[lane] = vc->indexB;
+	batch->invMassA[lane] = vc->invMassA;
+	batch->invIA[lane] = vc->invIA;
+	batch->invMassB[lane] = vc->invMassB;
+	batch->invIB[lane] = vc->invIB;
+	batch->normalX[lane] = vc->normal.x;
+	batch->normalY[lane] = vc->normal.y;
+	batch->friction[lane] = vc->friction;
+	batch->tangentSpeed[lane] = vc->tangentSpeed;
+
+	batch->rA1X[lane] = cp1->rA.x;
+	batch->rA1Y[lane] = cp1->rA.y;
+	batch->rB1X[lane] = cp1->rB.x;
+	batch->rB1Y[lane] = cp1->rB.y;
+	batch->normalImpulse1[lane] = cp1->normalImpulse;
+	batch->tangentImpulse1[lane] = cp1->tangentImpulse;
+	batch->normalMass1[lane] = cp1->normalMass;
+	batch->tangentMass1[lane] = cp1->tangentMass;
+	batch->velocityBias1[lane] = cp1->velocityBias;
+
+	// A single point leaves the second point zeroed so it never applies an impulse.
+	if (vc->pointCount == 2)
+	{
+		const b2VelocityConstraintPoint* cp2 = vc->points + 1;
+		batch->rA2X[lane] = cp2->rA.x;
+		batch->rA2Y[lane] = cp2->rA.y;
+		batch->rB2X[lane] = cp2->rB.x;
+		batch->rB2Y[lane] = cp2->rB.y;
+		batch->normalImpulse2[lane] = cp2->normalImpulse;
+		batch->tangentImpulse2[lane] = cp2->tangentImpulse;
+		batch->normalMass2[lane] = cp2->normalMass;
+		batch->tangentMass2[lane] = cp2->tangentMass;
+		batch->velocityBias2[lane] = cp2->velocityBias;
+	}
+
+	if (batch->blockSolve)
+	{
+		batch->k11[lane] = vc->K.ex.x;
+		batch->k12[lane] = vc->K.ex.y;
+		batch->k22[lane] = vc->K.ey.y;
+		batch->m11[lane] = vc->normalMass.ex.x;
+		batch->m12[lane] = vc->normalMass.ey.x;
+		batch->m21[lane] = vc->normalMass.ex.y;
+		batch->m22[lane] = vc->normalMass.ey.y;
+	}
+}
+
+void b2ContactSolver::InitializeWide()
+{
+	// Split each color by block solver mode and count the batches.
+	m_batchCount = 0;
+	for (int32 color = 0; color < m_colorCount; ++color)
+	{
+		int32 blockCount = 0;
+		for (int32 i = m_colorStarts[color]; i < m_colorStarts[color + 1]; ++i)
+		{
+			const b2ContactVelocityConstraint* vc = m_velocityConstraints + m_order[i];
+			if (vc->pointCount == 2 && g_blockSolve)
+			{
+				++blockCount;
+			}
+		}
+
+		int32 pointCount = m_colorStarts[color + 1] - m_colorStarts[color] - blockCount;
+		m_batchStarts[color] = m_batchCount;
+		m_batchCount += (pointCount + b2_simdWidth - 1) / b2_simdWidth;
+		m_batchCount += (blockCount + b2_simdWidth - 1) / b2_simdWidth;
+	}
+	m_batchStarts[m_colorCount] = m_batchCount;
+
+	m_batches = (b2WideContactBatch*)m_allocator->Allocate(m_batchCount * sizeof(b2WideContactBatch));
+
+	// Fill the batches in graph order.
+	b2WideContactBatch* batch = m_batches - 1;
+	for (int32 color = 0; color < m_colorCount; ++color)
+	{
+		for (int32 block = 0; block < 2; ++block)
+		{
+			int32 lane = b2_simdWidth;
+			for (int32 i = m_colorStarts[color]; i < m_colorStarts[color + 1]; ++i)
+			{
+				int32 index = m_order[i];
+				const b2ContactVelocityConstraint* vc = m_velocityConstraints + index;
+				if ((vc->pointCount == 2 && g_blockSolve) != (block == 1))
+				{
+					continue;
+				}
+
+				if (lane == b2_simdWidth)
+				{
+					++batch;
+					memset(batch, 0, sizeof(b2WideContactBatch));
+					batch->blockSolve = block == 1;
+					lane = 0;
+				}
+
+				b2SetWideLane(batch, lane, vc, index);
+				batch->laneCount = ++lane;
+			}
+		}
+	}
+	b2Assert(batch + 1 == m_batches + m_batchCount);
+}
+
+void b2ContactSolver::WarmStartWide(int32 begin, int32 end)
+{
+	for (int32 i = begin; i < end; ++i)
+	{
+		const b2WideContactBatch* c = m_batches + i;
+
+		b2WideBodies b;
+		b2GatherBodies(&b, c, m_velocities);
+
+		b2FloatW mA = b2LoadW(c->invMassA), iA = b2LoadW(c->invIA);
+		b2FloatW mB = b2LoadW(c->invMassB), iB = b2LoadW(c->invIB);
+		b2FloatW normalX = b2LoadW(c->normalX), normalY = b2LoadW(c->normalY);
+		b2FloatW tangentX = normalY, tangentY = -normalX;
+
+		{
+			b2FloatW normalImpulse = b2LoadW(c->normalImpulse1);
+			b2FloatW tangentImpulse = b2LoadW(c->tangentImpulse1);
+			b2FloatW PX = normalImpulse * normalX + tangentImpulse * tangentX;
+			b2FloatW PY = normalImpulse * normalY + tangentImpulse * tangentY;
+			b2ApplyImpulseW(&b, mA, iA, mB, iB, b2LoadW(c->rA1X), b2LoadW(c->rA1Y), b2LoadW(c->rB1X), b2LoadW(c->rB1Y), PX, PY);
+		}
+
+		{
+			b2FloatW normalImpulse = b2LoadW(c->normalImpulse2);
+			b2FloatW tangentImpulse = b2LoadW(c->tangentImpulse2);
+			b2FloatW PX = normalImpulse * normalX + tangentImpulse * tangentX;
+			b2FloatW PY = normalImpulse * normalY + tangentImpulse * tangentY;
+			b2ApplyImpulseW(&b, mA, iA, mB, iB, b2LoadW(c->rA2X), b2LoadW(c->rA2Y), b2LoadW(c->rB2X), b2LoadW(c->rB2Y), PX, PY);
+		}
+
+		b2ScatterBodies(m_velocities, c, &b);
+	}
+}
+
+// Relative normal or tangent velocity at a contact point along (dirX, dirY).
+static inline b2FloatW b2RelativeVelocityW(const b2WideBodies& b, b2FloatW rAX, b2FloatW rAY, b2FloatW rBX, b2FloatW rBY,
+										   b2FloatW dirX, b2FloatW dirY)
+{
+	b2FloatW dvX = b.vBX - b.wB * rBY - b.vAX + b.wA * rAY;
+	b2FloatW dvY = b.vBY + b.wB * rBX - b.vAY - b.wA * rAX;
+	return dvX * dirX + dvY * dirY;
+}
+
+void b2ContactSolver::SolveWideVelocityConstraints(int32 begin, int32 end)
+{
+	const b2FloatW zero = b2ZeroW();
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2WideContactBatch* c = m_batches + i;
+
+		b2WideBodies b;
+		b2GatherBodies(&b, c, m_velocities);
+
+		b2FloatW mA = b2LoadW(c->invMassA), iA = b2LoadW(c->invIA);
+		b2FloatW mB = b2LoadW(c->invMassB), iB = b2LoadW(c->invIB);
+		b2FloatW normalX = b2LoadW(c->normalX), normalY = b2LoadW(c->normalY);
+		b2FloatW tangentX = normalY, tangentY = -normalX;
+		b2FloatW friction = b2LoadW(c->friction);
+		b2FloatW tangentSpeed = b2LoadW(c->tangentSpeed);
+
+		b2FloatW rA1X = b2LoadW(c->rA1X), rA1Y = b2LoadW(c->rA1Y), rB1X = b2LoadW(c->rB1X), rB1Y = b2LoadW(c->rB1Y);
+		b2FloatW rA2X = b2LoadW(c->rA2X), rA2Y = b2LoadW(c->rA2Y), rB2X = b2LoadW(c->rB2X), rB2Y = b2LoadW(c->rB2Y);
+		b2FloatW normalImpulse1 = b2LoadW(c->normalImpulse1);
+		b2FloatW normalImpulse2 = b2LoadW(c->normalImpulse2);
+
+		// Solve tangent constraints first because non-penetration is more important
+		// than friction.
+		{
+			b2FloatW vt = b2RelativeVelocityW(b, rA1X, rA1Y, rB1X, rB1Y, tangentX, tangentY) - tangentSpeed;
+			b2FloatW lambda = b2LoadW(c->tangentMass1) * (-vt);
+
+			b2FloatW maxFriction = friction * normalImpulse1;
+			b2FloatW oldImpulse = b2LoadW(c->tangentImpulse1);
+			b2FloatW newImpulse = b2MaxW(-maxFriction, b2MinW(oldImpulse + lambda, maxFriction));
+			lambda = newImpulse - oldImpulse;
+			b2StoreW(c->tangentImpulse1, newImpulse);
+
+			b2ApplyImpulseW(&b, mA, iA, mB, iB, rA1X, rA1Y, rB1X, rB1Y, lambda * tangentX, lambda * tangentY);
+		}
+
+		{
+			b2FloatW vt = b2RelativeVelocityW(b, rA2X, rA2Y, rB2X, rB2Y, tangentX, tangentY) - tangentSpeed;
+			b2FloatW lambda = b2LoadW(c->tangentMass2) * (-vt);
+
+			b2FloatW maxFriction = friction * normalImpulse2;
+			b2FloatW oldImpulse = b2LoadW(c->tangentImpulse2);
+			b2FloatW newImpulse = b2MaxW(-maxFriction, b2MinW(oldImpulse + lambda, maxFriction));
+			lambda = newImpulse - oldImpulse;
+			b2StoreW(c->tangentImpulse2, newImpulse);
+
+			b2ApplyImpulseW(&b, mA, iA, mB, iB, rA2X, rA2Y, rB2X, rB2Y, lambda * tangentX, lambda * tangentY);
+		}
+
+		// Solve normal constraints
+		if (c->blockSolve == false)
+		{
+			{
+				b2FloatW vn = b2RelativeVelocityW(b, rA1X, rA1Y, rB1X, rB1Y, normalX, normalY);
+				b2FloatW lambda = (-b2LoadW(c->normalMass1)) * (vn - b2LoadW(c->velocityBias1));
+
+				b2FloatW newImpulse = b2MaxW(normalImpulse1 + lambda, zero);
+				lambda = newImpulse - normalImpulse1;
+				normalImpulse1 = newImpulse;
+
+				b2ApplyImpulseW(&b, mA, iA, mB, iB, rA1X, rA1Y, rB1X, rB1Y, lambda * normalX, lambda * normalY);
+			}
+
+			{
+				b2FloatW vn = b2RelativeVelocityW(b, rA2X, rA2Y, rB2X, rB2Y, normalX, normalY);
+				b2FloatW lambda = (-b2LoadW(c->normalMass2)) * (vn - b2LoadW(c->velocityBias2));
+
+				b2FloatW newImpulse = b2MaxW(normalImpulse2 + lambda, zero);
+				lambda = newImpulse - normalImpulse2;
+				normalImpulse2 = newImpulse;
+
+				b2ApplyImpulseW(&b, mA, iA, mB, iB, rA2X, rA2Y, rB2X, rB2Y, lambda * normalX, lambda * normalY);
+			}
+		}
+		else
+		{
+			// The block solver of SolveVelocityConstraints. Every lane evaluates all four
+			// cases and takes the first valid one. Lanes without a solution keep their
+			// accumulated impulse, which applies a zero increment.
+			b2FloatW a1 = normalImpulse1;
+			b2FloatW a2 = normalImpulse2;
+
+			b2FloatW k11 = b2LoadW(c->k11), k12 = b2LoadW(c->k12), k22 = b2LoadW(c->k22);
+
+			b2FloatW vn1 = b2RelativeVelocityW(b, rA1X, rA1Y, rB1X, rB1Y, normalX, normalY);
+			b2FloatW vn2 = b2RelativeVelocityW(b, rA2X, rA2Y, rB2X, rB2Y, normalX, normalY);
+
+			// Compute b'
+			b2FloatW b1 = (vn1 - b2LoadW(c->velocityBias1)) - (k11 * a1 + k12 * a2);
+			b2FloatW b2 = (vn2 - b2LoadW(c->velocityBias2)) - (k12 * a1 + k22 * a2);
+
+			// Case 1: vn = 0
+			b2FloatW x1Case1 = -(b2LoadW(c->m11) * b1 + b2LoadW(c->m12) * b2);
+			b2FloatW x2Case1 = -(b2LoadW(c->m21) * b1 + b2LoadW(c->m22) * b2);
+			b2FloatW case1 = b2AndW(b2GreaterEqualW(x1Case1, zero), b2GreaterEqualW(x2Case1, zero));
+
+			// Case 2: vn1 = 0 and x2 = 0
+			b2FloatW x1Case2 = (-b2LoadW(c->normalMass1)) * b1;
+			b2FloatW case2 = b2AndW(b2GreaterEqualW(x1Case2, zero), b2GreaterEqualW(k12 * x1Case2 + b2, zero));
+
+			// Case 3: vn2 = 0 and x1 = 0
+			b2FloatW x2Case3 = (-b2LoadW(c->normalMass2)) * b2;
+			b2FloatW case3 = b2AndW(b2GreaterEqualW(x2Case3, zero), b2GreaterEqualW(k12 * x2Case3 + b1, zero));
+
+			// Case 4: x1 = 0 and x2 = 0
+			b2FloatW case4 = b2AndW(b2GreaterEqualW(b1, zero), b2GreaterEqualW(b2, zero));
+
+			// Select the first case that holds, starting from the last.
+			b2FloatW x1 = b2BlendW(a1, zero, case4);
+			b2FloatW x2 = b2BlendW(a2, zero, case4);
+			x1 = b2BlendW(x1, zero, case3);
+			x2 = b2BlendW(x2, x2Case3, case3);
+			x1 = b2BlendW(x1, x1Case2, case2);
+			x2 = b2BlendW(x2, zero, case2);
+			x1 = b2BlendW(x1, x1Case1, case1);
+			x2 = b2BlendW(x2, x2Case1, case1);
+
+			// Apply the incremental impulse
+			b2FloatW d1 = x1 - a1;
+			b2FloatW d2 = x2 - a2;
+			b2FloatW P1X = d1 * normalX, P1Y = d1 * normalY;
+			b2FloatW P2X = d2 * normalX, P2Y = d2 * normalY;
+
+			b.vAX = b.vAX - mA * (P1X + P2X);
+			b.vAY = b.vAY - mA * (P1Y + P2Y);
+			b.wA = b.wA - iA * ((rA1X * P1Y - rA1Y * P1X) + (rA2X * P2Y - rA2Y * P2X));
+
+			b.vBX = b.vBX + mB * (P1X + P2X);
+			b.vBY = b.vBY + mB * (P1Y + P2Y);
+			b.wB = b.wB + iB * ((rB1X * P1Y - rB1Y * P1X) + (rB2X * P2Y - rB2Y * P2X));
+
+			normalImpulse1 = x1;
+			normalImpulse2 = x2;
+		}
+
+		b2StoreW(c->normalImpulse1, normalImpulse1);
+		b2StoreW(c->normalImpulse2, normalImpulse2);
+
+		b2ScatterBodies(m_velocities, c, &b);
+	}
+}
+
+void b2ContactSolver::StoreWideImpulses()
+{
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		const b2WideContactBatch* c = m_batches + i;
+		for (int32 lane = 0; lane < c->laneCount; ++lane)
+		{
+			b2ContactVelocityConstraint* vc = m_velocityConstraints + c->constraints[lane];
+			vc->points[0].normalImpulse = c->normalImpulse1[lane];
+			vc->points[0].tangentImpulse = c->tangentImpulse1[lane];
+			if (vc->pointCount == 2)
+			{
+				vc->points[1].normalImpulse = c->normalImpulse2[lane];
+				vc->points[1].tangentImpulse = c->tangentImpulse2[lane];
+			}
+		}
+	}
+}
+
 struct b2PositionSolverManifold
 {
 	void Initialize(b2ContactPositionConstraint* pc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
@@ -734,11 +1256,19 @@ bool b2ContactSolver::SolvePositionConstraints()
 			aB += iB * b2Cross(rB, P);
 		}
 
-		m_positions[indexA].c = cA;
-		m_positions[indexA].a = aA;
+		// Static and kinematic bodies are shared by islands that are solved at
+		// the same time, so they are not written.
+		if (mA != 0.0f || iA != 0.0f)
+		{
+			m_positions[indexA].c = cA;
+			m_positions[indexA].a = aA;
+		}
 
-		m_positions[indexB].c = cB;
-		m_positions[indexB].a = aB;
+		if (mB != 0.0f || iB != 0.0f)
+		{
+			m_positions[indexB].c = cB;
+			m_positions[indexB].a = aB;
+		}
 	}
 
 	// We can't expect minSpeparation >= -b2_linearSlop because we don't
@@ -825,11 +1355,18 @@ bool b2ContactSolver::SolveTOIPositionConstraints(int32 toiIndexA, int32 toiInde
 			aB += iB * b2Cross(rB, P);
 		}
 
-		m_positions[indexA].c = cA;
-		m_positions[indexA].a = aA;
-
-		m_positions[indexB].c = cB;
-		m_positions[indexB].a = aB;
+		// Only the TOI bodies move. Leaving the others alone lets the islands
+		// of a TOI round share static bodies.
+		if (mA != 0.0f || iA != 0.0f)
+		{
+			m_positions[indexA].c = cA;
+			m_positions[indexA].a = aA;
+		}
+		if (mB != 0.0f || iB != 0.0f)
+		{
+			m_positions[indexB].c = cB;
+			m_positions[indexB].a = aB;
+		}
 	}
 
 	// We can't expect minSpeparation >= -b2_linearSlop because we don't
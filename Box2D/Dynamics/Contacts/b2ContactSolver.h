@@ -22,11 +22,13 @@
 #include "Box2D/Common/b2Math.h"
 #include "Box2D/Collision/b2Collision.h"
 #include "Box2D/Dynamics/b2TimeStep.h"
+#include "Box2D/Dynamics/b2ConstraintGraph.h"
 
 class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2WideContactBatch;
 
 struct b2VelocityConstraintPoint
 {
@@ -64,6 +66,7 @@ struct b2ContactSolverDef
 	b2Position* positions;
 	b2Velocity* velocities;
 	b2StackAllocator* allocator;
+	const b2ConstraintGraph* graph;	// solve color by color, may be nullptr
 };
 
 class b2ContactSolver
@@ -78,6 +81,15 @@ public:
 	void SolveVelocityConstraints();
 	void StoreImpulses();
 
+	/// The contacts are solved in groups, in order. With a constraint graph the
+	/// first m_colorCount groups are its colors, whose items can be solved
+	/// concurrently. The last group is solved one item at a time. It holds the
+	/// overflow of the graph, or every contact in island order without a graph.
+	int32 GetGroupCount() const { return m_colorCount + 1; }
+	int32 GetGroupSize(int32 group) const;
+	void WarmStart(int32 group, int32 begin, int32 end);
+	void SolveVelocityConstraints(int32 group, int32 begin, int32 end);
+
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
@@ -89,6 +101,24 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+	// Contact indices in graph order, or nullptr for island order.
+	const int32* m_order;
+	const int32* m_colorStarts;
+	int32 m_colorCount;
+
+	// Wide solver state. Each color is packed into SIMD batches, the overflow
+	// group is solved one contact at a time.
+	bool m_wide;
+	b2WideContactBatch* m_batches;
+	int32 m_batchCount;
+	int32 m_batchStarts[b2_graphColorCount + 1];
+
+private:
+	void InitializeWide();
+	void WarmStartWide(int32 begin, int32 end);
+	void SolveWideVelocityConstraints(int32 begin, int32 end);
+	void StoreWideImpulses();
 };
 
 #endif
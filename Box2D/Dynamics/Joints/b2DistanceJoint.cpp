@@ -61,10 +61,10 @@ b2DistanceJoint::b2DistanceJoint(const b2DistanceJointDef* def)
 
 void b2DistanceJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
+	m_indexA = m_bodyA->m_stateIndex;
+	m_indexB = m_bodyB->m_stateIndex;
+	m_localCenterA = m_bodyA->m_localCenter;
+	m_localCenterB = m_bodyB->m_localCenter;
 	m_invMassA = m_bodyA->m_invMass;
 	m_invMassB = m_bodyB->m_invMass;
 	m_invIA = m_bodyA->m_invI;
@@ -148,10 +148,16 @@ void b2DistanceJoint::InitVelocityConstraints(const b2SolverData& data)
 		m_impulse = 0.0f;
 	}
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 void b2DistanceJoint::SolveVelocityConstraints(const b2SolverData& data)
@@ -175,10 +181,16 @@ void b2DistanceJoint::SolveVelocityConstraints(const b2SolverData& data)
 	vB += m_invMassB * P;
 	wB += m_invIB * b2Cross(m_rB, P);
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 bool b2DistanceJoint::SolvePositionConstraints(const b2SolverData& data)
@@ -212,10 +224,16 @@ bool b2DistanceJoint::SolvePositionConstraints(const b2SolverData& data)
 	cB += m_invMassB * P;
 	aB += m_invIB * b2Cross(rB, P);
 
-	data.positions[m_indexA].c = cA;
-	data.positions[m_indexA].a = aA;
-	data.positions[m_indexB].c = cB;
-	data.positions[m_indexB].a = aB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.positions[m_indexA].c = cA;
+		data.positions[m_indexA].a = aA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.positions[m_indexB].c = cB;
+		data.positions[m_indexB].a = aB;
+	}
 
 	return b2Abs(C) < b2_linearSlop;
 }
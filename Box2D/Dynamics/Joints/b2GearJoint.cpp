@@ -62,9 +62,9 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 
 	// Get geometry of joint1
 	b2Transform xfA = m_bodyA->m_xf;
-	float32 aA = m_bodyA->m_sweep.a;
+	float32 aA = m_bodyA->GetAngle();
 	b2Transform xfC = m_bodyC->m_xf;
-	float32 aC = m_bodyC->m_sweep.a;
+	float32 aC = m_bodyC->GetAngle();
 
 	if (m_typeA == e_revoluteJoint)
 	{
@@ -94,9 +94,9 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 
 	// Get geometry of joint2
 	b2Transform xfB = m_bodyB->m_xf;
-	float32 aB = m_bodyB->m_sweep.a;
+	float32 aB = m_bodyB->GetAngle();
 	b2Transform xfD = m_bodyD->m_xf;
-	float32 aD = m_bodyD->m_sweep.a;
+	float32 aD = m_bodyD->GetAngle();
 
 	if (m_typeB == e_revoluteJoint)
 	{
@@ -130,14 +130,14 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 
 void b2GearJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_indexC = m_bodyC->m_islandIndex;
-	m_indexD = m_bodyD->m_islandIndex;
-	m_lcA = m_bodyA->m_sweep.localCenter;
-	m_lcB = m_bodyB->m_sweep.localCenter;
-	m_lcC = m_bodyC->m_sweep.localCenter;
-	m_lcD = m_bodyD->m_sweep.localCenter;
+	m_indexA = m_bodyA->m_stateIndex;
+	m_indexB = m_bodyB->m_stateIndex;
+	m_indexC = m_bodyC->m_stateIndex;
+	m_indexD = m_bodyD->m_stateIndex;
+	m_lcA = m_bodyA->m_localCenter;
+	m_lcB = m_bodyB->m_localCenter;
+	m_lcC = m_bodyC->m_localCenter;
+	m_lcD = m_bodyD->m_localCenter;
 	m_mA = m_bodyA->m_invMass;
 	m_mB = m_bodyB->m_invMass;
 	m_mC = m_bodyC->m_invMass;
@@ -222,14 +222,26 @@ void b2GearJoint::InitVelocityConstraints(const b2SolverData& data)
 		m_impulse = 0.0f;
 	}
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
-	data.velocities[m_indexC].v = vC;
-	data.velocities[m_indexC].w = wC;
-	data.velocities[m_indexD].v = vD;
-	data.velocities[m_indexD].w = wD;
+	if (m_mA != 0.0f || m_iA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_mB != 0.0f || m_iB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
+	if (m_mC != 0.0f || m_iC != 0.0f)
+	{
+		data.velocities[m_indexC].v = vC;
+		data.velocities[m_indexC].w = wC;
+	}
+	if (m_mD != 0.0f || m_iD != 0.0f)
+	{
+		data.velocities[m_indexD].v = vD;
+		data.velocities[m_indexD].w = wD;
+	}
 }
 
 void b2GearJoint::SolveVelocityConstraints(const b2SolverData& data)
@@ -258,14 +270,26 @@ void b2GearJoint::SolveVelocityConstraints(const b2SolverData& data)
 	vD -= (m_mD * impulse) * m_JvBD;
 	wD -= m_iD * impulse * m_JwD;
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
-	data.velocities[m_indexC].v = vC;
-	data.velocities[m_indexC].w = wC;
-	data.velocities[m_indexD].v = vD;
-	data.velocities[m_indexD].w = wD;
+	if (m_mA != 0.0f || m_iA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_mB != 0.0f || m_iB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
+	if (m_mC != 0.0f || m_iC != 0.0f)
+	{
+		data.velocities[m_indexC].v = vC;
+		data.velocities[m_indexC].w = wC;
+	}
+	if (m_mD != 0.0f || m_iD != 0.0f)
+	{
+		data.velocities[m_indexD].v = vD;
+		data.velocities[m_indexD].w = wD;
+	}
 }
 
 bool b2GearJoint::SolvePositionConstraints(const b2SolverData& data)
@@ -354,14 +378,26 @@ bool b2GearJoint::SolvePositionConstraints(const b2SolverData& data)
 	cD -= m_mD * impulse * JvBD;
 	aD -= m_iD * impulse * JwD;
 
-	data.positions[m_indexA].c = cA;
-	data.positions[m_indexA].a = aA;
-	data.positions[m_indexB].c = cB;
-	data.positions[m_indexB].a = aB;
-	data.positions[m_indexC].c = cC;
-	data.positions[m_indexC].a = aC;
-	data.positions[m_indexD].c = cD;
-	data.positions[m_indexD].a = aD;
+	if (m_mA != 0.0f || m_iA != 0.0f)
+	{
+		data.positions[m_indexA].c = cA;
+		data.positions[m_indexA].a = aA;
+	}
+	if (m_mB != 0.0f || m_iB != 0.0f)
+	{
+		data.positions[m_indexB].c = cB;
+		data.positions[m_indexB].a = aB;
+	}
+	if (m_mC != 0.0f || m_iC != 0.0f)
+	{
+		data.positions[m_indexC].c = cC;
+		data.positions[m_indexC].a = aC;
+	}
+	if (m_mD != 0.0f || m_iD != 0.0f)
+	{
+		data.positions[m_indexD].c = cD;
+		data.positions[m_indexD].a = aD;
+	}
 
 	// TODO_ERIN not implemented
 	return linearError < b2_linearSlop;
@@ -60,10 +60,10 @@ b2MotorJoint::b2MotorJoint(const b2MotorJointDef* def)
 
 void b2MotorJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
+	m_indexA = m_bodyA->m_stateIndex;
+	m_indexB = m_bodyB->m_stateIndex;
+	m_localCenterA = m_bodyA->m_localCenter;
+	m_localCenterB = m_bodyB->m_localCenter;
 	m_invMassA = m_bodyA->m_invMass;
 	m_invMassB = m_bodyB->m_invMass;
 	m_invIA = m_bodyA->m_invI;
@@ -132,10 +132,16 @@ void b2MotorJoint::InitVelocityConstraints(const b2SolverData& data)
 		m_angularImpulse = 0.0f;
 	}
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 void b2MotorJoint::SolveVelocityConstraints(const b2SolverData& data)
@@ -190,10 +196,16 @@ void b2MotorJoint::SolveVelocityConstraints(const b2SolverData& data)
 		wB += iB * b2Cross(m_rB, impulse);
 	}
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 bool b2MotorJoint::SolvePositionConstraints(const b2SolverData& data)
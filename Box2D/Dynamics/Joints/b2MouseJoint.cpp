@@ -95,8 +95,8 @@ float32 b2MouseJoint::GetDampingRatio() const
 
 void b2MouseJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
+	m_indexB = m_bodyB->m_stateIndex;
+	m_localCenterB = m_bodyB->m_localCenter;
 	m_invMassB = m_bodyB->m_invMass;
 	m_invIB = m_bodyB->m_invI;
 
@@ -161,8 +161,11 @@ void b2MouseJoint::InitVelocityConstraints(const b2SolverData& data)
 		m_impulse.SetZero();
 	}
 
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 void b2MouseJoint::SolveVelocityConstraints(const b2SolverData& data)
@@ -186,8 +189,11 @@ void b2MouseJoint::SolveVelocityConstraints(const b2SolverData& data)
 	vB += m_invMassB * impulse;
 	wB += m_invIB * b2Cross(m_rB, impulse);
 
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 bool b2MouseJoint::SolvePositionConstraints(const b2SolverData& data)
@@ -125,10 +125,10 @@ b2PrismaticJoint::b2PrismaticJoint(const b2PrismaticJointDef* def)
 
 void b2PrismaticJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
+	m_indexA = m_bodyA->m_stateIndex;
+	m_indexB = m_bodyB->m_stateIndex;
+	m_localCenterA = m_bodyA->m_localCenter;
+	m_localCenterB = m_bodyB->m_localCenter;
 	m_invMassA = m_bodyA->m_invMass;
 	m_invMassB = m_bodyB->m_invMass;
 	m_invIA = m_bodyA->m_invI;
@@ -254,10 +254,16 @@ void b2PrismaticJoint::InitVelocityConstraints(const b2SolverData& data)
 		m_motorImpulse = 0.0f;
 	}
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 void b2PrismaticJoint::SolveVelocityConstraints(const b2SolverData& data)
@@ -351,10 +357,16 @@ void b2PrismaticJoint::SolveVelocityConstraints(const b2SolverData& data)
 		wB += iB * LB;
 	}
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 // A velocity based solver computes reaction forces(impulses) using the velocity constraint solver.Under this context,
@@ -480,10 +492,16 @@ bool b2PrismaticJoint::SolvePositionConstraints(const b2SolverData& data)
 	cB += mB * P;
 	aB += iB * LB;
 
-	data.positions[m_indexA].c = cA;
-	data.positions[m_indexA].a = aA;
-	data.positions[m_indexB].c = cB;
-	data.positions[m_indexB].a = aB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.positions[m_indexA].c = cA;
+		data.positions[m_indexA].a = aA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.positions[m_indexB].c = cB;
+		data.positions[m_indexB].a = aB;
+	}
 
 	return linearError <= b2_linearSlop && angularError <= b2_angularSlop;
 }
@@ -524,17 +542,17 @@ float32 b2PrismaticJoint::GetJointSpeed() const
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
 
-	b2Vec2 rA = b2Mul(bA->m_xf.q, m_localAnchorA - bA->m_sweep.localCenter);
-	b2Vec2 rB = b2Mul(bB->m_xf.q, m_localAnchorB - bB->m_sweep.localCenter);
-	b2Vec2 p1 = bA->m_sweep.c + rA;
-	b2Vec2 p2 = bB->m_sweep.c + rB;
+	b2Vec2 rA = b2Mul(bA->m_xf.q, m_localAnchorA - bA->m_localCenter);
+	b2Vec2 rB = b2Mul(bB->m_xf.q, m_localAnchorB - bB->m_localCenter);
+	b2Vec2 p1 = bA->GetWorldCenter() + rA;
+	b2Vec2 p2 = bB->GetWorldCenter() + rB;
 	b2Vec2 d = p2 - p1;
 	b2Vec2 axis = b2Mul(bA->m_xf.q, m_localXAxisA);
 
-	b2Vec2 vA = bA->m_linearVelocity;
-	b2Vec2 vB = bB->m_linearVelocity;
-	float32 wA = bA->m_angularVelocity;
-	float32 wB = bB->m_angularVelocity;
+	b2Vec2 vA = bA->GetLinearVelocity();
+	b2Vec2 vB = bB->GetLinearVelocity();
+	float32 wA = bA->GetAngularVelocity();
+	float32 wB = bB->GetAngularVelocity();
 
 	float32 speed = b2Dot(d, b2Cross(wA, axis)) + b2Dot(axis, vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA));
 	return speed;
@@ -72,10 +72,10 @@ b2PulleyJoint::b2PulleyJoint(const b2PulleyJointDef* def)
 
 void b2PulleyJoint::InitVelocityConstraints(const b2SolverData& data)
 {
-	m_indexA = m_bodyA->m_islandIndex;
-	m_indexB = m_bodyB->m_islandIndex;
-	m_localCenterA = m_bodyA->m_sweep.localCenter;
-	m_localCenterB = m_bodyB->m_sweep.localCenter;
+	m_indexA = m_bodyA->m_stateIndex;
+	m_indexB = m_bodyB->m_stateIndex;
+	m_localCenterA = m_bodyA->m_localCenter;
+	m_localCenterB = m_bodyB->m_localCenter;
 	m_invMassA = m_bodyA->m_invMass;
 	m_invMassB = m_bodyB->m_invMass;
 	m_invIA = m_bodyA->m_invI;
@@ -154,10 +154,16 @@ void b2PulleyJoint::InitVelocityConstraints(const b2SolverData& data)
 		m_impulse = 0.0f;
 	}
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 void b2PulleyJoint::SolveVelocityConstraints(const b2SolverData& data)
@@ -181,10 +187,16 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2SolverData& data)
 	vB += m_invMassB * PB;
 	wB += m_invIB * b2Cross(m_rB, PB);
 
-	data.velocities[m_indexA].v = vA;
-	data.velocities[m_indexA].w = wA;
-	data.velocities[m_indexB].v = vB;
-	data.velocities[m_indexB].w = wB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.velocities[m_indexA].v = vA;
+		data.velocities[m_indexA].w = wA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.velocities[m_indexB].v = vB;
+		data.velocities[m_indexB].w = wB;
+	}
 }
 
 bool b2PulleyJoint::SolvePositionConstraints(const b2SolverData& data)
@@ -251,10 +263,16 @@ bool b2PulleyJoint::SolvePositionConstraints(const b2SolverData& data)
 	cB += m_invMassB * PB;
 	aB += m_invIB * b2Cross(rB, PB);
 
-	data.positions[m_indexA].c = cA;
-	data.positions[m_indexA].a = aA;
-	data.positions[m_indexB].c = cB;
-	data.positions[m_indexB].a = aB;
+	if (m_invMassA != 0.0f || m_invIA != 0.0f)
+	{
+		data.positions[m_indexA].c = cA;
+		data.positions[m_indexA].a = aA;
+	}
+	if (m_invMassB != 0.0f || m_invIB != 0.0f)
+	{
+		data.positions[m_indexB].c = cB;
+		data.positions[m_indexB].a = aB;
+	}
 
 	return linearError < b2_linearSlop;
 }
@@ -55,24 +55,28 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	}
 
 	m_world = world;
+	m_store = &world->m_bodyStore;
+	m_stateIndex = m_store->Create();
 
 	m_xf.p = bd->position;
 	m_xf.q.Set(bd->angle);
 
-	m_sweep.localCenter.SetZero();
-	m_sweep.c0 = m_xf.p;
-	m_sweep.c = m_xf.p;
-	m_sweep.a0 = bd->angle;
-	m_sweep.a = bd->angle;
-	m_sweep.alpha0 = 0.0f;
+	b2Position& position = GetPositionState();
+	m_localCenter.SetZero();
+	m_c0 = m_xf.p;
+	position.c = m_xf.p;
+	m_a0 = bd->angle;
+	position.a = bd->angle;
+	m_alpha0 = 0.0f;
 
 	m_jointList = nullptr;
 	m_contactList = nullptr;
 	m_prev = nullptr;
 	m_next = nullptr;
 
-	m_linearVelocity = bd->linearVelocity;
-	m_angularVelocity = bd->angularVelocity;
+	b2Velocity& velocity = GetVelocityState();
+	velocity.v = bd->linearVelocity;
+	velocity.w = bd->angularVelocity;
 
 	m_linearDamping = bd->linearDamping;
 	m_angularDamping = bd->angularDamping;
@@ -129,10 +133,10 @@ void b2Body::SetType(b2BodyType type)
 
 	if (m_type == b2_staticBody)
 	{
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
-		m_sweep.a0 = m_sweep.a;
-		m_sweep.c0 = m_sweep.c;
+		GetVelocityState().v.SetZero();
+		GetVelocityState().w = 0.0f;
+		m_a0 = GetPositionState().a;
+		m_c0 = GetPositionState().c;
 		SynchronizeFixtures();
 	}
 
@@ -155,6 +159,13 @@ void b2Body::SetType(b2BodyType type)
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
+		// Static proxies can live in their own tree, so move the proxies when the
+		// body changes tree. New proxies get new pairs.
+		if (f->UpdateProxyTree(broadPhase, m_xf))
+		{
+			continue;
+		}
+
 		int32 proxyCount = f->m_proxyCount;
 		for (int32 i = 0; i < proxyCount; ++i)
 		{
@@ -290,14 +301,16 @@ void b2Body::ResetMassData()
 	m_invMass = 0.0f;
 	m_I = 0.0f;
 	m_invI = 0.0f;
-	m_sweep.localCenter.SetZero();
+	m_localCenter.SetZero();
+
+	b2Position& position = GetPositionState();
 
 	// Static and kinematic bodies have zero mass.
 	if (m_type == b2_staticBody || m_type == b2_kinematicBody)
 	{
-		m_sweep.c0 = m_xf.p;
-		m_sweep.c = m_xf.p;
-		m_sweep.a0 = m_sweep.a;
+		m_c0 = m_xf.p;
+		position.c = m_xf.p;
+		m_a0 = position.a;
 		return;
 	}
 
@@ -347,12 +360,13 @@ void b2Body::ResetMassData()
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter = localCenter;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Vec2 oldCenter = position.c;
+	m_localCenter = localCenter;
+	m_c0 = position.c = b2Mul(m_xf, m_localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	b2Velocity& velocity = GetVelocityState();
+	velocity.v += b2Cross(velocity.w, position.c - oldCenter);
 }
 
 void b2Body::SetMassData(const b2MassData* massData)
@@ -388,12 +402,14 @@ void b2Body::SetMassData(const b2MassData* massData)
 	}
 
 	// Move center of mass.
-	b2Vec2 oldCenter = m_sweep.c;
-	m_sweep.localCenter =  massData->center;
-	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
+	b2Position& position = GetPositionState();
+	b2Vec2 oldCenter = position.c;
+	m_localCenter =  massData->center;
+	m_c0 = position.c = b2Mul(m_xf, m_localCenter);
 
 	// Update center of mass velocity.
-	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	b2Velocity& velocity = GetVelocityState();
+	velocity.v += b2Cross(velocity.w, position.c - oldCenter);
 }
 
 bool b2Body::ShouldCollide(const b2Body* other) const
@@ -430,11 +446,12 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 	m_xf.q.Set(angle);
 	m_xf.p = position;
 
-	m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
-	m_sweep.a = angle;
+	b2Position& state = GetPositionState();
+	state.c = b2Mul(m_xf, m_localCenter);
+	state.a = angle;
 
-	m_sweep.c0 = m_sweep.c;
-	m_sweep.a0 = angle;
+	m_c0 = state.c;
+	m_a0 = angle;
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
@@ -446,8 +463,8 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 void b2Body::SynchronizeFixtures()
 {
 	b2Transform xf1;
-	xf1.q.Set(m_sweep.a0);
-	xf1.p = m_sweep.c0 - b2Mul(xf1.q, m_sweep.localCenter);
+	xf1.q.Set(m_a0);
+	xf1.p = m_c0 - b2Mul(xf1.q, m_localCenter);
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
@@ -518,7 +535,7 @@ void b2Body::SetFixedRotation(bool flag)
 		m_flags &= ~e_fixedRotationFlag;
 	}
 
-	m_angularVelocity = 0.0f;
+	GetVelocityState().w = 0.0f;
 
 	ResetMassData();
 }
@@ -531,9 +548,9 @@ void b2Body::Dump()
 	b2Log("  b2BodyDef bd;\n");
 	b2Log("  bd.type = b2BodyType(%d);\n", m_type);
 	b2Log("  bd.position.Set(%.15lef, %.15lef);\n", m_xf.p.x, m_xf.p.y);
-	b2Log("  bd.angle = %.15lef;\n", m_sweep.a);
-	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", m_linearVelocity.x, m_linearVelocity.y);
-	b2Log("  bd.angularVelocity = %.15lef;\n", m_angularVelocity);
+	b2Log("  bd.angle = %.15lef;\n", GetAngle());
+	b2Log("  bd.linearVelocity.Set(%.15lef, %.15lef);\n", GetVelocityState().v.x, GetVelocityState().v.y);
+	b2Log("  bd.angularVelocity = %.15lef;\n", GetVelocityState().w);
 	b2Log("  bd.linearDamping = %.15lef;\n", m_linearDamping);
 	b2Log("  bd.angularDamping = %.15lef;\n", m_angularDamping);
 	b2Log("  bd.allowSleep = bool(%d);\n", m_flags & e_autoSleepFlag);
@@ -21,6 +21,7 @@
 
 #include "Box2D/Common/b2Math.h"
 #include "Box2D/Collision/Shapes/b2Shape.h"
+#include "Box2D/Dynamics/b2BodyStore.h"
 #include <memory>
 
 class b2Fixture;
@@ -175,7 +176,7 @@ public:
 	float32 GetAngle() const;
 
 	/// Get the world position of the center of mass.
-	const b2Vec2& GetWorldCenter() const;
+	b2Vec2 GetWorldCenter() const;
 
 	/// Get the local position of the center of mass.
 	const b2Vec2& GetLocalCenter() const;
@@ -186,7 +187,7 @@ public:
 
 	/// Get the linear velocity of the center of mass.
 	/// @return the linear velocity of the center of mass.
-	const b2Vec2& GetLinearVelocity() const;
+	b2Vec2 GetLinearVelocity() const;
 
 	/// Set the angular velocity.
 	/// @param omega the new angular velocity in radians/second.
@@ -395,6 +396,7 @@ private:
 	friend class b2Island;
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
+	friend class b2ConstraintGraph;
 	friend class b2Contact;
 	
 	friend class b2DistanceJoint;
@@ -433,6 +435,14 @@ private:
 
 	void Advance(float32 t);
 
+	// The state of the body in the world store.
+	b2Position& GetPositionState() const { return m_store->m_positions[m_stateIndex]; }
+	b2Velocity& GetVelocityState() const { return m_store->m_velocities[m_stateIndex]; }
+
+	// The swept motion, assembled from the store and the sweep start.
+	b2Sweep GetSweep() const;
+	void SetSweep(const b2Sweep& sweep);
+
 	b2BodyType m_type;
 
 	uint16 m_flags;
@@ -440,10 +450,16 @@ private:
 	int32 m_islandIndex;
 
 	b2Transform m_xf;		// the body origin transform
-	b2Sweep m_sweep;		// the swept motion for CCD
 
-	b2Vec2 m_linearVelocity;
-	float32 m_angularVelocity;
+	// The position and velocity of the center of mass live in the store.
+	b2BodyStore* m_store;
+	int32 m_stateIndex;
+
+	// The start of the swept motion for CCD.
+	b2Vec2 m_localCenter;	// local center of mass position
+	b2Vec2 m_c0;			// center world position at m_alpha0
+	float32 m_a0;			// world angle at m_alpha0
+	float32 m_alpha0;		// fraction of the current time step in the range [0,1]
 
 	b2Vec2 m_force;
 	float32 m_torque;
@@ -489,17 +505,17 @@ inline const b2Vec2& b2Body::GetPosition() const
 
 inline float32 b2Body::GetAngle() const
 {
-	return m_sweep.a;
+	return GetPositionState().a;
 }
 
-inline const b2Vec2& b2Body::GetWorldCenter() const
+inline b2Vec2 b2Body::GetWorldCenter() const
 {
-	return m_sweep.c;
+	return GetPositionState().c;
 }
 
 inline const b2Vec2& b2Body::GetLocalCenter() const
 {
-	return m_sweep.localCenter;
+	return m_localCenter;
 }
 
 inline void b2Body::SetLinearVelocity(const b2Vec2& v)
@@ -514,12 +530,12 @@ inline void b2Body::SetLinearVelocity(const b2Vec2& v)
 		SetAwake(true);
 	}
 
-	m_linearVelocity = v;
+	GetVelocityState().v = v;
 }
 
-inline const b2Vec2& b2Body::GetLinearVelocity() const
+inline b2Vec2 b2Body::GetLinearVelocity() const
 {
-	return m_linearVelocity;
+	return GetVelocityState().v;
 }
 
 inline void b2Body::SetAngularVelocity(float32 w)
@@ -534,12 +550,12 @@ inline void b2Body::SetAngularVelocity(float32 w)
 		SetAwake(true);
 	}
 
-	m_angularVelocity = w;
+	GetVelocityState().w = w;
 }
 
 inline float32 b2Body::GetAngularVelocity() const
 {
-	return m_angularVelocity;
+	return GetVelocityState().w;
 }
 
 inline float32 b2Body::GetMass() const
@@ -549,14 +565,14 @@ inline float32 b2Body::GetMass() const
 
 inline float32 b2Body::GetInertia() const
 {
-	return m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
+	return m_I + m_mass * b2Dot(m_localCenter, m_localCenter);
 }
 
 inline void b2Body::GetMassData(b2MassData* data) const
 {
 	data->mass = m_mass;
-	data->I = m_I + m_mass * b2Dot(m_sweep.localCenter, m_sweep.localCenter);
-	data->center = m_sweep.localCenter;
+	data->I = m_I + m_mass * b2Dot(m_localCenter, m_localCenter);
+	data->center = m_localCenter;
 }
 
 inline b2Vec2 b2Body::GetWorldPoint(const b2Vec2& localPoint) const
@@ -581,7 +597,8 @@ inline b2Vec2 b2Body::GetLocalVector(const b2Vec2& worldVector) const
 
 inline b2Vec2 b2Body::GetLinearVelocityFromWorldPoint(const b2Vec2& worldPoint) const
 {
-	return m_linearVelocity + b2Cross(m_angularVelocity, worldPoint - m_sweep.c);
+	const b2Velocity& velocity = GetVelocityState();
+	return velocity.v + b2Cross(velocity.w, worldPoint - GetPositionState().c);
 }
 
 inline b2Vec2 b2Body::GetLinearVelocityFromLocalPoint(const b2Vec2& localPoint) const
@@ -647,8 +664,8 @@ inline void b2Body::SetAwake(bool flag)
 	{
 		m_flags &= ~e_awakeFlag;
 		m_sleepTime = 0.0f;
-		m_linearVelocity.SetZero();
-		m_angularVelocity = 0.0f;
+		GetVelocityState().v.SetZero();
+		GetVelocityState().w = 0.0f;
 		m_force.SetZero();
 		m_torque = 0.0f;
 	}
@@ -753,7 +770,7 @@ inline void b2Body::ApplyForce(const b2Vec2& force, const b2Vec2& point, bool wa
 	if (m_flags & e_awakeFlag)
 	{
 		m_force += force;
-		m_torque += b2Cross(point - m_sweep.c, force);
+		m_torque += b2Cross(point - GetPositionState().c, force);
 	}
 }
 
@@ -810,8 +827,9 @@ inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& poin
 	// Don't accumulate velocity if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_linearVelocity += m_invMass * impulse;
-		m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+		b2Velocity& velocity = GetVelocityState();
+		velocity.v += m_invMass * impulse;
+		velocity.w += m_invI * b2Cross(point - GetPositionState().c, impulse);
 	}
 }
 
@@ -830,7 +848,7 @@ inline void b2Body::ApplyLinearImpulseToCenter(const b2Vec2& impulse, bool wake)
 	// Don't accumulate velocity if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_linearVelocity += m_invMass * impulse;
+		GetVelocityState().v += m_invMass * impulse;
 	}
 }
 
@@ -849,24 +867,51 @@ inline void b2Body::ApplyAngularImpulse(float32 impulse, bool wake)
 	// Don't accumulate velocity if the body is sleeping
 	if (m_flags & e_awakeFlag)
 	{
-		m_angularVelocity += m_invI * impulse;
+		GetVelocityState().w += m_invI * impulse;
 	}
 }
 
 inline void b2Body::SynchronizeTransform()
 {
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	const b2Position& position = GetPositionState();
+	m_xf.q.Set(position.a);
+	m_xf.p = position.c - b2Mul(m_xf.q, m_localCenter);
 }
 
 inline void b2Body::Advance(float32 alpha)
 {
 	// Advance to the new safe time. This doesn't sync the broad-phase.
-	m_sweep.Advance(alpha);
-	m_sweep.c = m_sweep.c0;
-	m_sweep.a = m_sweep.a0;
-	m_xf.q.Set(m_sweep.a);
-	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	b2Sweep sweep = GetSweep();
+	sweep.Advance(alpha);
+	sweep.c = sweep.c0;
+	sweep.a = sweep.a0;
+	SetSweep(sweep);
+	m_xf.q.Set(sweep.a);
+	m_xf.p = sweep.c - b2Mul(m_xf.q, m_localCenter);
+}
+
+inline b2Sweep b2Body::GetSweep() const
+{
+	const b2Position& position = GetPositionState();
+	b2Sweep sweep;
+	sweep.localCenter = m_localCenter;
+	sweep.c0 = m_c0;
+	sweep.c = position.c;
+	sweep.a0 = m_a0;
+	sweep.a = position.a;
+	sweep.alpha0 = m_alpha0;
+	return sweep;
+}
+
+inline void b2Body::SetSweep(const b2Sweep& sweep)
+{
+	b2Position& position = GetPositionState();
+	m_localCenter = sweep.localCenter;
+	m_c0 = sweep.c0;
+	position.c = sweep.c;
+	m_a0 = sweep.a0;
+	position.a = sweep.a;
+	m_alpha0 = sweep.alpha0;
 }
 
 inline b2World* b2Body::GetWorld()
@@ -0,0 +1,77 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Dynamics/b2BodyStore.h"
+
+#include <string.h>
+
+b2BodyStore::b2BodyStore()
+{
+	m_positions = nullptr;
+	m_velocities = nullptr;
+	m_freeIndices = nullptr;
+	m_freeCount = 0;
+	m_count = 0;
+	m_capacity = 0;
+}
+
+b2BodyStore::~b2BodyStore()
+{
+	b2Free(m_freeIndices);
+	b2Free(m_velocities);
+	b2Free(m_positions);
+}
+
+int32 b2BodyStore::Create()
+{
+	if (m_freeCount > 0)
+	{
+		return m_freeIndices[--m_freeCount];
+	}
+
+	if (m_count == m_capacity)
+	{
+		b2Position* oldPositions = m_positions;
+		b2Velocity* oldVelocities = m_velocities;
+		int32* oldFreeIndices = m_freeIndices;
+
+		m_capacity = b2Max(16, 2 * m_capacity);
+		m_positions = (b2Position*)b2Alloc(m_capacity * sizeof(b2Position));
+		m_velocities = (b2Velocity*)b2Alloc(m_capacity * sizeof(b2Velocity));
+		m_freeIndices = (int32*)b2Alloc(m_capacity * sizeof(int32));
+
+		if (m_count > 0)
+		{
+			memcpy(m_positions, oldPositions, m_count * sizeof(b2Position));
+			memcpy(m_velocities, oldVelocities, m_count * sizeof(b2Velocity));
+		}
+
+		b2Free(oldFreeIndices);
+		b2Free(oldVelocities);
+		b2Free(oldPositions);
+	}
+
+	return m_count++;
+}
+
+void b2BodyStore::Destroy(int32 index)
+{
+	b2Assert(0 <= index && index < m_count);
+	b2Assert(m_freeCount < m_count);
+	m_freeIndices[m_freeCount++] = index;
+}
@@ -0,0 +1,54 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_BODY_STORE_H
+#define B2_BODY_STORE_H
+
+#include "Box2D/Dynamics/b2TimeStep.h"
+
+/// This is an internal class. It holds the position and velocity of every body
+/// in a world, indexed by the state index of the body. The solvers work on
+/// these arrays in place, so islands do not copy the body state in and out.
+/// The indices of destroyed bodies are reused. The arrays move when they grow,
+/// so pointers into them are only valid until the next body is created.
+class b2BodyStore
+{
+public:
+	b2BodyStore();
+	~b2BodyStore();
+
+	/// Reserve the state of a new body.
+	/// @return the state index.
+	int32 Create();
+
+	/// Release the state of a destroyed body.
+	void Destroy(int32 index);
+
+	/// The positions of the body centers of mass.
+	b2Position* m_positions;
+
+	/// The linear and angular velocities.
+	b2Velocity* m_velocities;
+
+	int32* m_freeIndices;
+	int32 m_freeCount;
+	int32 m_count;
+	int32 m_capacity;
+};
+
+#endif
@@ -0,0 +1,167 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Dynamics/b2ConstraintGraph.h"
+#include "Box2D/Dynamics/b2Body.h"
+#include "Box2D/Dynamics/b2Fixture.h"
+#include "Box2D/Dynamics/Contacts/b2Contact.h"
+#include "Box2D/Dynamics/Joints/b2Joint.h"
+#include "Box2D/Common/b2StackAllocator.h"
+
+#include <string.h>
+
+// Take the lowest color that is free on both bodies. A negative index is a body
+// that is not colored.
+static int32 b2ClaimColor(uint32* masks, int32 indexA, int32 indexB)
+{
+	uint32 used = 0;
+	if (indexA >= 0)
+	{
+		used |= masks[indexA];
+	}
+	if (indexB >= 0)
+	{
+		used |= masks[indexB];
+	}
+
+	if (used == 0xFFFFFFFF)
+	{
+		return b2_graphColorCount;
+	}
+
+	int32 color = 0;
+	while (used & (1u << color))
+	{
+		++color;
+	}
+
+	if (indexA >= 0)
+	{
+		masks[indexA] |= 1u << color;
+	}
+	if (indexB >= 0)
+	{
+		masks[indexB] |= 1u << color;
+	}
+
+	return color;
+}
+
+// Sort the indices by color, keeping island order within a color. The overflow
+// group has color b2_graphColorCount. Greedy coloring uses colors without gaps,
+// so the overflow group directly follows the last color.
+static int32 b2SortByColor(int32* order, int32* starts, const int32* colors, int32 count)
+{
+	memset(starts, 0, (b2_graphColorCount + 2) * sizeof(int32));
+	for (int32 i = 0; i < count; ++i)
+	{
+		++starts[colors[i] + 1];
+	}
+
+	int32 colorCount = 0;
+	for (int32 i = 0; i < b2_graphColorCount; ++i)
+	{
+		if (starts[i + 1] > 0)
+		{
+			colorCount = i + 1;
+		}
+	}
+
+	for (int32 i = 0; i <= b2_graphColorCount; ++i)
+	{
+		starts[i + 1] += starts[i];
+	}
+
+	int32 next[b2_graphColorCount + 1];
+	memcpy(next, starts, sizeof(next));
+	for (int32 i = 0; i < count; ++i)
+	{
+		order[next[colors[i]]++] = i;
+	}
+
+	// Move the overflow group behind the last color.
+	starts[colorCount] = starts[b2_graphColorCount];
+	return colorCount;
+}
+
+b2ConstraintGraph::b2ConstraintGraph(b2StackAllocator* allocator)
+{
+	m_allocator = allocator;
+	m_contactOrder = nullptr;
+	m_contactColorCount = 0;
+	m_contactCount = 0;
+	m_jointOrder = nullptr;
+	m_jointColorCount = 0;
+	m_jointCount = 0;
+}
+
+b2ConstraintGraph::~b2ConstraintGraph()
+{
+	if (m_contactOrder != nullptr)
+	{
+		m_allocator->Free(m_jointOrder);
+		m_allocator->Free(m_contactOrder);
+	}
+}
+
+void b2ConstraintGraph::Build(b2Contact** contacts, int32 contactCount, b2Joint** joints, int32 jointCount,
+							  int32 bodyCount)
+{
+	b2Assert(IsBuilt() == false);
+
+	m_contactCount = contactCount;
+	m_jointCount = jointCount;
+	m_contactOrder = (int32*)m_allocator->Allocate(contactCount * sizeof(int32));
+	m_jointOrder = (int32*)m_allocator->Allocate(jointCount * sizeof(int32));
+
+	// The color masks of the bodies.
+	uint32* masks = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	int32* colors = (int32*)m_allocator->Allocate(b2Max(contactCount, jointCount) * sizeof(int32));
+
+	memset(masks, 0, bodyCount * sizeof(uint32));
+	for (int32 i = 0; i < contactCount; ++i)
+	{
+		b2Body* bodyA = contacts[i]->GetFixtureA()->GetBody();
+		b2Body* bodyB = contacts[i]->GetFixtureB()->GetBody();
+		int32 indexA = bodyA->m_type == b2_dynamicBody ? bodyA->m_islandIndex : -1;
+		int32 indexB = bodyB->m_type == b2_dynamicBody ? bodyB->m_islandIndex : -1;
+		colors[i] = b2ClaimColor(masks, indexA, indexB);
+	}
+	m_contactColorCount = b2SortByColor(m_contactOrder, m_contactStarts, colors, contactCount);
+
+	memset(masks, 0, bodyCount * sizeof(uint32));
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		b2Joint* joint = joints[i];
+		if (joint->GetType() == e_gearJoint)
+		{
+			colors[i] = b2_graphColorCount;
+			continue;
+		}
+
+		b2Body* bodyA = joint->GetBodyA();
+		b2Body* bodyB = joint->GetBodyB();
+		int32 indexA = bodyA->m_type == b2_dynamicBody ? bodyA->m_islandIndex : -1;
+		int32 indexB = bodyB->m_type == b2_dynamicBody ? bodyB->m_islandIndex : -1;
+		colors[i] = b2ClaimColor(masks, indexA, indexB);
+	}
+	m_jointColorCount = b2SortByColor(m_jointOrder, m_jointStarts, colors, jointCount);
+
+	m_allocator->Free(colors);
+	m_allocator->Free(masks);
+}
@@ -0,0 +1,79 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_CONSTRAINT_GRAPH_H
+#define B2_CONSTRAINT_GRAPH_H
+
+#include "Box2D/Common/b2Settings.h"
+
+class b2Contact;
+class b2Joint;
+class b2StackAllocator;
+
+/// The number of colors tried before a constraint goes to the overflow group.
+#define b2_graphColorCount 32
+
+/// Islands with fewer constraints are solved in island order.
+#define b2_graphMinConstraints 16
+
+/// Islands with at least this many constraints spread each color over the
+/// thread pool rather than being solved by one thread.
+#define b2_graphParallelConstraints 512
+
+/// This is an internal class. It partitions the constraints of an island into
+/// colors so that no two constraints of a color write to the same body. The
+/// constraints of a color can then be solved in any order, or at the same time,
+/// with the same result. Colors are assigned greedily in island order, which
+/// keeps the partition deterministic.
+///
+/// Contacts and joints are colored separately because joints are solved before
+/// contacts. Constraints never write to static or kinematic bodies, so only
+/// dynamic bodies are colored. Gear joints, which act on four bodies, and
+/// constraints that find no free color go to an overflow group that is solved
+/// one at a time after the colors.
+class b2ConstraintGraph
+{
+public:
+	b2ConstraintGraph(b2StackAllocator* allocator);
+	~b2ConstraintGraph();
+
+	/// Color the constraints of an island. The dynamic bodies must have their
+	/// island index set.
+	void Build(b2Contact** contacts, int32 contactCount, b2Joint** joints, int32 jointCount, int32 bodyCount);
+
+	/// Has Build been called?
+	bool IsBuilt() const { return m_contactOrder != nullptr; }
+
+	b2StackAllocator* m_allocator;
+
+	// Island contact indices sorted by color. Color i is
+	// [m_contactStarts[i], m_contactStarts[i + 1]) and the overflow group is
+	// [m_contactStarts[m_contactColorCount], m_contactCount).
+	int32* m_contactOrder;
+	int32 m_contactStarts[b2_graphColorCount + 2];
+	int32 m_contactColorCount;
+	int32 m_contactCount;
+
+	// Island joint indices, laid out like the contacts.
+	int32* m_jointOrder;
+	int32 m_jointStarts[b2_graphColorCount + 2];
+	int32 m_jointColorCount;
+	int32 m_jointCount;
+};
+
+#endif
@@ -21,6 +21,10 @@
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Dynamics/b2WorldCallbacks.h"
 #include "Box2D/Dynamics/Contacts/b2Contact.h"
+#include "Box2D/Common/b2Simd.h"
+#include "Box2D/Common/b2ThreadPool.h"
+
+#include <string.h>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
@@ -32,6 +36,16 @@ b2ContactManager::b2ContactManager()
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = nullptr;
+	m_threadPool = nullptr;
+	m_updateBuffer = nullptr;
+	m_updateCapacity = 0;
+	m_manifoldTolerance = 0.0f;
+	memset(&m_manifoldStats, 0, sizeof(m_manifoldStats));
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_updateBuffer);
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -104,6 +118,8 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
+	memset(&m_manifoldStats, 0, sizeof(m_manifoldStats));
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
 	while (c)
@@ -164,11 +180,217 @@ void b2ContactManager::Collide()
 		}
 
 		// The contact persists.
-		c->Update(m_contactListener);
+		c->Update(m_contactListener, m_manifoldTolerance, &m_manifoldStats);
 		c = c->GetNext();
 	}
 }
 
+// What CollideParallel does with a contact once the manifolds are updated.
+enum b2ContactAction
+{
+	b2_destroyContact,
+	b2_skipContact,
+	b2_updateContact
+};
+
+struct b2ContactUpdate
+{
+	b2Contact* contact;
+	b2ContactAction action;
+	bool touching;
+	b2Manifold oldManifold;
+	b2ManifoldCacheStats stats;
+};
+
+class b2ContactUpdateTask : public b2ParallelTask
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		B2_NOT_USED(threadIndex);
+
+		// Sensors are gathered so that their overlap tests run together.
+		b2ContactUpdate* sensors[b2_simdWidth];
+		int32 sensorCount = 0;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2ContactUpdate* update = m_updates + i;
+			if (update->action != b2_updateContact)
+			{
+				continue;
+			}
+
+			b2Contact* c = update->contact;
+			if (c->GetFixtureA()->IsSensor() || c->GetFixtureB()->IsSensor())
+			{
+				sensors[sensorCount++] = update;
+				if (sensorCount == b2_simdWidth)
+				{
+					b2ContactManager::UpdateSensors(sensors, sensorCount);
+					sensorCount = 0;
+				}
+				continue;
+			}
+
+			b2ContactManager::UpdateManifold(update, m_tolerance);
+		}
+
+		if (sensorCount > 0)
+		{
+			b2ContactManager::UpdateSensors(sensors, sensorCount);
+		}
+	}
+
+	b2ContactUpdate* m_updates;
+	float32 m_tolerance;
+};
+
+void b2ContactManager::UpdateManifold(b2ContactUpdate* update, float32 tolerance)
+{
+	b2Contact* c = update->contact;
+	update->oldManifold = c->m_manifold;
+	update->touching = c->UpdateManifold(update->oldManifold, tolerance, &update->stats);
+}
+
+void b2ContactManager::UpdateSensors(b2ContactUpdate* const* updates, int32 count)
+{
+	b2Assert(0 < count && count <= b2_simdWidth);
+
+	// Initialized because the compiler cannot tell that only count entries are read.
+	b2Contact* contacts[b2_simdWidth] = {};
+	bool touching[b2_simdWidth] = {};
+	for (int32 i = 0; i < count; ++i)
+	{
+		contacts[i] = updates[i]->contact;
+		updates[i]->oldManifold = contacts[i]->m_manifold;
+	}
+
+	b2Contact::UpdateSensors(contacts, count, touching);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		updates[i]->touching = touching[i];
+	}
+}
+
+void b2ContactManager::CollideParallel()
+{
+	if (m_updateCapacity < m_contactCount)
+	{
+		b2Free(m_updateBuffer);
+		m_updateCapacity = b2Max(m_contactCount, 2 * m_updateCapacity);
+		m_updateBuffer = (b2ContactUpdate*)b2Alloc(m_updateCapacity * sizeof(b2ContactUpdate));
+	}
+
+	// Decide what happens to each contact without changing anything yet.
+	int32 count = 0;
+	for (b2Contact* c = m_contactList; c; c = c->GetNext())
+	{
+		b2Fixture* fixtureA = c->GetFixtureA();
+		b2Fixture* fixtureB = c->GetFixtureB();
+		int32 indexA = c->GetChildIndexA();
+		int32 indexB = c->GetChildIndexB();
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+
+		b2ContactUpdate* update = m_updateBuffer + count++;
+		update->contact = c;
+		memset(&update->stats, 0, sizeof(update->stats));
+
+		// Is this contact flagged for filtering?
+		if (c->m_flags & b2Contact::e_filterFlag)
+		{
+			// Should these bodies collide?
+			if (bodyB->ShouldCollide(bodyA) == false)
+			{
+				update->action = b2_destroyContact;
+				continue;
+			}
+
+			// Check user filtering.
+			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
+			{
+				update->action = b2_destroyContact;
+				continue;
+			}
+
+			// Clear the filtering flag.
+			c->m_flags &= ~b2Contact::e_filterFlag;
+		}
+
+		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+
+		// A body may still be woken by a contact earlier in the list.
+		if (activeA == false && activeB == false)
+		{
+			update->action = b2_skipContact;
+			continue;
+		}
+
+		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+
+		update->action = overlap ? b2_updateContact : b2_destroyContact;
+	}
+
+	b2ContactUpdateTask task;
+	task.m_updates = m_updateBuffer;
+	task.m_tolerance = m_manifoldTolerance;
+	m_threadPool->ParallelFor(&task, count, 32);
+
+	memset(&m_manifoldStats, 0, sizeof(m_manifoldStats));
+
+	// Apply the results in list order, as Collide would.
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2ContactUpdate* update = m_updateBuffer + i;
+		b2Contact* c = update->contact;
+
+		switch (update->action)
+		{
+		case b2_destroyContact:
+			Destroy(c);
+			break;
+
+		case b2_updateContact:
+			c->ReportUpdate(m_contactListener, update->oldManifold, update->touching);
+			m_manifoldStats.hits += update->stats.hits;
+			m_manifoldStats.misses += update->stats.misses;
+			m_manifoldStats.maxError = b2Max(m_manifoldStats.maxError, update->stats.maxError);
+			break;
+
+		case b2_skipContact:
+			{
+				b2Fixture* fixtureA = c->GetFixtureA();
+				b2Fixture* fixtureB = c->GetFixtureB();
+				b2Body* bodyA = fixtureA->GetBody();
+				b2Body* bodyB = fixtureB->GetBody();
+
+				bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+				bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+				if (activeA == false && activeB == false)
+				{
+					break;
+				}
+
+				int32 proxyIdA = fixtureA->m_proxies[c->GetChildIndexA()].proxyId;
+				int32 proxyIdB = fixtureB->m_proxies[c->GetChildIndexB()].proxyId;
+				if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+				{
+					Destroy(c);
+					break;
+				}
+
+				c->Update(m_contactListener, m_manifoldTolerance, &m_manifoldStats);
+			}
+			break;
+		}
+	}
+}
+
 void b2ContactManager::FindNewContacts()
 {
 	m_broadPhase.UpdatePairs(this);
@@ -242,14 +464,27 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	Link(c);
+
 	// Contact creation may swap fixtures.
 	fixtureA = c->GetFixtureA();
 	fixtureB = c->GetFixtureB();
-	indexA = c->GetChildIndexA();
-	indexB = c->GetChildIndexB();
 	bodyA = fixtureA->GetBody();
 	bodyB = fixtureB->GetBody();
 
+	// Wake up the bodies
+	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
+	{
+		bodyA->SetAwake(true);
+		bodyB->SetAwake(true);
+	}
+}
+
+void b2ContactManager::Link(b2Contact* c)
+{
+	b2Body* bodyA = c->GetFixtureA()->GetBody();
+	b2Body* bodyB = c->GetFixtureB()->GetBody();
+
 	// Insert into the world.
 	c->m_prev = nullptr;
 	c->m_next = m_contactList;
@@ -285,12 +520,5 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	bodyB->m_contactList = &c->m_nodeB;
 
-	// Wake up the bodies
-	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
-	{
-		bodyA->SetAwake(true);
-		bodyB->SetAwake(true);
-	}
-
 	++m_contactCount;
 }
@@ -20,17 +20,21 @@
 #define B2_CONTACT_MANAGER_H
 
 #include "Box2D/Collision/b2BroadPhase.h"
+#include "Box2D/Dynamics/b2TimeStep.h"
 
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2ThreadPool;
+struct b2ContactUpdate;
 
 // Delegate of b2World.
 class b2ContactManager
 {
 public:
 	b2ContactManager();
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -39,14 +43,38 @@ public:
 
 	void Destroy(b2Contact* c);
 
+	// Insert a new contact into the world list and the body contact graph.
+	void Link(b2Contact* c);
+
 	void Collide();
-            
+
+	// Collide with the manifold updates on the thread pool. The contacts are
+	// destroyed, woken and reported in list order, so the result is the same
+	// as Collide.
+	void CollideParallel();
+	static void UpdateManifold(b2ContactUpdate* update, float32 tolerance);
+
+	// UpdateManifold for up to b2_simdWidth sensor contacts, with one batched
+	// overlap test.
+	static void UpdateSensors(b2ContactUpdate* const* updates, int32 count);
+
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
 	int32 m_contactCount;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+	// Optional pool for the narrow-phase, set by b2World::SetThreadPool.
+	b2ThreadPool* m_threadPool;
+
+	// Per contact scratch of CollideParallel, kept between steps.
+	b2ContactUpdate* m_updateBuffer;
+	int32 m_updateCapacity;
+
+	// The manifold cache tolerance and the counts of the last collide pass.
+	float32 m_manifoldTolerance;
+	b2ManifoldCacheStats m_manifoldStats;
 };
 
 #endif
@@ -123,19 +123,49 @@ void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
 {
 	b2Assert(m_proxyCount == 0);
 
-	// Create proxies in the broad-phase.
+	// Create proxies in the broad-phase. Static bodies go to the static tree
+	// when it is enabled.
 	m_proxyCount = m_shape->GetChildCount();
 
+	b2BroadPhase::ProxyType type = b2BroadPhase::e_dynamicProxy;
+	if (m_body->GetType() == b2_staticBody)
+	{
+		type = b2BroadPhase::e_staticProxy;
+	}
+
 	for (int32 i = 0; i < m_proxyCount; ++i)
 	{
 		b2FixtureProxy* proxy = m_proxies + i;
 		m_shape->ComputeAABB(&proxy->aabb, xf, i);
-		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy);
+		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy, type);
 		proxy->fixture = this;
 		proxy->childIndex = i;
 	}
 }
 
+bool b2Fixture::UpdateProxyTree(b2BroadPhase* broadPhase, const b2Transform& xf)
+{
+	if (m_proxyCount == 0)
+	{
+		return false;
+	}
+
+	b2BroadPhase::ProxyType type = b2BroadPhase::e_dynamicProxy;
+	if (m_body->GetType() == b2_staticBody && broadPhase->GetStaticTreeEnabled())
+	{
+		type = b2BroadPhase::e_staticProxy;
+	}
+
+	if (broadPhase->GetProxyType(m_proxies[0].proxyId) == type)
+	{
+		return false;
+	}
+
+	DestroyProxies(broadPhase);
+	CreateProxies(broadPhase, xf);
+	return true;
+}
+
 void b2Fixture::DestroyProxies(b2BroadPhase* broadPhase)
 {
 	// Destroy proxies in the broad-phase.
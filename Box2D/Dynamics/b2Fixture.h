@@ -213,6 +213,10 @@ protected:
 	void CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf);
 	void DestroyProxies(b2BroadPhase* broadPhase);
 
+	// Recreate the proxies if the body type calls for the other broad-phase tree.
+	// Returns true if the proxies were recreated.
+	bool UpdateProxyTree(b2BroadPhase* broadPhase, const b2Transform& xf);
+
 	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
 
 	float32 m_density;
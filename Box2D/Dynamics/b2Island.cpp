@@ -21,10 +21,12 @@
 #include "Box2D/Dynamics/b2Body.h"
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Dynamics/b2World.h"
+#include "Box2D/Dynamics/b2ConstraintGraph.h"
 #include "Box2D/Dynamics/Contacts/b2Contact.h"
 #include "Box2D/Dynamics/Contacts/b2ContactSolver.h"
 #include "Box2D/Dynamics/Joints/b2Joint.h"
 #include "Box2D/Common/b2StackAllocator.h"
+#include "Box2D/Common/b2ThreadPool.h"
 #include "Box2D/Common/b2Timer.h"
 
 /*
@@ -117,9 +119,10 @@ to few cache misses.
 The bodies are not accessed during iteration. Instead read only data, such as
 the mass values are stored with the constraints. The mutable data are the constraint
 impulses and the bodies velocities/positions. The impulses are held inside the
-constraint structures. The body velocities/positions are held in compact, temporary
-arrays to increase the number of cache hits. Linear and angular velocity are
-stored in a single array since multiple arrays lead to multiple misses.
+constraint structures. The body velocities/positions are held in compact arrays
+owned by the world (b2BodyStore) and are solved in place, so they are not copied
+in and out of each island. Linear and angular velocity are stored in a single
+array since multiple arrays lead to multiple misses.
 */
 
 /*
@@ -149,6 +152,7 @@ b2Island::b2Island(
 	int32 bodyCapacity,
 	int32 contactCapacity,
 	int32 jointCapacity,
+	b2BodyStore* store,
 	b2StackAllocator* allocator,
 	b2ContactListener* listener)
 {
@@ -161,47 +165,45 @@ b2Island::b2Island(
 
 	m_allocator = allocator;
 	m_listener = listener;
+	m_threadPool = nullptr;
 
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
 	m_joints = (b2Joint**)m_allocator->Allocate(jointCapacity * sizeof(b2Joint*));
 
-	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
-	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+	m_positions = store->m_positions;
+	m_velocities = store->m_velocities;
 }
 
 b2Island::~b2Island()
 {
 	// Warning: the order should reverse the constructor order.
-	m_allocator->Free(m_positions);
-	m_allocator->Free(m_velocities);
 	m_allocator->Free(m_joints);
 	m_allocator->Free(m_contacts);
 	m_allocator->Free(m_bodies);
 }
 
-void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+bool b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
 {
 	b2Timer timer;
 
 	float32 h = step.dt;
 
-	// Integrate velocities and apply damping. Initialize the body state.
+	// Integrate velocities and apply damping.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
-
-		b2Vec2 c = b->m_sweep.c;
-		float32 a = b->m_sweep.a;
-		b2Vec2 v = b->m_linearVelocity;
-		float32 w = b->m_angularVelocity;
+		int32 index = b->m_stateIndex;
 
 		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
+		b->m_c0 = m_positions[index].c;
+		b->m_a0 = m_positions[index].a;
 
 		if (b->m_type == b2_dynamicBody)
 		{
+			b2Vec2 v = m_velocities[index].v;
+			float32 w = m_velocities[index].w;
+
 			// Integrate velocities.
 			v += h * (b->m_gravityScale * gravity + b->m_invMass * b->m_force);
 			w += h * b->m_invI * b->m_torque;
@@ -215,12 +217,10 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			// v2 = v1 * 1 / (1 + c * dt)
 			v *= 1.0f / (1.0f + h * b->m_linearDamping);
 			w *= 1.0f / (1.0f + h * b->m_angularDamping);
-		}
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+			m_velocities[index].v = v;
+			m_velocities[index].w = w;
+		}
 	}
 
 	timer.Reset();
@@ -231,6 +231,13 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	solverData.positions = m_positions;
 	solverData.velocities = m_velocities;
 
+	// Color the constraints of large islands.
+	b2ConstraintGraph graph(m_allocator);
+	if ((step.graphColoring || step.wideContactSolver) && m_contactCount + m_jointCount >= b2_graphMinConstraints)
+	{
+		graph.Build(m_contacts, m_contactCount, m_joints, m_jointCount, m_bodyCount);
+	}
+
 	// Initialize velocity constraints.
 	b2ContactSolverDef contactSolverDef;
 	contactSolverDef.step = step;
@@ -239,13 +246,14 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	contactSolverDef.positions = m_positions;
 	contactSolverDef.velocities = m_velocities;
 	contactSolverDef.allocator = m_allocator;
+	contactSolverDef.graph = graph.IsBuilt() ? &graph : nullptr;
 
 	b2ContactSolver contactSolver(&contactSolverDef);
 	contactSolver.InitializeVelocityConstraints();
 
 	if (step.warmStarting)
 	{
-		contactSolver.WarmStart();
+		SolveContactVelocities(&contactSolver, true);
 	}
 	
 	for (int32 i = 0; i < m_jointCount; ++i)
@@ -259,12 +267,8 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	timer.Reset();
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
-		{
-			m_joints[j]->SolveVelocityConstraints(solverData);
-		}
-
-		contactSolver.SolveVelocityConstraints();
+		SolveJointVelocities(graph, solverData);
+		SolveContactVelocities(&contactSolver, false);
 	}
 
 	// Store impulses for warm starting
@@ -274,10 +278,11 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	// Integrate positions
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Vec2 c = m_positions[i].c;
-		float32 a = m_positions[i].a;
-		b2Vec2 v = m_velocities[i].v;
-		float32 w = m_velocities[i].w;
+		int32 index = m_bodies[i]->m_stateIndex;
+		b2Vec2 c = m_positions[index].c;
+		float32 a = m_positions[index].a;
+		b2Vec2 v = m_velocities[index].v;
+		float32 w = m_velocities[index].w;
 
 		// Check for large velocities
 		b2Vec2 translation = h * v;
@@ -298,10 +303,10 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		c += h * v;
 		a += h * w;
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+		m_positions[index].c = c;
+		m_positions[index].a = a;
+		m_velocities[index].v = v;
+		m_velocities[index].w = w;
 	}
 
 	// Solve position constraints
@@ -326,15 +331,10 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		}
 	}
 
-	// Copy state buffers back to the bodies
+	// Update the body transforms from the solved state
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Body* body = m_bodies[i];
-		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
-		body->m_linearVelocity = m_velocities[i].v;
-		body->m_angularVelocity = m_velocities[i].w;
-		body->SynchronizeTransform();
+		m_bodies[i]->SynchronizeTransform();
 	}
 
 	profile->solvePosition = timer.GetMilliseconds();
@@ -356,9 +356,10 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 				continue;
 			}
 
+			const b2Velocity& velocity = m_velocities[b->m_stateIndex];
 			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+				velocity.w * velocity.w > angTolSqr ||
+				b2Dot(velocity.v, velocity.v) > linTolSqr)
 			{
 				b->m_sleepTime = 0.0f;
 				minSleepTime = 0.0f;
@@ -377,25 +378,122 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 				b2Body* b = m_bodies[i];
 				b->SetAwake(false);
 			}
+
+			return true;
 		}
 	}
+
+	return false;
 }
 
-void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB)
+// The number of constraints, or wide contact batches, in a thread pool range.
+// Smaller groups are solved on the calling thread.
+#define b2_groupRangeSize 32
+
+// Solves part of one color of contacts on the thread pool.
+class b2ContactGroupTask : public b2ParallelTask
 {
-	b2Assert(toiIndexA < m_bodyCount);
-	b2Assert(toiIndexB < m_bodyCount);
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		B2_NOT_USED(threadIndex);
+		if (m_warmStart)
+		{
+			m_contactSolver->WarmStart(m_group, begin, end);
+		}
+		else
+		{
+			m_contactSolver->SolveVelocityConstraints(m_group, begin, end);
+		}
+	}
 
-	// Initialize the body state.
-	for (int32 i = 0; i < m_bodyCount; ++i)
+	b2ContactSolver* m_contactSolver;
+	int32 m_group;
+	bool m_warmStart;
+};
+
+// Solves part of one color of joints on the thread pool.
+class b2JointGroupTask : public b2ParallelTask
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
 	{
-		b2Body* b = m_bodies[i];
-		m_positions[i].c = b->m_sweep.c;
-		m_positions[i].a = b->m_sweep.a;
-		m_velocities[i].v = b->m_linearVelocity;
-		m_velocities[i].w = b->m_angularVelocity;
+		B2_NOT_USED(threadIndex);
+		b2Island::SolveJoints(m_joints, m_order, begin, end, *m_data);
+	}
+
+	b2Joint** m_joints;
+	const int32* m_order;
+	const b2SolverData* m_data;
+};
+
+void b2Island::SolveJoints(b2Joint** joints, const int32* order, int32 begin, int32 end, const b2SolverData& data)
+{
+	for (int32 i = begin; i < end; ++i)
+	{
+		joints[order[i]]->SolveVelocityConstraints(data);
+	}
+}
+
+void b2Island::SolveJointVelocities(const b2ConstraintGraph& graph, const b2SolverData& data)
+{
+	if (graph.IsBuilt() == false)
+	{
+		for (int32 i = 0; i < m_jointCount; ++i)
+		{
+			m_joints[i]->SolveVelocityConstraints(data);
+		}
+		return;
 	}
 
+	b2JointGroupTask task;
+	task.m_joints = m_joints;
+	task.m_data = &data;
+
+	for (int32 color = 0; color < graph.m_jointColorCount; ++color)
+	{
+		int32 start = graph.m_jointStarts[color];
+		int32 count = graph.m_jointStarts[color + 1] - start;
+		if (m_threadPool != nullptr && count > b2_groupRangeSize)
+		{
+			task.m_order = graph.m_jointOrder + start;
+			m_threadPool->ParallelFor(&task, count, b2_groupRangeSize);
+		}
+		else
+		{
+			SolveJoints(m_joints, graph.m_jointOrder + start, 0, count, data);
+		}
+	}
+
+	int32 overflowStart = graph.m_jointStarts[graph.m_jointColorCount];
+	SolveJoints(m_joints, graph.m_jointOrder + overflowStart, 0, m_jointCount - overflowStart, data);
+}
+
+void b2Island::SolveContactVelocities(b2ContactSolver* contactSolver, bool warmStart)
+{
+	b2ContactGroupTask task;
+	task.m_contactSolver = contactSolver;
+	task.m_warmStart = warmStart;
+
+	// The last group must be solved in order.
+	int32 groupCount = contactSolver->GetGroupCount();
+	for (int32 group = 0; group < groupCount; ++group)
+	{
+		int32 count = contactSolver->GetGroupSize(group);
+		task.m_group = group;
+		if (m_threadPool != nullptr && group < groupCount - 1 && count > b2_groupRangeSize)
+		{
+			m_threadPool->ParallelFor(&task, count, b2_groupRangeSize);
+		}
+		else
+		{
+			task.Execute(0, count, 0);
+		}
+	}
+}
+
+void b2Island::SolveTOI(const b2TimeStep& subStep, b2Body* toiBodyA, b2Body* toiBodyB, b2ContactImpulse* impulses)
+{
 	b2ContactSolverDef contactSolverDef;
 	contactSolverDef.contacts = m_contacts;
 	contactSolverDef.count = m_contactCount;
@@ -403,12 +501,13 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	contactSolverDef.step = subStep;
 	contactSolverDef.positions = m_positions;
 	contactSolverDef.velocities = m_velocities;
+	contactSolverDef.graph = nullptr;
 	b2ContactSolver contactSolver(&contactSolverDef);
 
 	// Solve position constraints.
 	for (int32 i = 0; i < subStep.positionIterations; ++i)
 	{
-		bool contactsOkay = contactSolver.SolveTOIPositionConstraints(toiIndexA, toiIndexB);
+		bool contactsOkay = contactSolver.SolveTOIPositionConstraints(toiBodyA->m_stateIndex, toiBodyB->m_stateIndex);
 		if (contactsOkay)
 		{
 			break;
@@ -449,10 +548,16 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 #endif
 
 	// Leap of faith to new safe state.
-	m_bodies[toiIndexA]->m_sweep.c0 = m_positions[toiIndexA].c;
-	m_bodies[toiIndexA]->m_sweep.a0 = m_positions[toiIndexA].a;
-	m_bodies[toiIndexB]->m_sweep.c0 = m_positions[toiIndexB].c;
-	m_bodies[toiIndexB]->m_sweep.a0 = m_positions[toiIndexB].a;
+	if (toiBodyA->m_type != b2_staticBody)
+	{
+		toiBodyA->m_c0 = m_positions[toiBodyA->m_stateIndex].c;
+		toiBodyA->m_a0 = m_positions[toiBodyA->m_stateIndex].a;
+	}
+	if (toiBodyB->m_type != b2_staticBody)
+	{
+		toiBodyB->m_c0 = m_positions[toiBodyB->m_stateIndex].c;
+		toiBodyB->m_a0 = m_positions[toiBodyB->m_stateIndex].a;
+	}
 
 	// No warm starting is needed for TOI events because warm
 	// starting impulses were applied in the discrete solver.
@@ -472,10 +577,12 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 	// Integrate positions
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Vec2 c = m_positions[i].c;
-		float32 a = m_positions[i].a;
-		b2Vec2 v = m_velocities[i].v;
-		float32 w = m_velocities[i].w;
+		b2Body* body = m_bodies[i];
+		int32 index = body->m_stateIndex;
+		b2Vec2 c = m_positions[index].c;
+		float32 a = m_positions[index].a;
+		b2Vec2 v = m_velocities[index].v;
+		float32 w = m_velocities[index].w;
 
 		// Check for large velocities
 		b2Vec2 translation = h * v;
@@ -496,21 +603,27 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 		c += h * v;
 		a += h * w;
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+		m_positions[index].c = c;
+		m_positions[index].a = a;
+		m_velocities[index].v = v;
+		m_velocities[index].w = w;
 
 		// Sync bodies
-		b2Body* body = m_bodies[i];
-		body->m_sweep.c = c;
-		body->m_sweep.a = a;
-		body->m_linearVelocity = v;
-		body->m_angularVelocity = w;
 		body->SynchronizeTransform();
 	}
 
-	Report(contactSolver.m_velocityConstraints);
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = contactSolver.m_velocityConstraints + i;
+
+		b2ContactImpulse* impulse = impulses + i;
+		impulse->count = vc->pointCount;
+		for (int32 j = 0; j < vc->pointCount; ++j)
+		{
+			impulse->normalImpulses[j] = vc->points[j].normalImpulse;
+			impulse->tangentImpulses[j] = vc->points[j].tangentImpulse;
+		}
+	}
 }
 
 void b2Island::Report(const b2ContactVelocityConstraint* constraints)
@@ -537,3 +650,27 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 		m_listener->PostSolve(c, &impulse);
 	}
 }
+
+void b2Island::Report(b2ContactListener* listener, b2Contact** contacts, int32 count)
+{
+	if (listener == nullptr)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Contact* c = contacts[i];
+		const b2Manifold* manifold = c->GetManifold();
+
+		b2ContactImpulse impulse;
+		impulse.count = manifold->pointCount;
+		for (int32 j = 0; j < manifold->pointCount; ++j)
+		{
+			impulse.normalImpulses[j] = manifold->points[j].normalImpulse;
+			impulse.tangentImpulses[j] = manifold->points[j].tangentImpulse;
+		}
+
+		listener->PostSolve(c, &impulse);
+	}
+}
@@ -27,14 +27,19 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactSolver;
+class b2ConstraintGraph;
+class b2ThreadPool;
 struct b2ContactVelocityConstraint;
+struct b2ContactImpulse;
 struct b2Profile;
 
 /// This is an internal class.
 class b2Island
 {
 public:
-	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
+	/// The island solves the bodies in place in the body store.
+	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity, b2BodyStore* store,
 			b2StackAllocator* allocator, b2ContactListener* listener);
 	~b2Island();
 
@@ -45,9 +50,14 @@ public:
 		m_jointCount = 0;
 	}
 
-	void Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
+	/// @return true if the island fell asleep.
+	bool Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
 
-	void SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB);
+	/// Solve a TOI island. The TOI bodies need not be in the island if they are
+	/// static. Static bodies are never written, so islands that only share
+	/// static bodies can be solved at the same time.
+	/// @param impulses receives the impulses of the contacts for the listener.
+	void SolveTOI(const b2TimeStep& subStep, b2Body* toiBodyA, b2Body* toiBodyB, b2ContactImpulse* impulses);
 
 	void Add(b2Body* body)
 	{
@@ -69,10 +79,28 @@ public:
 		m_joints[m_jointCount++] = joint;
 	}
 
+	/// Spread each color of the constraint graph over a thread pool. The island
+	/// must not be solved from a task of the same pool.
+	void SetThreadPool(b2ThreadPool* pool) { m_threadPool = pool; }
+
+	/// Solve the joint velocity constraints, color by color with a built graph.
+	void SolveJointVelocities(const b2ConstraintGraph& graph, const b2SolverData& data);
+
+	/// Warm start or solve the contacts group by group.
+	void SolveContactVelocities(b2ContactSolver* contactSolver, bool warmStart);
+
+	/// Solve the joints order[begin, end).
+	static void SolveJoints(b2Joint** joints, const int32* order, int32 begin, int32 end, const b2SolverData& data);
+
 	void Report(const b2ContactVelocityConstraint* constraints);
 
+	/// Report the impulses stored in the contact manifolds. This gives the same
+	/// values as Report after a solve.
+	static void Report(b2ContactListener* listener, b2Contact** contacts, int32 count);
+
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
+	b2ThreadPool* m_threadPool;
 
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
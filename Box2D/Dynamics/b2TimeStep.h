@@ -32,6 +32,24 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+	int32 stackPeak;		///< the most bytes a stack allocator held, over the stack allocators of all threads
+	int32 stackOverflows;	///< the number of stack allocations that had to grow a stack allocator
+	int32 manifoldHits;		///< the touching contacts that kept their manifold, see b2World::SetManifoldCacheTolerance
+	int32 manifoldMisses;	///< the touching contacts that moved too far to keep it
+	float32 manifoldError;	///< the largest error bound of a kept manifold
+	int32 toiEvents;		///< the TOI events that were resolved
+	int32 toiRounds;		///< the rounds that found TOI events, see b2World::SetTOIBatching
+	int32 toiQueries;		///< the times of impact that were computed
+	int32 toiIters;			///< the separating axes tried by those queries
+	int32 toiRootIters;		///< the root finder iterations of those queries
+};
+
+/// Counts of the manifold cache over one collide pass.
+struct b2ManifoldCacheStats
+{
+	int32 hits;
+	int32 misses;
+	float32 maxError;
 };
 
 /// This is an internal structure.
@@ -43,6 +61,8 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool graphColoring;		// solve the velocities of large islands color by color
+	bool wideContactSolver;	// solve contact velocities in SIMD batches
 };
 
 /// This is an internal structure.
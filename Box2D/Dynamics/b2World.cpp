@@ -17,6 +17,7 @@
 */
 
 #include "Box2D/Dynamics/b2World.h"
+#include "Box2D/Dynamics/b2WorldSnapshot.h"
 #include "Box2D/Dynamics/b2Body.h"
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Dynamics/b2Island.h"
@@ -31,7 +32,9 @@
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
 #include "Box2D/Collision/b2TimeOfImpact.h"
 #include "Box2D/Common/b2Draw.h"
+#include "Box2D/Common/b2ThreadPool.h"
 #include "Box2D/Common/b2Timer.h"
+#include <algorithm>
 #include <new>
 
 b2World::b2World(const b2Vec2& gravity)
@@ -46,8 +49,11 @@ b2World::b2World(const b2Vec2& gravity)
 	m_jointCount = 0;
 
 	m_warmStarting = true;
+	m_graphColoring = false;
+	m_wideContactSolver = false;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_toiBatching = false;
 
 	m_stepComplete = true;
 
@@ -60,6 +66,10 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_contactManager.m_allocator = &m_blockAllocator;
 
+	m_threadPool = nullptr;
+	m_threadAllocators = nullptr;
+	m_threadAllocatorCount = 0;
+
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
 
@@ -82,6 +92,8 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	SetThreadPool(nullptr);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -205,6 +217,7 @@ void b2World::DestroyBody(b2Body* b)
 	}
 
 	--m_bodyCount;
+	m_bodyStore.Destroy(b->m_stateIndex);
 	b->~b2Body();
 	m_blockAllocator.Free(b, sizeof(b2Body));
 }
@@ -361,6 +374,20 @@ void b2World::DestroyJoint(b2Joint* j)
 
 			edge = edge->next;
 		}
+
+		// Sweep and prune only reports pairs that start to overlap, so touch
+		// the proxies of one body to pair the bodies again.
+		b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+		if (broadPhase->GetPairMethod() == b2BroadPhase::e_sweepAndPrune)
+		{
+			for (b2Fixture* f = bodyA->m_fixtureList; f; f = f->m_next)
+			{
+				for (int32 i = 0; i < f->m_proxyCount; ++i)
+				{
+					broadPhase->TouchProxy(f->m_proxies[i].proxyId);
+				}
+			}
+		}
 	}
 }
 
@@ -382,6 +409,38 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
+void b2World::SetThreadPool(b2ThreadPool* pool)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_threadAllocators);
+	m_threadAllocators = nullptr;
+	m_threadAllocatorCount = 0;
+
+	m_threadPool = pool;
+	m_contactManager.m_threadPool = pool;
+	m_contactManager.m_broadPhase.SetThreadPool(pool);
+	if (pool == nullptr)
+	{
+		return;
+	}
+
+	m_threadAllocatorCount = pool->GetThreadCount() - 1;
+	m_threadAllocators = (b2StackAllocator*)b2Alloc(b2Max(m_threadAllocatorCount, 1) * sizeof(b2StackAllocator));
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		new (m_threadAllocators + i) b2StackAllocator();
+	}
+}
+
 // Find islands, integrate and solve constraints, solve position constraints
 void b2World::Solve(const b2TimeStep& step)
 {
@@ -389,10 +448,48 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
+	if (m_threadPool != nullptr)
+	{
+		SolveIslandsParallel(step);
+	}
+	else
+	{
+		SolveIslands(step);
+	}
+
+	{
+		b2Timer timer;
+		// Synchronize fixtures, check for out of range bodies.
+		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		{
+			// If a body was not in an island then it did not move.
+			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				continue;
+			}
+
+			if (b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			// Update fixtures (for broad-phase).
+			b->SynchronizeFixtures();
+		}
+
+		// Look for new contacts.
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+}
+
+void b2World::SolveIslands(const b2TimeStep& step)
+{
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
 					m_jointCount,
+					&m_bodyStore,
 					&m_stackAllocator,
 					m_contactManager.m_contactListener);
 
@@ -546,339 +643,1166 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 
 	m_stackAllocator.Free(stack);
+}
+
+// The bodies, static bodies, contacts and joints of an island found by
+// SolveIslandsParallel. The ranges index shared arrays.
+struct b2IslandRange
+{
+	int32 bodyStart;
+	int32 bodyCount;
+	int32 staticStart;
+	int32 staticCount;
+	int32 contactStart;
+	int32 contactCount;
+	int32 jointStart;
+	int32 jointCount;
+	bool asleep;
+};
 
+// Solves islands on the thread pool. Each thread uses its own stack allocator
+// and profile. Islands share nothing but static bodies, which the solvers
+// never write.
+class b2IslandSolveTask : public b2ParallelTask
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
 	{
-		b2Timer timer;
-		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		for (int32 i = begin; i < end; ++i)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
-			{
-				continue;
-			}
+			Solve(m_ranges + m_islands[i], m_allocators[threadIndex], m_profiles + threadIndex, nullptr);
+		}
+	}
 
-			if (b->GetType() == b2_staticBody)
-			{
-				continue;
-			}
+	// The pool is used inside the island, so it must not be running this task.
+	void Solve(b2IslandRange* range, b2StackAllocator* allocator, b2Profile* profile, b2ThreadPool* pool)
+	{
+		b2Island island(range->bodyCount, range->contactCount, range->jointCount, m_bodyStore, allocator, nullptr);
 
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
+		for (int32 j = 0; j < range->bodyCount; ++j)
+		{
+			island.Add(m_bodies[range->bodyStart + j]);
+		}
+		for (int32 j = 0; j < range->contactCount; ++j)
+		{
+			island.Add(m_contacts[range->contactStart + j]);
+		}
+		for (int32 j = 0; j < range->jointCount; ++j)
+		{
+			island.Add(m_joints[range->jointStart + j]);
 		}
+		island.SetThreadPool(pool);
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+		b2Profile islandProfile;
+		range->asleep = island.Solve(&islandProfile, *m_step, m_gravity, m_allowSleep);
+		profile->solveInit += islandProfile.solveInit;
+		profile->solveVelocity += islandProfile.solveVelocity;
+		profile->solvePosition += islandProfile.solvePosition;
 	}
-}
 
-// Find TOI contacts and solve them.
-void b2World::SolveTOI(const b2TimeStep& step)
+	b2StackAllocator** m_allocators;
+	b2Profile* m_profiles;
+	b2IslandRange* m_ranges;
+	const int32* m_islands;
+	b2Body** m_bodies;
+	b2Contact** m_contacts;
+	b2Joint** m_joints;
+	b2BodyStore* m_bodyStore;
+	const b2TimeStep* m_step;
+	b2Vec2 m_gravity;
+	bool m_allowSleep;
+};
+
+// Find all islands first and then solve them in parallel. Static bodies are
+// not added to the islands. The solvers read their state from the body store
+// but never write it, so islands solved at the same time can share them. The
+// listener and the flags of static bodies are handled afterwards in island
+// order, which makes the result identical to SolveIslands.
+void b2World::SolveIslandsParallel(const b2TimeStep& step)
 {
-	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
+	// Clear all the island flags.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_flags &= ~b2Body::e_islandFlag;
+	}
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		c->m_flags &= ~b2Contact::e_islandFlag;
+	}
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->m_islandFlag = false;
+	}
 
-	if (m_stepComplete)
+	// A static body enters an island through a contact or joint, so the
+	// island edges bound the static entries.
+	int32 edgeCount = m_contactManager.m_contactCount + m_jointCount;
+	int32 stackSize = m_bodyCount;
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2Body*));
+	b2Body** statics = (b2Body**)m_stackAllocator.Allocate(edgeCount * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(m_contactManager.m_contactCount * sizeof(b2Contact*));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	b2IslandRange* ranges = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+
+	int32 islandCount = 0;
+	int32 bodyCount = 0;
+	int32 staticCount = 0;
+	int32 contactCount = 0;
+	int32 jointCount = 0;
+
+	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
 	{
-		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		if (seed->m_flags & b2Body::e_islandFlag)
 		{
-			b->m_flags &= ~b2Body::e_islandFlag;
-			b->m_sweep.alpha0 = 0.0f;
+			continue;
 		}
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		if (seed->IsAwake() == false || seed->IsActive() == false)
 		{
-			// Invalidate TOI
-			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
-			c->m_toiCount = 0;
-			c->m_toi = 1.0f;
+			continue;
 		}
-	}
 
-	// Find TOI events and solve them.
-	for (;;)
-	{
-		// Find the first TOI.
-		b2Contact* minContact = nullptr;
-		float32 minAlpha = 1.0f;
+		// The seed can be dynamic or kinematic.
+		if (seed->GetType() == b2_staticBody)
+		{
+			continue;
+		}
 
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		b2IslandRange* range = ranges + islandCount++;
+		range->bodyStart = bodyCount;
+		range->staticStart = staticCount;
+		range->contactStart = contactCount;
+		range->jointStart = jointCount;
+		range->asleep = false;
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		seed->m_flags |= b2Body::e_islandFlag;
+
+		// Perform a depth first search (DFS) on the constraint graph.
+		while (stackCount > 0)
 		{
-			// Is this contact disabled?
-			if (c->IsEnabled() == false)
-			{
-				continue;
-			}
+			b2Body* b = stack[--stackCount];
+			b2Assert(b->IsActive() == true);
 
-			// Prevent excessive sub-stepping.
-			if (c->m_toiCount > b2_maxSubSteps)
+			// To keep islands as small as possible, we don't
+			// propagate islands across static bodies.
+			if (b->GetType() == b2_staticBody)
 			{
+				b2Assert(staticCount < edgeCount);
+				statics[staticCount++] = b;
 				continue;
 			}
 
-			float32 alpha = 1.0f;
-			if (c->m_flags & b2Contact::e_toiFlag)
-			{
-				// This contact has a valid cached TOI.
-				alpha = c->m_toi;
-			}
-			else
+			bodies[bodyCount++] = b;
+
+			// Make sure the body is awake (without resetting sleep timer).
+			b->m_flags |= b2Body::e_awakeFlag;
+
+			// Search all contacts connected to this body.
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
 			{
-				b2Fixture* fA = c->GetFixtureA();
-				b2Fixture* fB = c->GetFixtureB();
+				b2Contact* contact = ce->contact;
 
-				// Is there a sensor?
-				if (fA->IsSensor() || fB->IsSensor())
+				// Has this contact already been added to an island?
+				if (contact->m_flags & b2Contact::e_islandFlag)
 				{
 					continue;
 				}
 
-				b2Body* bA = fA->GetBody();
-				b2Body* bB = fB->GetBody();
-
-				b2BodyType typeA = bA->m_type;
-				b2BodyType typeB = bB->m_type;
-				b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
-
-				bool activeA = bA->IsAwake() && typeA != b2_staticBody;
-				bool activeB = bB->IsAwake() && typeB != b2_staticBody;
-
-				// Is at least one body active (awake and dynamic or kinematic)?
-				if (activeA == false && activeB == false)
+				// Is this contact solid and touching?
+				if (contact->IsEnabled() == false ||
+					contact->IsTouching() == false)
 				{
 					continue;
 				}
 
-				bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
-				bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
-
-				// Are these two non-bullet dynamic bodies?
-				if (collideA == false && collideB == false)
+				// Skip sensors.
+				bool sensorA = contact->m_fixtureA->m_isSensor;
+				bool sensorB = contact->m_fixtureB->m_isSensor;
+				if (sensorA || sensorB)
 				{
 					continue;
 				}
 
-				// Compute the TOI for this contact.
-				// Put the sweeps onto the same time interval.
-				float32 alpha0 = bA->m_sweep.alpha0;
+				contacts[contactCount++] = contact;
+				contact->m_flags |= b2Contact::e_islandFlag;
+
+				b2Body* other = ce->other;
 
-				if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
-				{
-					alpha0 = bB->m_sweep.alpha0;
-					bA->m_sweep.Advance(alpha0);
-				}
-				else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
+				// Was the other body already added to this island?
+				if (other->m_flags & b2Body::e_islandFlag)
 				{
-					alpha0 = bA->m_sweep.alpha0;
-					bB->m_sweep.Advance(alpha0);
+					continue;
 				}
 
-				b2Assert(alpha0 < 1.0f);
-
-				int32 indexA = c->GetChildIndexA();
-				int32 indexB = c->GetChildIndexB();
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
 
-				// Compute the time of impact in interval [0, minTOI]
-				b2TOIInput input;
-				input.proxyA.Set(fA->GetShape(), indexA);
-				input.proxyB.Set(fB->GetShape(), indexB);
-				input.sweepA = bA->m_sweep;
-				input.sweepB = bB->m_sweep;
-				input.tMax = 1.0f;
+			// Search all joints connect to this body.
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				if (je->joint->m_islandFlag == true)
+				{
+					continue;
+				}
 
-				b2TOIOutput output;
-				b2TimeOfImpact(&output, &input);
+				b2Body* other = je->other;
 
-				// Beta is the fraction of the remaining portion of the .
-				float32 beta = output.t;
-				if (output.state == b2TOIOutput::e_touching)
+				// Don't simulate joints connected to inactive bodies.
+				if (other->IsActive() == false)
 				{
-					alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+					continue;
 				}
-				else
+
+				joints[jointCount++] = je->joint;
+				je->joint->m_islandFlag = true;
+
+				if (other->m_flags & b2Body::e_islandFlag)
 				{
-					alpha = 1.0f;
+					continue;
 				}
 
-				c->m_toi = alpha;
-				c->m_flags |= b2Contact::e_toiFlag;
-			}
-
-			if (alpha < minAlpha)
-			{
-				// This is the minimum TOI found so far.
-				minContact = c;
-				minAlpha = alpha;
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
 			}
 		}
 
-		if (minContact == nullptr || 1.0f - 10.0f * b2_epsilon < minAlpha)
+		range->bodyCount = bodyCount - range->bodyStart;
+		range->staticCount = staticCount - range->staticStart;
+		range->contactCount = contactCount - range->contactStart;
+		range->jointCount = jointCount - range->jointStart;
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = range->staticStart; i < staticCount; ++i)
 		{
-			// No more TOI events. Done!
-			m_stepComplete = true;
-			break;
+			statics[i]->m_flags &= ~b2Body::e_islandFlag;
 		}
+	}
 
-		// Advance the bodies to the TOI.
-		b2Fixture* fA = minContact->GetFixtureA();
-		b2Fixture* fB = minContact->GetFixtureB();
-		b2Body* bA = fA->GetBody();
-		b2Body* bB = fB->GetBody();
+	int32 threadCount = m_threadPool->GetThreadCount();
+	b2StackAllocator** allocators = (b2StackAllocator**)m_stackAllocator.Allocate(threadCount * sizeof(b2StackAllocator*));
+	b2Profile* profiles = (b2Profile*)m_stackAllocator.Allocate(threadCount * sizeof(b2Profile));
+	allocators[0] = &m_stackAllocator;
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		allocators[i] = m_threadAllocators + i - 1;
+	}
+	memset(profiles, 0, threadCount * sizeof(b2Profile));
+
+	// With graph coloring, very large islands are solved one at a time after the
+	// others, each spreading its colors over the pool.
+	bool colored = step.graphColoring || step.wideContactSolver;
+	int32* islands = (int32*)m_stackAllocator.Allocate(islandCount * sizeof(int32));
+	int32 smallCount = 0;
+	int32 largeCount = 0;
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		const b2IslandRange* range = ranges + i;
+		if (colored && range->contactCount + range->jointCount >= b2_graphParallelConstraints)
+		{
+			islands[islandCount - ++largeCount] = i;
+		}
+		else
+		{
+			islands[smallCount++] = i;
+		}
+	}
 
-		b2Sweep backup1 = bA->m_sweep;
-		b2Sweep backup2 = bB->m_sweep;
+	b2IslandSolveTask task;
+	task.m_allocators = allocators;
+	task.m_profiles = profiles;
+	task.m_ranges = ranges;
+	task.m_islands = islands;
+	task.m_bodies = bodies;
+	task.m_contacts = contacts;
+	task.m_joints = joints;
+	task.m_bodyStore = &m_bodyStore;
+	task.m_step = &step;
+	task.m_gravity = m_gravity;
+	task.m_allowSleep = m_allowSleep;
+	m_threadPool->ParallelFor(&task, smallCount, 1);
+
+	for (int32 i = smallCount; i < islandCount; ++i)
+	{
+		task.Solve(ranges + islands[i], &m_stackAllocator, profiles, m_threadPool);
+	}
 
-		bA->Advance(minAlpha);
-		bB->Advance(minAlpha);
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		m_profile.solveInit += profiles[i].solveInit;
+		m_profile.solveVelocity += profiles[i].solveVelocity;
+		m_profile.solvePosition += profiles[i].solvePosition;
+	}
 
-		// The TOI contact likely has some new contact points.
-		minContact->Update(m_contactManager.m_contactListener);
-		minContact->m_flags &= ~b2Contact::e_toiFlag;
-		++minContact->m_toiCount;
+	// Report and update the static bodies in island order, as SolveIslands would.
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		const b2IslandRange* range = ranges + i;
+		b2Island::Report(m_contactManager.m_contactListener, contacts + range->contactStart, range->contactCount);
 
-		// Is the contact solid?
-		if (minContact->IsEnabled() == false || minContact->IsTouching() == false)
+		for (int32 j = 0; j < range->staticCount; ++j)
 		{
-			// Restore the sweeps.
-			minContact->SetEnabled(false);
-			bA->m_sweep = backup1;
-			bB->m_sweep = backup2;
-			bA->SynchronizeTransform();
-			bB->SynchronizeTransform();
-			continue;
+			b2Body* b = statics[range->staticStart + j];
+			if (range->asleep)
+			{
+				b->SetAwake(false);
+			}
+			else
+			{
+				b->m_flags |= b2Body::e_awakeFlag;
+			}
 		}
+	}
 
-		bA->SetAwake(true);
-		bB->SetAwake(true);
+	m_stackAllocator.Free(islands);
+	m_stackAllocator.Free(profiles);
+	m_stackAllocator.Free(allocators);
+	m_stackAllocator.Free(ranges);
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(statics);
+	m_stackAllocator.Free(bodies);
+	m_stackAllocator.Free(stack);
+}
 
-		// Build the island
-		island.Clear();
-		island.Add(bA);
-		island.Add(bB);
-		island.Add(minContact);
+// A contact whose time of impact is computed on the thread pool. The sweeps are
+// put onto the same interval before, in contact order, because that advances
+// the sweeps of the bodies.
+struct b2TOIQuery
+{
+	b2Contact* contact;
+	b2Sweep sweepA;
+	b2Sweep sweepB;
+	b2SimplexCache cache;
+	float32 alpha;
+	int32 iterations;
+	int32 rootIterations;
+};
 
-		bA->m_flags |= b2Body::e_islandFlag;
-		bB->m_flags |= b2Body::e_islandFlag;
-		minContact->m_flags |= b2Contact::e_islandFlag;
+// The number of TOI queries a thread takes at a time.
+#define b2_toiQueryRangeSize 16
 
-		// Get contacts on bodyA and bodyB.
-		b2Body* bodies[2] = {bA, bB};
-		for (int32 i = 0; i < 2; ++i)
-		{
-			b2Body* body = bodies[i];
-			if (body->m_type == b2_dynamicBody)
-			{
-				for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
-				{
-					if (island.m_bodyCount == island.m_bodyCapacity)
-					{
-						break;
-					}
+// The number of TOI queries that are gathered before they are run.
+#define b2_toiQueryCapacity 256
 
-					if (island.m_contactCount == island.m_contactCapacity)
-					{
-						break;
-					}
+class b2TOIQueryTask : public b2ParallelTask
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		B2_NOT_USED(threadIndex);
 
-					b2Contact* contact = ce->contact;
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2TOIQuery* query = m_queries + i;
+			b2Contact* c = query->contact;
+
+			// Compute the time of impact in interval [0, minTOI]
+			b2TOIInput input;
+			input.proxyA.Set(c->GetFixtureA()->GetShape(), c->GetChildIndexA());
+			input.proxyB.Set(c->GetFixtureB()->GetShape(), c->GetChildIndexB());
+			input.sweepA = query->sweepA;
+			input.sweepB = query->sweepB;
+			input.tMax = 1.0f;
+
+			b2TOIOutput output;
+			b2TimeOfImpact(&output, &input, &query->cache);
+			query->iterations = output.iterations;
+			query->rootIterations = output.rootIterations;
+
+			// Beta is the fraction of the remaining portion of the .
+			float32 alpha0 = query->sweepA.alpha0;
+			float32 beta = output.t;
+			if (output.state == b2TOIOutput::e_touching)
+			{
+				query->alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+			}
+			else
+			{
+				query->alpha = 1.0f;
+			}
+		}
+	}
+
+	b2TOIQuery* m_queries;
+};
+
+// A TOI event of a round and the island that resolves it. Static bodies are
+// not added to the island, because the islands of a round can share them. The
+// islands of a round take their bodies and contacts from shared arrays, since
+// a moving body or a contact is in at most one of them.
+struct b2TOIIsland
+{
+	b2Contact* contact;
+	b2Body* bodyA;
+	b2Body* bodyB;
+	float32 alpha;
+	int32 order;
+	int32 bodyCount;
+	int32 contactCount;
+	b2Body** bodies;
+	b2Contact** contacts;
+	b2ContactImpulse* impulses;
+};
+
+// Sort the events of a round by time of impact. Ties keep the contact order.
+static bool b2TOIIslandLessThan(const b2TOIIsland* island1, const b2TOIIsland* island2)
+{
+	if (island1->alpha < island2->alpha)
+	{
+		return true;
+	}
+
+	if (island1->alpha == island2->alpha)
+	{
+		return island1->order < island2->order;
+	}
+
+	return false;
+}
+
+// Solves the islands of a round on the thread pool. The islands share nothing
+// but static bodies, which the TOI solver never writes.
+class b2TOISolveTask : public b2ParallelTask
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		for (int32 i = begin; i < end; ++i)
+		{
+			Solve(m_islands[i], m_allocators[threadIndex]);
+		}
+	}
+
+	void Solve(b2TOIIsland* toiIsland, b2StackAllocator* allocator)
+	{
+		b2Island island(toiIsland->bodyCount, toiIsland->contactCount, 0, m_bodyStore, allocator, nullptr);
+
+		for (int32 i = 0; i < toiIsland->bodyCount; ++i)
+		{
+			island.Add(toiIsland->bodies[i]);
+		}
+		for (int32 i = 0; i < toiIsland->contactCount; ++i)
+		{
+			island.Add(toiIsland->contacts[i]);
+		}
+
+		b2TimeStep subStep;
+		subStep.dt = (1.0f - toiIsland->alpha) * m_step->dt;
+		subStep.inv_dt = 1.0f / subStep.dt;
+		subStep.dtRatio = 1.0f;
+		subStep.positionIterations = 20;
+		subStep.velocityIterations = m_step->velocityIterations;
+		subStep.warmStarting = false;
+		subStep.graphColoring = false;
+		subStep.wideContactSolver = false;
+		island.SolveTOI(subStep, toiIsland->bodyA, toiIsland->bodyB, toiIsland->impulses);
+	}
+
+	b2StackAllocator** m_allocators;
+	b2TOIIsland** m_islands;
+	b2BodyStore* m_bodyStore;
+	const b2TimeStep* m_step;
+};
+
+// Find the root of a body in the contact components, halving the path.
+static int32 b2FindComponent(int32* parents, int32 index)
+{
+	while (parents[index] != index)
+	{
+		parents[index] = parents[parents[index]];
+		index = parents[index];
+	}
+	return index;
+}
+
+// Gathers the moving bodies whose proxies overlap a box.
+struct b2TOIReachCallback
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		b2Body* body = proxy->fixture->GetBody();
+		if (body->GetType() != b2_staticBody)
+		{
+			bodies.Push(body);
+		}
+		return true;
+	}
 
-					// Has this contact already been added to the island?
-					if (contact->m_flags & b2Contact::e_islandFlag)
+	const b2BroadPhase* broadPhase;
+	b2GrowableStack<b2Body*, 64> bodies;
+};
+
+// Compute a box that holds a body from the time alpha to the end of the step,
+// once a TOI island has moved it. The island clamps the motion to
+// b2_maxTranslation and b2_maxRotation, and the position correction before it
+// only removes the small overlap of the TOI contacts, so the fixtures stay
+// within their largest distance from the center, in any rotation, around the
+// moved center.
+static b2AABB b2ComputeTOIReach(b2Sweep sweep, const b2Fixture* fixtureList, float32 alpha)
+{
+	if (sweep.alpha0 < alpha)
+	{
+		sweep.Advance(alpha);
+	}
+
+	b2Transform xf;
+	sweep.GetTransform(&xf, 0.0f);
+
+	float32 radius = 0.0f;
+	for (const b2Fixture* f = fixtureList; f; f = f->GetNext())
+	{
+		const b2Shape* shape = f->GetShape();
+		for (int32 i = 0; i < shape->GetChildCount(); ++i)
+		{
+			b2AABB aabb;
+			shape->ComputeAABB(&aabb, xf, i);
+			b2Vec2 d = b2Max(b2Abs(aabb.lowerBound - sweep.c0), b2Abs(aabb.upperBound - sweep.c0));
+			radius = b2Max(radius, d.Length());
+		}
+	}
+
+	float32 extent = radius + b2_maxTranslation + b2_maxLinearCorrection;
+	b2AABB box;
+	box.lowerBound = sweep.c0 - b2Vec2(extent, extent);
+	box.upperBound = sweep.c0 + b2Vec2(extent, extent);
+	return box;
+}
+
+// Find TOI contacts and solve them. Each round computes the missing times of
+// impact on the thread pool, in any order, since every contact only writes its
+// own result. Without batching a round resolves the first TOI event. With
+// batching it resolves the first TOI event of every group of bodies connected
+// by contacts, unless an earlier island of the round can reach the group.
+// Events of different groups touch different bodies, so their islands are
+// solved concurrently. The listener and the broad-phase are handled afterwards
+// in TOI order.
+void b2World::SolveTOI(const b2TimeStep& step)
+{
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+
+	if (m_stepComplete)
+	{
+		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		{
+			b->m_flags &= ~b2Body::e_islandFlag;
+			b->m_alpha0 = 0.0f;
+		}
+
+		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		{
+			// Invalidate TOI
+			c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+			c->m_toiCount = 0;
+			c->m_toi = 1.0f;
+		}
+	}
+
+	int32 threadCount = m_threadPool != nullptr ? m_threadPool->GetThreadCount() : 1;
+	b2StackAllocator** allocators = (b2StackAllocator**)m_stackAllocator.Allocate(threadCount * sizeof(b2StackAllocator*));
+	allocators[0] = &m_stackAllocator;
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		allocators[i] = m_threadAllocators + i - 1;
+	}
+
+	bool batching = m_toiBatching && m_subStepping == false;
+
+	// With batching, the bodies connected by contacts form groups that are kept
+	// in a union-find over the state indices.
+	int32 nodeCount = m_bodyStore.m_count;
+	int32* parents = nullptr;
+	int32* firsts = nullptr;
+	bool* reached = nullptr;
+	b2Contact* unitedList = nullptr;
+	if (batching)
+	{
+		parents = (int32*)m_stackAllocator.Allocate(nodeCount * sizeof(int32));
+		firsts = (int32*)m_stackAllocator.Allocate(nodeCount * sizeof(int32));
+		reached = (bool*)m_stackAllocator.Allocate(nodeCount * sizeof(bool));
+		for (int32 i = 0; i < nodeCount; ++i)
+		{
+			parents[i] = i;
+			firsts[i] = -1;
+			reached[i] = false;
+		}
+	}
+
+	// Find TOI events and solve them.
+	for (;;)
+	{
+		int32 contactCount = m_contactManager.m_contactCount;
+		b2Contact** candidates = (b2Contact**)m_stackAllocator.Allocate(contactCount * sizeof(b2Contact*));
+		int32 candidateCount = 0;
+
+		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+		{
+			// Is this contact disabled?
+			if (c->IsEnabled() == false)
+			{
+				continue;
+			}
+
+			// Prevent excessive sub-stepping.
+			if (c->m_toiCount > b2_maxSubSteps)
+			{
+				continue;
+			}
+
+			if (c->m_flags & b2Contact::e_toiFlag)
+			{
+				// This contact has a valid cached TOI.
+				if (c->m_toi < 1.0f)
+				{
+					candidates[candidateCount++] = c;
+				}
+				continue;
+			}
+
+			b2Fixture* fA = c->GetFixtureA();
+			b2Fixture* fB = c->GetFixtureB();
+
+			// Is there a sensor?
+			if (fA->IsSensor() || fB->IsSensor())
+			{
+				continue;
+			}
+
+			b2Body* bA = fA->GetBody();
+			b2Body* bB = fB->GetBody();
+
+			b2BodyType typeA = bA->m_type;
+			b2BodyType typeB = bB->m_type;
+			b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
+
+			bool activeA = bA->IsAwake() && typeA != b2_staticBody;
+			bool activeB = bB->IsAwake() && typeB != b2_staticBody;
+
+			// Is at least one body active (awake and dynamic or kinematic)?
+			if (activeA == false && activeB == false)
+			{
+				continue;
+			}
+
+			bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
+			bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
+
+			// Are these two non-bullet dynamic bodies?
+			if (collideA == false && collideB == false)
+			{
+				continue;
+			}
+
+			candidates[candidateCount++] = c;
+		}
+
+		// The contacts without a cached TOI are queried in batches. The sweeps
+		// are aligned in list order, as the queries are gathered.
+		b2TOIQuery* queries = (b2TOIQuery*)m_stackAllocator.Allocate(b2_toiQueryCapacity * sizeof(b2TOIQuery));
+		int32 queryCount = 0;
+		for (int32 i = 0; i < candidateCount; ++i)
+		{
+			b2Contact* c = candidates[i];
+			if ((c->m_flags & b2Contact::e_toiFlag) == 0)
+			{
+				b2Body* bA = c->GetFixtureA()->GetBody();
+				b2Body* bB = c->GetFixtureB()->GetBody();
+				b2BodyType typeA = bA->m_type;
+				b2BodyType typeB = bB->m_type;
+
+				// Put the sweeps onto the same time interval. A static sweep fits
+				// any interval, so only moving bodies are advanced.
+				b2Sweep sweepA = bA->GetSweep();
+				b2Sweep sweepB = bB->GetSweep();
+				float32 alpha0 = sweepA.alpha0;
+
+				if (typeA == b2_staticBody)
+				{
+					alpha0 = sweepB.alpha0;
+					sweepA.alpha0 = alpha0;
+				}
+				else if (typeB == b2_staticBody)
+				{
+					sweepB.alpha0 = alpha0;
+				}
+				else if (sweepA.alpha0 < sweepB.alpha0)
+				{
+					alpha0 = sweepB.alpha0;
+					sweepA.Advance(alpha0);
+					bA->SetSweep(sweepA);
+				}
+				else if (sweepB.alpha0 < sweepA.alpha0)
+				{
+					alpha0 = sweepA.alpha0;
+					sweepB.Advance(alpha0);
+					bB->SetSweep(sweepB);
+				}
+
+				b2Assert(alpha0 < 1.0f);
+
+				b2TOIQuery* query = queries + queryCount++;
+				query->contact = c;
+				query->sweepA = sweepA;
+				query->sweepB = sweepB;
+				query->cache = c->m_toiCache;
+			}
+
+			if (queryCount == b2_toiQueryCapacity || (queryCount > 0 && i == candidateCount - 1))
+			{
+				b2TOIQueryTask queryTask;
+				queryTask.m_queries = queries;
+				if (m_threadPool != nullptr && queryCount > b2_toiQueryRangeSize)
+				{
+					m_threadPool->ParallelFor(&queryTask, queryCount, b2_toiQueryRangeSize);
+				}
+				else
+				{
+					queryTask.Execute(0, queryCount, 0);
+				}
+
+				for (int32 j = 0; j < queryCount; ++j)
+				{
+					b2Contact* contact = queries[j].contact;
+					contact->m_toi = queries[j].alpha;
+					contact->m_toiCache = queries[j].cache;
+					contact->m_flags |= b2Contact::e_toiFlag;
+
+					++m_profile.toiQueries;
+					m_profile.toiIters += queries[j].iterations;
+					m_profile.toiRootIters += queries[j].rootIterations;
+				}
+
+				queryCount = 0;
+			}
+		}
+		m_stackAllocator.Free(queries);
+
+		// Every contact that would hit another body this step is a candidate.
+		int32 eventCapacity = 0;
+		for (int32 i = 0; i < candidateCount; ++i)
+		{
+			if (candidates[i]->m_toi <= 1.0f - 10.0f * b2_epsilon)
+			{
+				++eventCapacity;
+			}
+		}
+
+		if (eventCapacity == 0)
+		{
+			// No more TOI events. Done!
+			m_stackAllocator.Free(candidates);
+			m_stepComplete = true;
+			break;
+		}
+
+		int32 eventCount = 0;
+		b2TOIIsland* islands;
+		if (batching)
+		{
+			islands = (b2TOIIsland*)m_stackAllocator.Allocate(eventCapacity * sizeof(b2TOIIsland));
+			int32* roots = (int32*)m_stackAllocator.Allocate(candidateCount * sizeof(int32));
+
+			// Bodies can only meet through a contact. Static bodies do not move,
+			// so they do not connect the bodies touching them. Contacts are not
+			// destroyed during the TOI phase and new ones are put at the head of
+			// the list, so the groups only need the contacts that are new.
+			for (b2Contact* c = m_contactManager.m_contactList; c != unitedList; c = c->m_next)
+			{
+				if (c->m_fixtureA->m_isSensor || c->m_fixtureB->m_isSensor)
+				{
+					continue;
+				}
+
+				b2Body* bA = c->m_fixtureA->m_body;
+				b2Body* bB = c->m_fixtureB->m_body;
+				if (bA->m_type == b2_staticBody || bB->m_type == b2_staticBody)
+				{
+					continue;
+				}
+
+				int32 rootA = b2FindComponent(parents, bA->m_stateIndex);
+				int32 rootB = b2FindComponent(parents, bB->m_stateIndex);
+				if (rootA != rootB)
+				{
+					parents[rootB] = rootA;
+				}
+			}
+			unitedList = m_contactManager.m_contactList;
+
+			// Take the first TOI event of each group.
+			for (int32 i = 0; i < candidateCount; ++i)
+			{
+				b2Contact* c = candidates[i];
+				b2Body* b = c->m_fixtureA->m_body;
+				if (b->m_type == b2_staticBody)
+				{
+					b = c->m_fixtureB->m_body;
+				}
+
+				int32 root = b2FindComponent(parents, b->m_stateIndex);
+				roots[i] = root;
+				if (firsts[root] == -1 || c->m_toi < candidates[firsts[root]]->m_toi)
+				{
+					firsts[root] = i;
+				}
+			}
+
+			for (int32 i = 0; i < candidateCount; ++i)
+			{
+				int32 first = firsts[roots[i]];
+				if (first == i && candidates[i]->m_toi <= 1.0f - 10.0f * b2_epsilon)
+				{
+					b2TOIIsland* island = islands + eventCount++;
+					island->contact = candidates[i];
+					island->alpha = candidates[i]->m_toi;
+					island->order = i;
+				}
+			}
+
+			for (int32 i = 0; i < candidateCount; ++i)
+			{
+				firsts[roots[i]] = -1;
+			}
+
+			m_stackAllocator.Free(roots);
+		}
+		else
+		{
+			islands = (b2TOIIsland*)m_stackAllocator.Allocate(sizeof(b2TOIIsland));
+
+			// Find the first TOI.
+			b2Contact* minContact = nullptr;
+			float32 minAlpha = 1.0f;
+			for (int32 i = 0; i < candidateCount; ++i)
+			{
+				if (candidates[i]->m_toi < minAlpha)
+				{
+					// This is the minimum TOI found so far.
+					minContact = candidates[i];
+					minAlpha = candidates[i]->m_toi;
+				}
+			}
+
+			islands->contact = minContact;
+			islands->alpha = minAlpha;
+			islands->order = 0;
+			eventCount = 1;
+		}
+
+		b2TOIIsland** order = (b2TOIIsland**)m_stackAllocator.Allocate(eventCount * sizeof(b2TOIIsland*));
+		for (int32 i = 0; i < eventCount; ++i)
+		{
+			order[i] = islands + i;
+		}
+		std::sort(order, order + eventCount, b2TOIIslandLessThan);
+
+		// An island moves its bodies from its TOI to the end of the step, so they
+		// can hit the bodies of a group with a later event in the round before
+		// that event. Such an event waits for the next round, which finds the new
+		// contacts of the island first, as without batching. The island of an
+		// event moves its two bodies and can move the bodies touching them. The
+		// proxies of the other bodies already hold their motion for the step.
+		if (batching && eventCount > 1)
+		{
+			b2TOIReachCallback callback;
+			callback.broadPhase = &m_contactManager.m_broadPhase;
+
+			int32 acceptedCount = 0;
+			for (int32 event = 0; event < eventCount; ++event)
+			{
+				b2TOIIsland* island = order[event];
+				b2Body* bodies[2] = {island->contact->m_fixtureA->m_body, island->contact->m_fixtureB->m_body};
+				b2Body* b = bodies[0]->m_type != b2_staticBody ? bodies[0] : bodies[1];
+				int32 group = b2FindComponent(parents, b->m_stateIndex);
+				if (reached[group])
+				{
+					// The contact keeps its time of impact.
+					continue;
+				}
+
+				order[acceptedCount++] = island;
+
+				for (int32 i = 0; i < 2; ++i)
+				{
+					b2Body* body = bodies[i];
+					if (body->m_type == b2_staticBody)
 					{
 						continue;
 					}
 
-					// Only add static, kinematic, or bullet bodies.
-					b2Body* other = ce->other;
-					if (other->m_type == b2_dynamicBody &&
-						body->IsBullet() == false && other->IsBullet() == false)
+					b2AABB box = b2ComputeTOIReach(body->GetSweep(), body->m_fixtureList, island->alpha);
+					m_contactManager.m_broadPhase.Query(&callback, box);
+
+					if (body->m_type != b2_dynamicBody)
 					{
 						continue;
 					}
 
-					// Skip sensors.
-					bool sensorA = contact->m_fixtureA->m_isSensor;
-					bool sensorB = contact->m_fixtureB->m_isSensor;
-					if (sensorA || sensorB)
+					for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 					{
-						continue;
+						b2Contact* contact = ce->contact;
+						b2Body* other = ce->other;
+						if (other->m_type == b2_staticBody || other == bodies[1 - i] ||
+							contact->m_fixtureA->m_isSensor || contact->m_fixtureB->m_isSensor)
+						{
+							continue;
+						}
+
+						box = b2ComputeTOIReach(other->GetSweep(), other->m_fixtureList, island->alpha);
+						m_contactManager.m_broadPhase.Query(&callback, box);
 					}
+				}
 
-					// Tentatively advance the body to the TOI.
-					b2Sweep backup = other->m_sweep;
-					if ((other->m_flags & b2Body::e_islandFlag) == 0)
+				while (callback.bodies.GetCount() > 0)
+				{
+					int32 root = b2FindComponent(parents, callback.bodies.Pop()->m_stateIndex);
+					if (root != group)
 					{
-						other->Advance(minAlpha);
+						reached[root] = true;
 					}
+				}
+			}
 
-					// Update the contact points
-					contact->Update(m_contactManager.m_contactListener);
+			memset(reached, 0, nodeCount * sizeof(bool));
+			eventCount = acceptedCount;
+		}
 
-					// Was the contact disabled by the user?
-					if (contact->IsEnabled() == false)
-					{
-						other->m_sweep = backup;
-						other->SynchronizeTransform();
-						continue;
-					}
+		int32 bodyCapacity = b2Min(m_bodyCount, 2 * b2_maxTOIContacts * eventCount);
+		int32 contactCapacity = b2Min(contactCount, b2_maxTOIContacts * eventCount);
+		b2Body** islandBodies = (b2Body**)m_stackAllocator.Allocate(bodyCapacity * sizeof(b2Body*));
+		b2Contact** islandContacts = (b2Contact**)m_stackAllocator.Allocate(contactCapacity * sizeof(b2Contact*));
+		b2ContactImpulse* islandImpulses = (b2ContactImpulse*)m_stackAllocator.Allocate(contactCapacity * sizeof(b2ContactImpulse));
+		int32 bodyOffset = 0;
+		int32 contactOffset = 0;
+
+		// Build the islands in TOI order. This makes the contact callbacks.
+		int32 islandCount = 0;
+		for (int32 event = 0; event < eventCount; ++event)
+		{
+			b2TOIIsland* island = order[event];
+			b2Contact* minContact = island->contact;
+			float32 minAlpha = island->alpha;
 
-					// Are there contact points?
-					if (contact->IsTouching() == false)
-					{
-						other->m_sweep = backup;
-						other->SynchronizeTransform();
-						continue;
-					}
+			// Advance the bodies to the TOI.
+			b2Fixture* fA = minContact->GetFixtureA();
+			b2Fixture* fB = minContact->GetFixtureB();
+			b2Body* bA = fA->GetBody();
+			b2Body* bB = fB->GetBody();
 
-					// Add the contact to the island
-					contact->m_flags |= b2Contact::e_islandFlag;
-					island.Add(contact);
+			b2Sweep backup1 = bA->GetSweep();
+			b2Sweep backup2 = bB->GetSweep();
 
-					// Has the other body already been added to the island?
-					if (other->m_flags & b2Body::e_islandFlag)
-					{
-						continue;
-					}
-					
-					// Add the other body to the island.
-					other->m_flags |= b2Body::e_islandFlag;
+			bA->Advance(minAlpha);
+			bB->Advance(minAlpha);
+
+			// The TOI contact likely has some new contact points.
+			minContact->Update(listener, 0.0f, nullptr);
+			minContact->m_flags &= ~b2Contact::e_toiFlag;
+			++minContact->m_toiCount;
+
+			// Is the contact solid?
+			if (minContact->IsEnabled() == false || minContact->IsTouching() == false)
+			{
+				// Restore the sweeps.
+				minContact->SetEnabled(false);
+				bA->SetSweep(backup1);
+				bB->SetSweep(backup2);
+				bA->SynchronizeTransform();
+				bB->SynchronizeTransform();
+				continue;
+			}
+
+			bA->SetAwake(true);
+			bB->SetAwake(true);
+
+			// Build the island. The body count includes the static bodies,
+			// which are kept apart.
+			order[islandCount++] = island;
+			island->bodyA = bA;
+			island->bodyB = bB;
+			island->bodyCount = 0;
+			island->contactCount = 0;
+			island->bodies = islandBodies + bodyOffset;
+			island->contacts = islandContacts + contactOffset;
+			island->impulses = islandImpulses + contactOffset;
+
+			b2Body* statics[2 * b2_maxTOIContacts];
+			int32 staticCount = 0;
+			int32 bodyCount = 2;
+
+			b2Body* bodies[2] = {bA, bB};
+			for (int32 i = 0; i < 2; ++i)
+			{
+				if (bodies[i]->m_type == b2_staticBody)
+				{
+					statics[staticCount++] = bodies[i];
+				}
+				else
+				{
+					island->bodies[island->bodyCount++] = bodies[i];
+				}
+			}
+			island->contacts[island->contactCount++] = minContact;
 
-					if (other->m_type != b2_staticBody)
+			bA->m_flags |= b2Body::e_islandFlag;
+			bB->m_flags |= b2Body::e_islandFlag;
+			minContact->m_flags |= b2Contact::e_islandFlag;
+
+			// Get contacts on bodyA and bodyB.
+			for (int32 i = 0; i < 2; ++i)
+			{
+				b2Body* body = bodies[i];
+				if (body->m_type == b2_dynamicBody)
+				{
+					for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 					{
+						if (bodyCount == 2 * b2_maxTOIContacts)
+						{
+							break;
+						}
+
+						if (island->contactCount == b2_maxTOIContacts)
+						{
+							break;
+						}
+
+						b2Contact* contact = ce->contact;
+
+						// Has this contact already been added to the island?
+						if (contact->m_flags & b2Contact::e_islandFlag)
+						{
+							continue;
+						}
+
+						// Only add static, kinematic, or bullet bodies.
+						b2Body* other = ce->other;
+						if (other->m_type == b2_dynamicBody &&
+							body->IsBullet() == false && other->IsBullet() == false)
+						{
+							continue;
+						}
+
+						// Skip sensors.
+						bool sensorA = contact->m_fixtureA->m_isSensor;
+						bool sensorB = contact->m_fixtureB->m_isSensor;
+						if (sensorA || sensorB)
+						{
+							continue;
+						}
+
+						// Tentatively advance the body to the TOI.
+						b2Sweep backup = other->GetSweep();
+						if ((other->m_flags & b2Body::e_islandFlag) == 0)
+						{
+							other->Advance(minAlpha);
+						}
+
+						// Update the contact points
+						contact->Update(listener, 0.0f, nullptr);
+
+						// Was the contact disabled by the user?
+						if (contact->IsEnabled() == false)
+						{
+							other->SetSweep(backup);
+							other->SynchronizeTransform();
+							continue;
+						}
+
+						// Are there contact points?
+						if (contact->IsTouching() == false)
+						{
+							other->SetSweep(backup);
+							other->SynchronizeTransform();
+							continue;
+						}
+
+						// Add the contact to the island
+						contact->m_flags |= b2Contact::e_islandFlag;
+						island->contacts[island->contactCount++] = contact;
+
+						// Has the other body already been added to the island?
+						if (other->m_flags & b2Body::e_islandFlag)
+						{
+							continue;
+						}
+
+						// Add the other body to the island.
+						other->m_flags |= b2Body::e_islandFlag;
+						++bodyCount;
+
+						if (other->m_type == b2_staticBody)
+						{
+							statics[staticCount++] = other;
+							continue;
+						}
+
 						other->SetAwake(true);
+						island->bodies[island->bodyCount++] = other;
 					}
-
-					island.Add(other);
 				}
 			}
+
+			// Allow static bodies to participate in other islands.
+			for (int32 i = 0; i < staticCount; ++i)
+			{
+				statics[i]->m_flags &= ~b2Body::e_islandFlag;
+			}
+
+			bodyOffset += island->bodyCount;
+			contactOffset += island->contactCount;
+			b2Assert(bodyOffset <= bodyCapacity && contactOffset <= contactCapacity);
 		}
 
-		b2TimeStep subStep;
-		subStep.dt = (1.0f - minAlpha) * step.dt;
-		subStep.inv_dt = 1.0f / subStep.dt;
-		subStep.dtRatio = 1.0f;
-		subStep.positionIterations = 20;
-		subStep.velocityIterations = step.velocityIterations;
-		subStep.warmStarting = false;
-		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
+		b2TOISolveTask solveTask;
+		solveTask.m_allocators = allocators;
+		solveTask.m_islands = order;
+		solveTask.m_bodyStore = &m_bodyStore;
+		solveTask.m_step = &step;
+		if (m_threadPool != nullptr && islandCount > 1)
+		{
+			m_threadPool->ParallelFor(&solveTask, islandCount, 1);
+		}
+		else
+		{
+			solveTask.Execute(0, islandCount, 0);
+		}
 
-		// Reset island flags and synchronize broad-phase proxies.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		for (int32 i = 0; i < islandCount; ++i)
 		{
-			b2Body* body = island.m_bodies[i];
-			body->m_flags &= ~b2Body::e_islandFlag;
+			b2TOIIsland* island = order[i];
 
-			if (body->m_type != b2_dynamicBody)
+			if (listener != nullptr)
 			{
-				continue;
+				for (int32 j = 0; j < island->contactCount; ++j)
+				{
+					listener->PostSolve(island->contacts[j], island->impulses + j);
+				}
 			}
 
-			body->SynchronizeFixtures();
-
-			// Invalidate all contact TOIs on this displaced body.
-			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+			// Reset island flags and synchronize broad-phase proxies.
+			for (int32 j = 0; j < island->bodyCount; ++j)
 			{
-				ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+				b2Body* body = island->bodies[j];
+				body->m_flags &= ~b2Body::e_islandFlag;
+
+				if (body->m_type != b2_dynamicBody)
+				{
+					continue;
+				}
+
+				body->SynchronizeFixtures();
+
+				// Invalidate all contact TOIs on this displaced body.
+				for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+				{
+					ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+				}
 			}
 		}
 
@@ -886,18 +1810,42 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		// Also, some contacts can be destroyed.
 		m_contactManager.FindNewContacts();
 
-		if (m_subStepping)
+		m_profile.toiEvents += islandCount;
+		++m_profile.toiRounds;
+
+		m_stackAllocator.Free(islandImpulses);
+		m_stackAllocator.Free(islandContacts);
+		m_stackAllocator.Free(islandBodies);
+		m_stackAllocator.Free(order);
+		m_stackAllocator.Free(islands);
+		m_stackAllocator.Free(candidates);
+
+		if (m_subStepping && islandCount > 0)
 		{
 			m_stepComplete = false;
 			break;
 		}
 	}
+
+	if (batching)
+	{
+		m_stackAllocator.Free(reached);
+		m_stackAllocator.Free(firsts);
+		m_stackAllocator.Free(parents);
+	}
+	m_stackAllocator.Free(allocators);
 }
 
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
 	b2Timer stepTimer;
 
+	m_stackAllocator.ResetStatistics();
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].ResetStatistics();
+	}
+
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
 	{
@@ -923,11 +1871,20 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.graphColoring = m_graphColoring;
+	step.wideContactSolver = m_wideContactSolver;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
 		b2Timer timer;
-		m_contactManager.Collide();
+		if (m_threadPool != nullptr)
+		{
+			m_contactManager.CollideParallel();
+		}
+		else
+		{
+			m_contactManager.Collide();
+		}
 		m_profile.collide = timer.GetMilliseconds();
 	}
 
@@ -940,6 +1897,11 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	}
 
 	// Handle TOI events.
+	m_profile.toiEvents = 0;
+	m_profile.toiRounds = 0;
+	m_profile.toiQueries = 0;
+	m_profile.toiIters = 0;
+	m_profile.toiRootIters = 0;
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
 		b2Timer timer;
@@ -959,6 +1921,18 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 
 	m_flags &= ~e_locked;
 
+	m_profile.manifoldHits = m_contactManager.m_manifoldStats.hits;
+	m_profile.manifoldMisses = m_contactManager.m_manifoldStats.misses;
+	m_profile.manifoldError = m_contactManager.m_manifoldStats.maxError;
+
+	m_profile.stackPeak = m_stackAllocator.GetPeakAllocation();
+	m_profile.stackOverflows = m_stackAllocator.GetOverflowCount();
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_profile.stackPeak = b2Max(m_profile.stackPeak, m_threadAllocators[i].GetPeakAllocation());
+		m_profile.stackOverflows += m_threadAllocators[i].GetOverflowCount();
+	}
+
 	m_profile.step = stepTimer.GetMilliseconds();
 }
 
@@ -1028,6 +2002,122 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
+struct b2WorldRayPacketWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId, int32 rayIndex)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		b2Fixture* fixture = proxy->fixture;
+		if ((fixture->GetFilterData().categoryBits & maskBits) == 0)
+		{
+			return -1.0f;
+		}
+
+		b2RayCastOutput output;
+		bool hit = fixture->RayCast(&output, input, proxy->childIndex);
+		if (hit == false)
+		{
+			return -1.0f;
+		}
+
+		// The ray is clipped to the hit, so a later hit is never farther.
+		b2RayCastHit* result = hits + rayIndex;
+		result->fixture = fixture;
+		result->point = (1.0f - output.fraction) * input.p1 + output.fraction * input.p2;
+		result->normal = output.normal;
+		result->fraction = output.fraction;
+		return output.fraction;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2RayCastHit* hits;
+	uint16 maskBits;
+};
+
+// Cast the rays in [begin, end) in packets.
+static void b2RayCastRange(const b2BroadPhase* broadPhase, const b2Vec2* point1s, const b2Vec2* point2s,
+						   int32 begin, int32 end, uint16 maskBits, b2RayCastHit* hits)
+{
+	b2WorldRayPacketWrapper wrapper;
+	wrapper.broadPhase = broadPhase;
+	wrapper.maskBits = maskBits;
+
+	for (int32 i = begin; i < end; i += b2_rayPacketSize)
+	{
+		int32 count = b2Min(end - i, b2_rayPacketSize);
+
+		b2RayCastInput inputs[b2_rayPacketSize];
+		for (int32 j = 0; j < count; ++j)
+		{
+			inputs[j].p1 = point1s[i + j];
+			inputs[j].p2 = point2s[i + j];
+			inputs[j].maxFraction = 1.0f;
+
+			b2RayCastHit* hit = hits + i + j;
+			hit->fixture = nullptr;
+			hit->point = point2s[i + j];
+			hit->normal.SetZero();
+			hit->fraction = 1.0f;
+		}
+
+		wrapper.hits = hits + i;
+		broadPhase->RayCastPacket(&wrapper, inputs, count);
+	}
+}
+
+// The number of ray packets a thread takes at a time.
+#define b2_rayPacketRangeSize 16
+
+class b2RayCastBatchTask : public b2ParallelTask
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		B2_NOT_USED(threadIndex);
+
+		// The range is in packets.
+		int32 rayBegin = begin * b2_rayPacketSize;
+		int32 rayEnd = b2Min(end * b2_rayPacketSize, m_count);
+		b2RayCastRange(m_broadPhase, m_point1s, m_point2s, rayBegin, rayEnd, m_maskBits, m_hits);
+	}
+
+	const b2BroadPhase* m_broadPhase;
+	const b2Vec2* m_point1s;
+	const b2Vec2* m_point2s;
+	int32 m_count;
+	uint16 m_maskBits;
+	b2RayCastHit* m_hits;
+};
+
+void b2World::RayCastBatch(const b2Vec2* point1s, const b2Vec2* point2s, int32 count, uint16 maskBits,
+						   b2RayCastHit* hits) const
+{
+	// The step may be using the thread pool and the trees are being updated.
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	const b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+
+	int32 packetCount = (count + b2_rayPacketSize - 1) / b2_rayPacketSize;
+	if (m_threadPool == nullptr || packetCount < 2 * b2_rayPacketRangeSize)
+	{
+		b2RayCastRange(broadPhase, point1s, point2s, 0, count, maskBits, hits);
+		return;
+	}
+
+	b2RayCastBatchTask task;
+	task.m_broadPhase = broadPhase;
+	task.m_point1s = point1s;
+	task.m_point2s = point2s;
+	task.m_count = count;
+	task.m_maskBits = maskBits;
+	task.m_hits = hits;
+	m_threadPool->ParallelFor(&task, packetCount, b2_rayPacketRangeSize);
+}
+
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
 {
 	switch (fixture->GetType())
@@ -1254,6 +2344,38 @@ void b2World::DrawDebugData()
 	}
 }
 
+void b2World::SetSweepAndPrune(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	m_contactManager.m_broadPhase.SetPairMethod(flag ? b2BroadPhase::e_sweepAndPrune : b2BroadPhase::e_treeQueries);
+}
+
+void b2World::SetStaticTree(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	if (broadPhase->GetStaticTreeEnabled() == flag)
+	{
+		return;
+	}
+
+	broadPhase->SetStaticTreeEnabled(flag);
+
+	// Move the proxies of the static bodies into the tree for the new setting.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if (b->m_type != b2_staticBody)
+		{
+			continue;
+		}
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			f->UpdateProxyTree(broadPhase, b->m_xf);
+		}
+	}
+}
+
 int32 b2World::GetProxyCount() const
 {
 	return m_contactManager.m_broadPhase.GetProxyCount();
@@ -1285,8 +2407,8 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
 	{
 		b->m_xf.p -= newOrigin;
-		b->m_sweep.c0 -= newOrigin;
-		b->m_sweep.c -= newOrigin;
+		b->m_c0 -= newOrigin;
+		b->GetPositionState().c -= newOrigin;
 	}
 
 	for (b2Joint* j = m_jointList; j; j = j->m_next)
@@ -1297,6 +2419,190 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 	m_contactManager.m_broadPhase.ShiftOrigin(newOrigin);
 }
 
+void b2World::Snapshot(b2WorldSnapshot* snapshot) const
+{
+	b2Assert(IsLocked() == false);
+
+	int32 fixtureCount = 0;
+	int32 proxyCount = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		fixtureCount += b->m_fixtureCount;
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			proxyCount += f->m_proxyCount;
+		}
+	}
+
+	snapshot->Reserve(m_bodyCount, fixtureCount, proxyCount, m_contactManager.m_contactCount);
+
+	snapshot->m_bodyCount = 0;
+	snapshot->m_fixtureCount = 0;
+	snapshot->m_proxyCount = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2WorldSnapshot::b2BodyState* bs = snapshot->m_bodies + snapshot->m_bodyCount++;
+		bs->body = b;
+		bs->type = b->m_type;
+		bs->flags = b->m_flags;
+		bs->fixtureCount = b->m_fixtureCount;
+		bs->xf = b->m_xf;
+		bs->sweep = b->GetSweep();
+		bs->linearVelocity = b->GetVelocityState().v;
+		bs->angularVelocity = b->GetVelocityState().w;
+		bs->force = b->m_force;
+		bs->torque = b->m_torque;
+		bs->mass = b->m_mass;
+		bs->invMass = b->m_invMass;
+		bs->I = b->m_I;
+		bs->invI = b->m_invI;
+		bs->sleepTime = b->m_sleepTime;
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			b2WorldSnapshot::b2FixtureState* fs = snapshot->m_fixtures + snapshot->m_fixtureCount++;
+			fs->fixture = f;
+			fs->proxies = f->m_proxies;
+			fs->proxyCount = f->m_proxyCount;
+
+			for (int32 i = 0; i < f->m_proxyCount; ++i)
+			{
+				b2WorldSnapshot::b2ProxyState* ps = snapshot->m_proxies + snapshot->m_proxyCount++;
+				ps->aabb = f->m_proxies[i].aabb;
+				ps->proxyId = f->m_proxies[i].proxyId;
+			}
+		}
+	}
+
+	snapshot->m_contactCount = 0;
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		b2WorldSnapshot::b2ContactState* cs = snapshot->m_contacts + snapshot->m_contactCount++;
+		cs->fixtureA = c->m_fixtureA;
+		cs->fixtureB = c->m_fixtureB;
+		cs->indexA = c->m_indexA;
+		cs->indexB = c->m_indexB;
+		cs->flags = c->m_flags;
+		cs->manifold = c->m_manifold;
+		cs->manifoldXf = c->m_manifoldXf;
+		cs->toiCount = c->m_toiCount;
+		cs->toi = c->m_toi;
+		cs->toiCache = c->m_toiCache;
+		cs->friction = c->m_friction;
+		cs->restitution = c->m_restitution;
+		cs->tangentSpeed = c->m_tangentSpeed;
+	}
+
+	snapshot->m_broadPhase.CopyFrom(m_contactManager.m_broadPhase);
+
+	snapshot->m_gravity = m_gravity;
+	snapshot->m_flags = m_flags;
+	snapshot->m_inv_dt0 = m_inv_dt0;
+	snapshot->m_stepComplete = m_stepComplete;
+	snapshot->m_empty = false;
+}
+
+bool b2World::Restore(const b2WorldSnapshot& snapshot)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || snapshot.m_empty || snapshot.m_bodyCount != m_bodyCount)
+	{
+		return false;
+	}
+
+	// Verify that the snapshot still matches the bodies and fixtures of this
+	// world before touching anything.
+	{
+		int32 bodyIndex = 0;
+		int32 fixtureIndex = 0;
+		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		{
+			const b2WorldSnapshot::b2BodyState* bs = snapshot.m_bodies + bodyIndex++;
+			if (bs->body != b || bs->type != b->m_type || bs->fixtureCount != b->m_fixtureCount)
+			{
+				return false;
+			}
+
+			for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+			{
+				const b2WorldSnapshot::b2FixtureState* fs = snapshot.m_fixtures + fixtureIndex++;
+				if (fs->fixture != f || fs->proxies != f->m_proxies || fs->proxyCount != f->m_proxyCount)
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	// Drop the current contacts. They are recreated from the snapshot.
+	b2Contact* c = m_contactManager.m_contactList;
+	while (c)
+	{
+		b2Contact* cNext = c->m_next;
+		b2Contact::Destroy(c, &m_blockAllocator);
+		c = cNext;
+	}
+	m_contactManager.m_contactList = nullptr;
+	m_contactManager.m_contactCount = 0;
+
+	int32 bodyIndex = 0;
+	int32 proxyIndex = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		const b2WorldSnapshot::b2BodyState* bs = snapshot.m_bodies + bodyIndex++;
+		b->m_flags = bs->flags;
+		b->m_xf = bs->xf;
+		b->SetSweep(bs->sweep);
+		b->GetVelocityState().v = bs->linearVelocity;
+		b->GetVelocityState().w = bs->angularVelocity;
+		b->m_force = bs->force;
+		b->m_torque = bs->torque;
+		b->m_mass = bs->mass;
+		b->m_invMass = bs->invMass;
+		b->m_I = bs->I;
+		b->m_invI = bs->invI;
+		b->m_sleepTime = bs->sleepTime;
+		b->m_contactList = nullptr;
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			for (int32 i = 0; i < f->m_proxyCount; ++i)
+			{
+				const b2WorldSnapshot::b2ProxyState* ps = snapshot.m_proxies + proxyIndex++;
+				f->m_proxies[i].aabb = ps->aabb;
+				f->m_proxies[i].proxyId = ps->proxyId;
+			}
+		}
+	}
+
+	// Contacts are pushed at the head of the lists, so recreate them oldest
+	// first to reproduce the world and body contact list order.
+	for (int32 i = snapshot.m_contactCount - 1; i >= 0; --i)
+	{
+		const b2WorldSnapshot::b2ContactState* cs = snapshot.m_contacts + i;
+		c = b2Contact::Create(cs->fixtureA, cs->indexA, cs->fixtureB, cs->indexB, &m_blockAllocator);
+		b2Assert(c != nullptr && c->m_fixtureA == cs->fixtureA);
+		c->m_flags = cs->flags;
+		c->m_manifold = cs->manifold;
+		c->m_manifoldXf = cs->manifoldXf;
+		c->m_toiCount = cs->toiCount;
+		c->m_toi = cs->toi;
+		c->m_toiCache = cs->toiCache;
+		c->m_friction = cs->friction;
+		c->m_restitution = cs->restitution;
+		c->m_tangentSpeed = cs->tangentSpeed;
+		m_contactManager.Link(c);
+	}
+
+	m_contactManager.m_broadPhase.CopyFrom(snapshot.m_broadPhase);
+
+	m_gravity = snapshot.m_gravity;
+	m_flags = snapshot.m_flags;
+	m_inv_dt0 = snapshot.m_inv_dt0;
+	m_stepComplete = snapshot.m_stepComplete;
+	return true;
+}
+
 void b2World::Dump()
 {
 	if ((m_flags & e_locked) == e_locked)
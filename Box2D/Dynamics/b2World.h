@@ -22,6 +22,7 @@
 #include "Box2D/Common/b2Math.h"
 #include "Box2D/Common/b2BlockAllocator.h"
 #include "Box2D/Common/b2StackAllocator.h"
+#include "Box2D/Dynamics/b2BodyStore.h"
 #include "Box2D/Dynamics/b2ContactManager.h"
 #include "Box2D/Dynamics/b2WorldCallbacks.h"
 #include "Box2D/Dynamics/b2TimeStep.h"
@@ -34,6 +35,18 @@ class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2ThreadPool;
+class b2WorldSnapshot;
+
+/// The closest hit of a ray.
+/// See b2World::RayCastBatch
+struct b2RayCastHit
+{
+	b2Fixture* fixture;	///< the fixture hit by the ray, nullptr for a miss
+	b2Vec2 point;		///< the point of initial intersection
+	b2Vec2 normal;		///< the normal vector at the point of intersection
+	float32 fraction;	///< the fraction of the segment at the point, 1 for a miss
+};
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -121,6 +134,20 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Ray-cast the world for the closest hit of many rays without callbacks. The
+	/// hits are the same as with RayCast and a callback that clips to every hit.
+	/// Neighboring rays are traced together in packets, so keep rays that are close
+	/// to each other next to each other, like the rays of a fan. With a thread
+	/// pool the packets are spread over the threads.
+	/// @param point1s the ray starting points
+	/// @param point2s the ray ending points
+	/// @param count the number of rays
+	/// @param maskBits fixtures whose category bits do not overlap these are ignored
+	/// @param hits receives the closest hit of each ray
+	/// @warning This function is locked during callbacks. The hits are not written then.
+	void RayCastBatch(const b2Vec2* point1s, const b2Vec2* point2s, int32 count, uint16 maskBits,
+					  b2RayCastHit* hits) const;
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A nullptr body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -141,6 +168,15 @@ public:
 	b2Contact* GetContactList();
 	const b2Contact* GetContactList() const;
 
+	/// Register a thread pool to find new contacts, update contact manifolds,
+	/// solve independent islands and compute times of impact in parallel. Contact callbacks are still made on the calling
+	/// thread in the usual order. The pool is owned by you and must remain in scope. It must not be running another
+	/// task while the world steps. The results do not depend on the thread count.
+	/// Pass nullptr to solve on the calling thread only.
+	/// @warning This function is locked during callbacks.
+	void SetThreadPool(b2ThreadPool* pool);
+	b2ThreadPool* GetThreadPool() const { return m_threadPool; }
+
 	/// Enable/disable sleep.
 	void SetAllowSleeping(bool flag);
 	bool GetAllowSleeping() const { return m_allowSleep; }
@@ -149,6 +185,52 @@ public:
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 	bool GetWarmStarting() const { return m_warmStarting; }
 
+	/// Enable/disable graph coloring. The contacts and joints of large islands
+	/// are partitioned into colors that share no body and solved one color at
+	/// a time. With a thread pool the colors of very large islands are spread
+	/// over the threads. This changes the order of the velocity iterations, but
+	/// the result does not depend on the thread count.
+	void SetGraphColoring(bool flag) { m_graphColoring = flag; }
+	bool GetGraphColoring() const { return m_graphColoring; }
+
+	/// Enable/disable the wide contact solver. It packs each color of the
+	/// constraint graph into SIMD batches and implies graph coloring. The result
+	/// is the same as with graph coloring alone.
+	void SetWideContactSolver(bool flag) { m_wideContactSolver = flag; }
+	bool GetWideContactSolver() const { return m_wideContactSolver; }
+
+	/// Enable/disable wide trees for QueryAABB and RayCast. The broad-phase keeps
+	/// a four-wide copy of its trees that is refreshed at the end of each step,
+	/// so queries between steps test four AABBs at a time. Queries made during
+	/// a step fall back to the binary trees. Callbacks may come in another order.
+	void SetWideTreeQueries(bool flag) { m_contactManager.m_broadPhase.SetWideTreesEnabled(flag); }
+	bool GetWideTreeQueries() const { return m_contactManager.m_broadPhase.GetWideTreesEnabled(); }
+
+	/// Set the tolerance of the manifold cache. A touching contact keeps its
+	/// manifold instead of colliding the shapes again while its bodies have
+	/// moved so little relative to each other since the manifold was computed
+	/// that no contact point can be off by more than the tolerance. This helps
+	/// resting piles, where most contacts barely move. The counts and the error
+	/// are in b2Profile. Zero disables the cache, which is the default.
+	/// b2_manifoldCacheTolerance is a good value.
+	void SetManifoldCacheTolerance(float32 tolerance) { m_contactManager.m_manifoldTolerance = tolerance; }
+	float32 GetManifoldCacheTolerance() const { return m_contactManager.m_manifoldTolerance; }
+
+	/// Enable/disable sweep and prune for finding new contacts. The broad-phase
+	/// keeps the fixture bounds sorted along both axes instead of querying its
+	/// trees for every moved fixture, which is faster for piles of many similar
+	/// sized bodies. The contacts are the same, except that destroying a joint
+	/// that disabled collision pairs its bodies again right away.
+	void SetSweepAndPrune(bool flag);
+	bool GetSweepAndPrune() const { return m_contactManager.m_broadPhase.GetPairMethod() == b2BroadPhase::e_sweepAndPrune; }
+
+	/// Enable/disable the static tree. The broad-phase keeps the fixtures of static
+	/// bodies in a tree of their own that is rebuilt in one go after a batch of
+	/// changes, and moving fixtures query it without static fixtures ever querying
+	/// each other. The contacts are the same but may be created in another order.
+	void SetStaticTree(bool flag);
+	bool GetStaticTree() const { return m_contactManager.m_broadPhase.GetStaticTreeEnabled(); }
+
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
@@ -157,6 +239,19 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Enable/disable batched continuous physics. Each round of TOI events then
+	/// resolves the first event of every group of bodies connected by contacts
+	/// instead of only the first event of the world, and with a thread pool the
+	/// events of a round are solved in parallel. A later event of the round waits
+	/// for the next round when the bodies moved by an earlier event could reach
+	/// its group before the end of the step, so bodies that meet still collide.
+	/// The events of groups that stay apart are resolved in another order than
+	/// without batching, which changes the contact callback order and can change
+	/// the result slightly. The result does not depend on the thread count. This
+	/// has no effect with sub-stepping.
+	void SetTOIBatching(bool flag) { m_toiBatching = flag; }
+	bool GetTOIBatching() const { return m_toiBatching; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -199,6 +294,18 @@ public:
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Capture the simulation state of the world: body motion, fixture proxies,
+	/// contacts with their warm starting impulses and the broad-phase.
+	/// @warning this should be called outside of a time step.
+	void Snapshot(b2WorldSnapshot* snapshot) const;
+
+	/// Restore a state captured by Snapshot. No callbacks are reported. The
+	/// following steps are identical to the steps taken after the snapshot.
+	/// @return false if bodies or fixtures were created or destroyed since
+	/// the snapshot. The world is left unchanged in that case.
+	/// @warning this should be called outside of a time step.
+	bool Restore(const b2WorldSnapshot& snapshot);
+
 	/// Get the contact manager for testing.
 	const b2ContactManager& GetContactManager() const;
 
@@ -225,6 +332,8 @@ private:
 	friend class b2Controller;
 
 	void Solve(const b2TimeStep& step);
+	void SolveIslands(const b2TimeStep& step);
+	void SolveIslandsParallel(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
 	void DrawJoint(b2Joint* joint);
@@ -233,10 +342,19 @@ private:
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
+	// Stack allocators of the helper threads of the pool. The calling
+	// thread uses m_stackAllocator.
+	b2ThreadPool* m_threadPool;
+	b2StackAllocator* m_threadAllocators;
+	int32 m_threadAllocatorCount;
+
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
 
+	// The positions and velocities of the bodies.
+	b2BodyStore m_bodyStore;
+
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
 
@@ -255,8 +373,11 @@ private:
 
 	// These are for debugging the solver.
 	bool m_warmStarting;
+	bool m_graphColoring;
+	bool m_wideContactSolver;
 	bool m_continuousPhysics;
 	bool m_subStepping;
+	bool m_toiBatching;
 
 	bool m_stepComplete;
 
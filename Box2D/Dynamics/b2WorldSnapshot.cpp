@@ -0,0 +1,84 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Box2D/Dynamics/b2WorldSnapshot.h"
+
+// Grow an array without preserving its content. The snapshot arrays are
+// rewritten completely on every capture.
+template <typename T>
+static T* b2ReserveArray(T* array, int32* capacity, int32 count)
+{
+	if (count <= *capacity)
+	{
+		return array;
+	}
+
+	b2Free(array);
+	*capacity = b2Max(count, 2 * *capacity);
+	return (T*)b2Alloc(*capacity * sizeof(T));
+}
+
+b2WorldSnapshot::b2WorldSnapshot()
+{
+	m_bodies = nullptr;
+	m_bodyCount = 0;
+	m_bodyCapacity = 0;
+
+	m_fixtures = nullptr;
+	m_fixtureCount = 0;
+	m_fixtureCapacity = 0;
+
+	m_proxies = nullptr;
+	m_proxyCount = 0;
+	m_proxyCapacity = 0;
+
+	m_contacts = nullptr;
+	m_contactCount = 0;
+	m_contactCapacity = 0;
+
+	m_gravity.SetZero();
+	m_flags = 0;
+	m_inv_dt0 = 0.0f;
+	m_stepComplete = true;
+	m_empty = true;
+}
+
+b2WorldSnapshot::~b2WorldSnapshot()
+{
+	b2Free(m_bodies);
+	b2Free(m_fixtures);
+	b2Free(m_proxies);
+	b2Free(m_contacts);
+}
+
+void b2WorldSnapshot::Clear()
+{
+	m_bodyCount = 0;
+	m_fixtureCount = 0;
+	m_proxyCount = 0;
+	m_contactCount = 0;
+	m_empty = true;
+}
+
+void b2WorldSnapshot::Reserve(int32 bodyCount, int32 fixtureCount, int32 proxyCount, int32 contactCount)
+{
+	m_bodies = b2ReserveArray(m_bodies, &m_bodyCapacity, bodyCount);
+	m_fixtures = b2ReserveArray(m_fixtures, &m_fixtureCapacity, fixtureCount);
+	m_proxies = b2ReserveArray(m_proxies, &m_proxyCapacity, proxyCount);
+	m_contacts = b2ReserveArray(m_contacts, &m_contactCapacity, contactCount);
+}
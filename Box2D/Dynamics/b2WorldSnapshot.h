@@ -0,0 +1,134 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WORLD_SNAPSHOT_H
+#define B2_WORLD_SNAPSHOT_H
+
+#include "Box2D/Common/b2Math.h"
+#include "Box2D/Collision/b2BroadPhase.h"
+#include "Box2D/Collision/b2Collision.h"
+#include "Box2D/Collision/b2Distance.h"
+#include "Box2D/Dynamics/b2Body.h"
+
+class b2Fixture;
+struct b2FixtureProxy;
+
+/// The simulation state of a world captured by b2World::Snapshot. This holds
+/// the body motion, the fixture proxies, the contacts including their warm
+/// starting impulses and the broad-phase. Restoring a snapshot brings the world
+/// back to exactly the captured state, so repeated rollouts from a common
+/// checkpoint do not need to rebuild the world.
+/// The snapshot refers to the bodies and fixtures of the world it was taken
+/// from. It can only be restored while the same bodies and fixtures exist.
+/// Shapes, materials and joints are not captured.
+class b2WorldSnapshot
+{
+public:
+	b2WorldSnapshot();
+	~b2WorldSnapshot();
+
+	/// Forget the captured state.
+	void Clear();
+
+	/// Has a state been captured.
+	bool IsEmpty() const;
+
+private:
+
+	friend class b2World;
+
+	struct b2BodyState
+	{
+		b2Body* body;
+		b2BodyType type;
+		uint16 flags;
+		int32 fixtureCount;
+		b2Transform xf;
+		b2Sweep sweep;
+		b2Vec2 linearVelocity;
+		float32 angularVelocity;
+		b2Vec2 force;
+		float32 torque;
+		float32 mass, invMass;
+		float32 I, invI;
+		float32 sleepTime;
+	};
+
+	struct b2FixtureState
+	{
+		b2Fixture* fixture;
+		b2FixtureProxy* proxies;
+		int32 proxyCount;
+	};
+
+	struct b2ProxyState
+	{
+		b2AABB aabb;
+		int32 proxyId;
+	};
+
+	struct b2ContactState
+	{
+		b2Fixture* fixtureA;
+		b2Fixture* fixtureB;
+		int32 indexA;
+		int32 indexB;
+		uint32 flags;
+		b2Manifold manifold;
+		b2Transform manifoldXf;
+		b2SimplexCache toiCache;
+		int32 toiCount;
+		float32 toi;
+		float32 friction;
+		float32 restitution;
+		float32 tangentSpeed;
+	};
+
+	void Reserve(int32 bodyCount, int32 fixtureCount, int32 proxyCount, int32 contactCount);
+
+	b2BodyState* m_bodies;
+	int32 m_bodyCount;
+	int32 m_bodyCapacity;
+
+	b2FixtureState* m_fixtures;
+	int32 m_fixtureCount;
+	int32 m_fixtureCapacity;
+
+	b2ProxyState* m_proxies;
+	int32 m_proxyCount;
+	int32 m_proxyCapacity;
+
+	b2ContactState* m_contacts;
+	int32 m_contactCount;
+	int32 m_contactCapacity;
+
+	b2BroadPhase m_broadPhase;
+
+	b2Vec2 m_gravity;
+	int32 m_flags;
+	float32 m_inv_dt0;
+	bool m_stepComplete;
+	bool m_empty;
+};
+
+inline bool b2WorldSnapshot::IsEmpty() const
+{
+	return m_empty;
+}
+
+#endif
@@ -0,0 +1,246 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "BallRun.h"
+#include "BallRunMonitor.h"
+#include "BallRunRecorder.h"
+#include "Simulation.h"
+
+#include <cmath>
+
+bool BallRunDef::Load(const float *params, int32 paramCount)
+{
+	if (BallRunIsValidParamCount(paramCount) == false)
+	{
+		return false;
+	}
+
+	gravity = params[0];
+	friction = params[1];
+	restitution = params[2];
+
+	obstacles.clear();
+	for (int32 i = k_sceneParamCount; i < paramCount; i += k_obstacleParamCount)
+	{
+		const float *p = params + i;
+		BallRunObstacle obstacle;
+		obstacle.position.Set(p[0], p[1]);
+		obstacle.angle = p[2];
+		obstacle.size.Set(p[3], p[4]);
+		obstacle.dynamic = p[5] != 0.0f;
+		obstacles.push_back(obstacle);
+	}
+
+	return true;
+}
+
+b2Body *BallRunCreateBullet(b2World *world)
+{
+	b2PolygonShape shape;
+	const float32 rad = 0.25f;
+	const int32 n = 8;
+	b2Vec2 points[n];
+	for (int32 i = 0; i < n; i++)
+	{
+		points[i].x = rad * std::sin(2.0 * M_PI * (float(i) / n));
+		points[i].y = rad * std::cos(2.0 * M_PI * (float(i) / n));
+	}
+	shape.Set(points, n);
+
+	b2BodyDef bd;
+	bd.type = b2_dynamicBody;
+	bd.position.Set(0.20352793f, 10.0f);
+	bd.bullet = true;
+
+	b2FixtureDef fd;
+	fd.shape = &shape;
+	fd.friction = 1.0f;
+	fd.restitution = 0.0f;
+	fd.density = 1.0f;
+
+	b2Body *bullet = world->CreateBody(&bd);
+	bullet->CreateFixture(&fd);
+	return bullet;
+}
+
+bool BallRunSameLayout(const BallRunDef &a, const BallRunDef &b)
+{
+	if (a.obstacles.size() != b.obstacles.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < a.obstacles.size(); ++i)
+	{
+		const BallRunObstacle &oa = a.obstacles[i];
+		const BallRunObstacle &ob = b.obstacles[i];
+		if (oa.size.x != ob.size.x || oa.size.y != ob.size.y || oa.dynamic != ob.dynamic)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void BallRunCreateObstacles(b2World *world, const BallRunDef &def, std::vector<b2Body *> *obstacles)
+{
+	int32 count = int32(def.obstacles.size());
+	obstacles->resize(count);
+
+	b2PolygonShape box;
+	for (int32 i = 0; i < count; i++)
+	{
+		const BallRunObstacle &obstacle = def.obstacles[i];
+
+		b2BodyDef bd;
+		bd.type = obstacle.dynamic ? b2_dynamicBody : b2_staticBody;
+
+		box.SetAsBox(obstacle.size.x, obstacle.size.y);
+
+		b2FixtureDef fd;
+		fd.shape = &box;
+		fd.friction = def.friction;
+		fd.restitution = def.restitution;
+		fd.density = 1.0f;
+
+		b2Body *body = world->CreateBody(&bd);
+		body->CreateFixture(&fd);
+		(*obstacles)[i] = body;
+	}
+}
+
+void BallRunPlace(b2World *world, b2Body *bullet, const BallRunDef &def, const std::vector<b2Body *> &obstacles)
+{
+	world->SetGravity(b2Vec2(0.0f, def.gravity));
+
+	int32 count = int32(def.obstacles.size());
+	for (int32 i = 0; i < count; i++)
+	{
+		const BallRunObstacle &obstacle = def.obstacles[i];
+		b2Body *body = obstacles[i];
+
+		b2Fixture *fixture = body->GetFixtureList();
+		fixture->SetFriction(def.friction);
+		fixture->SetRestitution(def.restitution);
+		body->SetTransform(obstacle.position, obstacle.angle);
+	}
+
+	bullet->SetTransform(b2Vec2(-30.0f, 40.0f), 0.0f);
+	bullet->SetLinearVelocity(b2Vec2(3.0f, -1.0f));
+	bullet->SetAngularVelocity(0.0f);
+}
+
+void BallRunSetup(b2World *world, b2Body *bullet, const BallRunDef &def, std::vector<b2Body *> *obstacles)
+{
+	BallRunCreateObstacles(world, def, obstacles);
+	BallRunPlace(world, bullet, def, *obstacles);
+}
+
+bool BallRunInBounds(const b2Vec2 &p)
+{
+	const float32 xMin = -40.0f;
+	const float32 xMax = 40.0f;
+	const float32 yMin = 0.26f;
+	const float32 yMax = 50.0f;
+	return p.x > xMin && p.x < xMax && p.y > yMin && p.y < yMax;
+}
+
+BallRun::BallRun()
+{
+	m_world = NULL;
+	m_bullet = NULL;
+}
+
+BallRun::BallRun(const BallRunDef &def)
+{
+	m_world = NULL;
+	m_bullet = NULL;
+	Reset(def);
+}
+
+void BallRun::Reset(const BallRunDef &def)
+{
+	if (m_world != NULL && BallRunSameLayout(def, m_layout) && m_world->Restore(m_snapshot))
+	{
+		BallRunPlace(m_world, m_bullet, def, m_obstacles);
+		return;
+	}
+
+	delete m_world;
+	m_world = new b2World(b2Vec2(0.0f, def.gravity));
+	m_bullet = BallRunCreateBullet(m_world);
+	BallRunCreateObstacles(m_world, def, &m_obstacles);
+	m_world->Snapshot(&m_snapshot);
+	m_layout = def;
+	BallRunPlace(m_world, m_bullet, def, m_obstacles);
+}
+
+BallRun::~BallRun()
+{
+	delete m_world;
+}
+
+void BallRun::Step()
+{
+	m_world->Step(1.0f / 60.0f, 8, 3);
+}
+
+int32 BallRun::Run(float *output, int32 maxSteps)
+{
+	BallRunRecorder recorder;
+	recorder.Set(BALL_RUN_CHANNEL_POSITION, 1, 2, maxSteps);
+	recorder.SetOutput(output);
+	BallRunMonitor *monitor = &recorder;
+	Run(maxSteps, &monitor, 1);
+	return 2 * recorder.GetSampleCount();
+}
+
+int32 BallRun::Run(int32 maxSteps, BallRunMonitor *const *monitors, int32 monitorCount)
+{
+	for (int32 i = 0; i < monitorCount; ++i)
+	{
+		monitors[i]->Begin(m_bullet);
+	}
+
+	int32 step = 0;
+	while (step < maxSteps)
+	{
+		Step();
+
+		bool proceed = BallRunInBounds(m_bullet->GetPosition());
+		for (int32 i = 0; i < monitorCount; ++i)
+		{
+			proceed = monitors[i]->Step(step, m_bullet) && proceed;
+		}
+
+		++step;
+
+		if (proceed == false)
+		{
+			break;
+		}
+	}
+
+	for (int32 i = 0; i < monitorCount; ++i)
+	{
+		monitors[i]->End(step, m_bullet);
+	}
+
+	return step;
+}
@@ -0,0 +1,133 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BALL_RUN_H
+#define BALL_RUN_H
+
+#include "Box2D/Box2D.h"
+
+#include <vector>
+
+class BallRunMonitor;
+
+/// Number of leading scene parameters (gravity, friction, restitution).
+const int32 k_sceneParamCount = 3;
+
+/// Number of parameters per obstacle (x, y, rotation, width, height, gravity).
+const int32 k_obstacleParamCount = 6;
+
+/// Does a flat parameter vector of this size match the ball run layout.
+inline bool BallRunIsValidParamCount(int32 paramCount)
+{
+	return paramCount >= k_sceneParamCount && (paramCount - k_sceneParamCount) % k_obstacleParamCount == 0;
+}
+
+/// A box obstacle placed in the ball run.
+struct BallRunObstacle
+{
+	b2Vec2 position;
+	float32 angle;
+	b2Vec2 size;
+	bool dynamic;
+};
+
+/// Ball run scene parameters. This is the scene behind the Bullet Test and
+/// has no dependency on the GUI so it can be used for headless evaluation.
+struct BallRunDef
+{
+	BallRunDef()
+	{
+		gravity = -100.0f;
+		friction = 0.2f;
+		restitution = 0.75f;
+	}
+
+	/// Load the flat parameter layout used by optimize.py: gravity, friction and
+	/// restitution followed by k_obstacleParamCount values per obstacle.
+	/// @return false if paramCount does not match the layout.
+	bool Load(const float *params, int32 paramCount);
+
+	float32 gravity;
+	float32 friction;
+	float32 restitution;
+	std::vector<BallRunObstacle> obstacles;
+};
+
+/// Create the ball. It is an octagon rather than a circle so that it gets
+/// rolling friction.
+b2Body *BallRunCreateBullet(b2World *world);
+
+/// Do two scenes create the same bodies and shapes. Scenes with the same layout
+/// only differ in the values applied by BallRunPlace.
+bool BallRunSameLayout(const BallRunDef &a, const BallRunDef &b);
+
+/// Create the obstacle bodies and shapes at the origin.
+void BallRunCreateObstacles(b2World *world, const BallRunDef &def, std::vector<b2Body *> *obstacles);
+
+/// Apply gravity and materials, move the obstacles into place and launch the ball.
+void BallRunPlace(b2World *world, b2Body *bullet, const BallRunDef &def, const std::vector<b2Body *> &obstacles);
+
+/// Create the obstacles in the world and launch the ball.
+void BallRunSetup(b2World *world, b2Body *bullet, const BallRunDef &def, std::vector<b2Body *> *obstacles);
+
+/// The ball run ends once the ball leaves this region.
+bool BallRunInBounds(const b2Vec2 &p);
+
+/// A ball run simulation that owns its world. Steps at 60Hz with the
+/// testbed default solver iterations.
+/// The world is kept between scenes. When the next scene has the same layout
+/// the world is restored from a snapshot taken right after the obstacles were
+/// created instead of being rebuilt, which gives the same result.
+class BallRun
+{
+  public:
+	BallRun();
+	BallRun(const BallRunDef &def);
+	~BallRun();
+
+	/// Prepare the world for a new scene.
+	void Reset(const BallRunDef &def);
+
+	/// Advance the simulation by one time step.
+	void Step();
+
+	/// Step until the ball leaves the bounds or maxSteps is reached. The ball
+	/// positions are written to output as x,y pairs.
+	/// @return the number of floats written.
+	int32 Run(float *output, int32 maxSteps);
+
+	/// Step until the ball leaves the bounds, a monitor ends the run or
+	/// maxSteps is reached. Every monitor sees every step.
+	/// @return the number of steps taken.
+	int32 Run(int32 maxSteps, BallRunMonitor *const *monitors, int32 monitorCount);
+
+	b2World *GetWorld() { return m_world; }
+	b2Body *GetBullet() { return m_bullet; }
+
+  private:
+	BallRun(const BallRun &);
+	BallRun &operator=(const BallRun &);
+
+	b2World *m_world;
+	b2Body *m_bullet;
+	std::vector<b2Body *> m_obstacles;
+	BallRunDef m_layout;
+	b2WorldSnapshot m_snapshot;
+};
+
+#endif
@@ -0,0 +1,208 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "BallRunMonitor.h"
+#include "Simulation.h"
+
+BallRunRestMonitor::BallRunRestMonitor()
+{
+	m_center.SetZero();
+	m_radius = 0.0f;
+	m_speed = 0.0f;
+	m_stepCount = 0;
+	m_restCount = 0;
+}
+
+void BallRunRestMonitor::Set(const b2Vec2 &center, float32 radius, float32 speed, int32 stepCount)
+{
+	m_center = center;
+	m_radius = radius;
+	m_speed = speed;
+	m_stepCount = stepCount;
+}
+
+void BallRunRestMonitor::Begin(const b2Body *ball)
+{
+	B2_NOT_USED(ball);
+	m_restCount = 0;
+}
+
+bool BallRunRestMonitor::Step(int32 step, const b2Body *ball)
+{
+	B2_NOT_USED(step);
+
+	if (ball->IsAwake() == false)
+	{
+		return false;
+	}
+
+	bool inside = m_radius <= 0.0f || b2DistanceSquared(ball->GetPosition(), m_center) <= m_radius * m_radius;
+	bool slow = ball->GetLinearVelocity().LengthSquared() < m_speed * m_speed;
+	m_restCount = inside && slow ? m_restCount + 1 : 0;
+	return m_restCount < m_stepCount;
+}
+
+BallRunReachMonitor::BallRunReachMonitor()
+{
+	m_height = 0.0f;
+}
+
+bool BallRunReachMonitor::Step(int32 step, const b2Body *ball)
+{
+	B2_NOT_USED(step);
+
+	float32 gravity = -ball->GetWorld()->GetGravity().y;
+	float32 mass = ball->GetMass();
+	if (gravity <= 0.0f || mass == 0.0f)
+	{
+		return true;
+	}
+
+	// Friction can turn spin into climbing, so count the rotational energy too.
+	b2Vec2 v = ball->GetLinearVelocity();
+	float32 w = ball->GetAngularVelocity();
+	float32 centerInertia = ball->GetInertia() - mass * b2Dot(ball->GetLocalCenter(), ball->GetLocalCenter());
+	float32 energy = 0.5f * mass * b2Dot(v, v) + 0.5f * centerInertia * w * w;
+
+	float32 reach = ball->GetWorldCenter().y + energy / (mass * gravity);
+	return reach >= m_height;
+}
+
+BallRunGoalCost::BallRunGoalCost()
+{
+	m_goal.SetZero();
+	m_position.SetZero();
+}
+
+void BallRunGoalCost::Begin(const b2Body *ball)
+{
+	m_position = ball->GetPosition();
+}
+
+bool BallRunGoalCost::Step(int32 step, const b2Body *ball)
+{
+	B2_NOT_USED(step);
+	m_position = ball->GetPosition();
+	return true;
+}
+
+float32 BallRunGoalCost::GetCost() const
+{
+	return b2DistanceSquared(m_position, m_goal);
+}
+
+BallRunTrajectoryCost::BallRunTrajectoryCost()
+{
+	m_reference = NULL;
+	m_count = 0;
+	m_discount = 1.0f;
+	m_weight = 1.0f;
+	m_sum = 0.0f;
+	m_stepCount = 0;
+}
+
+void BallRunTrajectoryCost::Set(const float *reference, int32 count, float32 discount)
+{
+	m_reference = reference;
+	m_count = count;
+	m_discount = discount;
+}
+
+void BallRunTrajectoryCost::Begin(const b2Body *ball)
+{
+	B2_NOT_USED(ball);
+	m_weight = 1.0f;
+	m_sum = 0.0f;
+	m_stepCount = 0;
+}
+
+bool BallRunTrajectoryCost::Step(int32 step, const b2Body *ball)
+{
+	const float *r = m_reference + 2 * b2Min(step, m_count - 1);
+	m_sum += m_weight * b2DistanceSquared(ball->GetPosition(), b2Vec2(r[0], r[1]));
+	m_weight *= m_discount;
+	++m_stepCount;
+	return true;
+}
+
+float32 BallRunTrajectoryCost::GetCost() const
+{
+	return m_stepCount > 0 ? m_sum / m_stepCount : 0.0f;
+}
+
+BallRunScorer::BallRunScorer()
+{
+	m_monitorCount = 0;
+	m_cost = NULL;
+}
+
+bool BallRunScorer::Configure(const BallRunObjective &objective)
+{
+	m_monitorCount = 0;
+	m_cost = NULL;
+
+	b2Vec2 goal(objective.goalX, objective.goalY);
+	if (objective.cost == BALL_RUN_COST_GOAL)
+	{
+		m_goal.Set(goal);
+		m_cost = &m_goal;
+	}
+	else if (objective.cost == BALL_RUN_COST_TRAJECTORY)
+	{
+		if (objective.reference == NULL || objective.referenceCount <= 0)
+		{
+			return false;
+		}
+
+		m_trajectory.Set(objective.reference, objective.referenceCount, objective.discount);
+		m_cost = &m_trajectory;
+	}
+	else
+	{
+		return false;
+	}
+
+	m_monitors[m_monitorCount++] = m_cost;
+
+	if (objective.restSteps > 0)
+	{
+		m_rest.Set(goal, objective.restRadius, objective.restSpeed, objective.restSteps);
+		m_monitors[m_monitorCount++] = &m_rest;
+	}
+
+	if (objective.reachEnabled)
+	{
+		m_reach.Set(objective.reachHeight);
+		m_monitors[m_monitorCount++] = &m_reach;
+	}
+
+	return true;
+}
+
+float32 BallRunScorer::Score(BallRun *run, int32 maxSteps, int32 *stepCount)
+{
+	b2Assert(m_cost != NULL);
+
+	int32 steps = run->Run(maxSteps, m_monitors, m_monitorCount);
+	if (stepCount)
+	{
+		*stepCount = steps;
+	}
+
+	return m_cost->GetCost();
+}
@@ -0,0 +1,174 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BALL_RUN_MONITOR_H
+#define BALL_RUN_MONITOR_H
+
+#include "BallRun.h"
+
+struct BallRunObjective;
+
+/// Observes the ball after every step of a ball run. Monitors can end the run
+/// early and accumulate a cost while the world is stepped, so the caller does
+/// not need the whole trajectory.
+class BallRunMonitor
+{
+  public:
+	virtual ~BallRunMonitor() {}
+
+	/// Called before the first step.
+	virtual void Begin(const b2Body *ball) { B2_NOT_USED(ball); }
+
+	/// Called after each step.
+	/// @return false to end the run after this step.
+	virtual bool Step(int32 step, const b2Body *ball) = 0;
+
+	/// Called after the last step.
+	/// @param stepCount the number of steps taken.
+	virtual void End(int32 stepCount, const b2Body *ball)
+	{
+		B2_NOT_USED(stepCount);
+		B2_NOT_USED(ball);
+	}
+};
+
+/// A monitor that accumulates a cost over the run.
+class BallRunCost : public BallRunMonitor
+{
+  public:
+	/// Get the cost of the steps seen so far.
+	virtual float32 GetCost() const = 0;
+};
+
+/// Ends the run once the ball has rested for a number of consecutive steps,
+/// optionally only inside a circle around a goal. A sleeping ball ends the run
+/// wherever it is, since it cannot move again unless something hits it.
+class BallRunRestMonitor : public BallRunMonitor
+{
+  public:
+	BallRunRestMonitor();
+
+	/// @param center the center of the rest region.
+	/// @param radius the radius of the rest region. Zero accepts any position.
+	/// @param speed the ball is resting below this linear speed.
+	/// @param stepCount the number of consecutive resting steps.
+	void Set(const b2Vec2 &center, float32 radius, float32 speed, int32 stepCount);
+
+	void Begin(const b2Body *ball) override;
+	bool Step(int32 step, const b2Body *ball) override;
+
+  private:
+	b2Vec2 m_center;
+	float32 m_radius;
+	float32 m_speed;
+	int32 m_stepCount;
+	int32 m_restCount;
+};
+
+/// Ends the run once the ball can no longer climb to a given height. The bound
+/// is the height the ball would reach if all of its kinetic energy went into
+/// climbing, which is only valid when no collision adds energy: obstacles must
+/// be static and restitution at most one.
+class BallRunReachMonitor : public BallRunMonitor
+{
+  public:
+	BallRunReachMonitor();
+
+	void Set(float32 height) { m_height = height; }
+
+	bool Step(int32 step, const b2Body *ball) override;
+
+  private:
+	float32 m_height;
+};
+
+/// The squared distance between the ball and a goal where the run ended.
+class BallRunGoalCost : public BallRunCost
+{
+  public:
+	BallRunGoalCost();
+
+	void Set(const b2Vec2 &goal) { m_goal = goal; }
+
+	void Begin(const b2Body *ball) override;
+	bool Step(int32 step, const b2Body *ball) override;
+	float32 GetCost() const override;
+
+  private:
+	b2Vec2 m_goal;
+	b2Vec2 m_position;
+};
+
+/// The discounted mean squared error between the ball and a reference
+/// trajectory sampled at every step. Steps past the end of the reference are
+/// compared with its last point.
+class BallRunTrajectoryCost : public BallRunCost
+{
+  public:
+	BallRunTrajectoryCost();
+
+	/// @param reference x,y pairs, one per step. Not copied.
+	/// @param count the number of pairs.
+	/// @param discount the weight of step i is discount^i.
+	void Set(const float *reference, int32 count, float32 discount);
+
+	void Begin(const b2Body *ball) override;
+	bool Step(int32 step, const b2Body *ball) override;
+	float32 GetCost() const override;
+
+  private:
+	const float *m_reference;
+	int32 m_count;
+	float32 m_discount;
+	float32 m_weight;
+	float32 m_sum;
+	int32 m_stepCount;
+};
+
+/// Builds the monitors described by a BallRunObjective and evaluates ball runs
+/// with them.
+class BallRunScorer
+{
+  public:
+	BallRunScorer();
+
+	/// @return false if the objective is invalid.
+	bool Configure(const BallRunObjective &objective);
+
+	/// Step the run with the configured monitors.
+	/// @param stepCount receives the number of steps taken, may be NULL.
+	/// @return the cost.
+	float32 Score(BallRun *run, int32 maxSteps, int32 *stepCount);
+
+  private:
+	enum
+	{
+		e_maxMonitors = 3
+	};
+
+	BallRunRestMonitor m_rest;
+	BallRunReachMonitor m_reach;
+	BallRunGoalCost m_goal;
+	BallRunTrajectoryCost m_trajectory;
+
+	BallRunMonitor *m_monitors[e_maxMonitors];
+	int32 m_monitorCount;
+	BallRunCost *m_cost;
+};
+
+#endif
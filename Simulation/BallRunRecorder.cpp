@@ -0,0 +1,161 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "BallRunRecorder.h"
+#include "Simulation.h"
+
+BallRunRecorder::BallRunRecorder()
+{
+	m_output = NULL;
+	m_channels = 0;
+	m_interval = 1;
+	m_sampleStride = 0;
+	m_capacity = 0;
+	m_sampleCount = 0;
+	m_lastStep = -1;
+}
+
+bool BallRunRecorder::Set(int32 channels, int32 interval, int32 sampleStride, int32 capacity)
+{
+	if ((channels & ~BALL_RUN_CHANNEL_ALL) != 0 || interval <= 0 || capacity < 0)
+	{
+		return false;
+	}
+
+	if (sampleStride < GetWidth(channels))
+	{
+		return false;
+	}
+
+	m_channels = channels;
+	m_interval = interval;
+	m_sampleStride = sampleStride;
+	m_capacity = capacity;
+	return true;
+}
+
+bool BallRunRecorder::Set(const BallRunRecording &recording)
+{
+	if (recording.output == NULL || Set(recording.channels, recording.interval, recording.sampleStride, recording.sampleCapacity) == false)
+	{
+		return false;
+	}
+
+	return recording.sceneStride >= recording.sampleCapacity * recording.sampleStride;
+}
+
+int32 BallRunRecorder::GetWidth(int32 channels)
+{
+	int32 width = 0;
+	width += (channels & BALL_RUN_CHANNEL_STEP) ? 1 : 0;
+	width += (channels & BALL_RUN_CHANNEL_POSITION) ? 2 : 0;
+	width += (channels & BALL_RUN_CHANNEL_VELOCITY) ? 2 : 0;
+	width += (channels & BALL_RUN_CHANNEL_ANGLE) ? 1 : 0;
+	width += (channels & BALL_RUN_CHANNEL_ANGULAR_VELOCITY) ? 1 : 0;
+	width += (channels & BALL_RUN_CHANNEL_CONTACTS) ? 1 : 0;
+	return width;
+}
+
+int32 BallRunRecorder::GetCapacity(int32 maxSteps, int32 interval)
+{
+	if (maxSteps <= 0 || interval <= 0)
+	{
+		return 0;
+	}
+
+	// The samples on the interval plus the last step.
+	int32 count = (maxSteps - 1) / interval + 1;
+	return (maxSteps - 1) % interval == 0 ? count : count + 1;
+}
+
+void BallRunRecorder::Begin(const b2Body *ball)
+{
+	B2_NOT_USED(ball);
+	m_sampleCount = 0;
+	m_lastStep = -1;
+}
+
+bool BallRunRecorder::Step(int32 step, const b2Body *ball)
+{
+	if (step % m_interval == 0)
+	{
+		Record(step, ball);
+	}
+
+	return true;
+}
+
+void BallRunRecorder::End(int32 stepCount, const b2Body *ball)
+{
+	if (stepCount > 0 && m_lastStep != stepCount - 1)
+	{
+		Record(stepCount - 1, ball);
+	}
+}
+
+void BallRunRecorder::Record(int32 step, const b2Body *ball)
+{
+	if (m_sampleCount == m_capacity)
+	{
+		return;
+	}
+
+	float *out = m_output + m_sampleCount * m_sampleStride;
+
+	if (m_channels & BALL_RUN_CHANNEL_STEP)
+	{
+		*out++ = float(step);
+	}
+
+	if (m_channels & BALL_RUN_CHANNEL_POSITION)
+	{
+		const b2Vec2 &p = ball->GetPosition();
+		*out++ = p.x;
+		*out++ = p.y;
+	}
+
+	if (m_channels & BALL_RUN_CHANNEL_VELOCITY)
+	{
+		const b2Vec2 &v = ball->GetLinearVelocity();
+		*out++ = v.x;
+		*out++ = v.y;
+	}
+
+	if (m_channels & BALL_RUN_CHANNEL_ANGLE)
+	{
+		*out++ = ball->GetAngle();
+	}
+
+	if (m_channels & BALL_RUN_CHANNEL_ANGULAR_VELOCITY)
+	{
+		*out++ = ball->GetAngularVelocity();
+	}
+
+	if (m_channels & BALL_RUN_CHANNEL_CONTACTS)
+	{
+		int32 touching = 0;
+		for (const b2ContactEdge *ce = ball->GetContactList(); ce; ce = ce->next)
+		{
+			touching += ce->contact->IsTouching() ? 1 : 0;
+		}
+		*out++ = float(touching);
+	}
+
+	++m_sampleCount;
+	m_lastStep = step;
+}
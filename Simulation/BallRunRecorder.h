@@ -0,0 +1,74 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BALL_RUN_RECORDER_H
+#define BALL_RUN_RECORDER_H
+
+#include "BallRunMonitor.h"
+
+struct BallRunRecording;
+
+/// Records the ball state into a caller owned buffer while the run is stepped.
+/// Each sample is a row of the selected BALL_RUN_CHANNEL values in channel
+/// order, and rows are sampleStride floats apart. The buffer is never resized:
+/// samples beyond the capacity are dropped.
+class BallRunRecorder : public BallRunMonitor
+{
+  public:
+	BallRunRecorder();
+
+	/// @param channels a combination of BALL_RUN_CHANNEL flags.
+	/// @param interval record every interval steps. The last step is always recorded.
+	/// @param sampleStride the distance between samples in floats.
+	/// @param capacity the maximum number of samples.
+	/// @return false if the layout is invalid.
+	bool Set(int32 channels, int32 interval, int32 sampleStride, int32 capacity);
+
+	/// Set the layout from a recording of a batch.
+	/// @return false if the recording is invalid or its scenes overlap.
+	bool Set(const BallRunRecording &recording);
+
+	/// Set the buffer of the next run. It must hold capacity samples.
+	void SetOutput(float *output) { m_output = output; }
+
+	/// Get the number of samples recorded by the last run.
+	int32 GetSampleCount() const { return m_sampleCount; }
+
+	/// Get the number of floats in a sample.
+	static int32 GetWidth(int32 channels);
+
+	/// Get the number of samples needed for a run of maxSteps.
+	static int32 GetCapacity(int32 maxSteps, int32 interval);
+
+	void Begin(const b2Body *ball) override;
+	bool Step(int32 step, const b2Body *ball) override;
+	void End(int32 stepCount, const b2Body *ball) override;
+
+  private:
+	void Record(int32 step, const b2Body *ball);
+
+	float *m_output;
+	int32 m_channels;
+	int32 m_interval;
+	int32 m_sampleStride;
+	int32 m_capacity;
+	int32 m_sampleCount;
+	int32 m_lastStep;
+};
+
+#endif
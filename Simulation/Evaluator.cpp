@@ -0,0 +1,207 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Evaluator.h"
+#include "Simulation.h"
+
+namespace
+{
+class RunTask : public b2ParallelTask
+{
+  public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		BallRunDef &def = (*m_defs)[threadIndex];
+		BallRun &run = (*m_runs)[threadIndex];
+		const int32 stride = 1 + 2 * m_maxSteps;
+		for (int32 i = begin; i < end; ++i)
+		{
+			def.Load(m_params + i * m_paramCount, m_paramCount);
+
+			float *row = m_output + i * stride;
+			run.Reset(def);
+			row[0] = float(run.Run(row + 1, m_maxSteps));
+		}
+	}
+
+	std::vector<BallRunDef> *m_defs;
+	std::vector<BallRun> *m_runs;
+	const float *m_params;
+	int32 m_paramCount;
+	float *m_output;
+	int32 m_maxSteps;
+};
+
+class RecordTask : public b2ParallelTask
+{
+  public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		BallRunDef &def = (*m_defs)[threadIndex];
+		BallRun &run = (*m_runs)[threadIndex];
+		BallRunRecorder &recorder = (*m_recorders)[threadIndex];
+		BallRunMonitor *monitor = &recorder;
+		for (int32 i = begin; i < end; ++i)
+		{
+			def.Load(m_params + i * m_paramCount, m_paramCount);
+
+			recorder.SetOutput(m_recording->output + i * m_recording->sceneStride);
+			run.Reset(def);
+			run.Run(m_maxSteps, &monitor, 1);
+
+			if (m_recording->sampleCounts)
+			{
+				m_recording->sampleCounts[i] = recorder.GetSampleCount();
+			}
+		}
+	}
+
+	std::vector<BallRunDef> *m_defs;
+	std::vector<BallRun> *m_runs;
+	std::vector<BallRunRecorder> *m_recorders;
+	const float *m_params;
+	int32 m_paramCount;
+	const BallRunRecording *m_recording;
+	int32 m_maxSteps;
+};
+
+class CostTask : public b2ParallelTask
+{
+  public:
+	void Execute(int32 begin, int32 end, int32 threadIndex) override
+	{
+		BallRunDef &def = (*m_defs)[threadIndex];
+		BallRun &run = (*m_runs)[threadIndex];
+		BallRunScorer &scorer = (*m_scorers)[threadIndex];
+		for (int32 i = begin; i < end; ++i)
+		{
+			def.Load(m_params + i * m_paramCount, m_paramCount);
+
+			run.Reset(def);
+			m_costs[i] = scorer.Score(&run, m_maxSteps, m_stepCounts ? m_stepCounts + i : NULL);
+		}
+	}
+
+	std::vector<BallRunDef> *m_defs;
+	std::vector<BallRun> *m_runs;
+	std::vector<BallRunScorer> *m_scorers;
+	const float *m_params;
+	int32 m_paramCount;
+	float *m_costs;
+	int32 *m_stepCounts;
+	int32 m_maxSteps;
+};
+}
+
+Evaluator::Evaluator(int32 threadCount)
+	: m_pool(threadCount), m_runs(m_pool.GetThreadCount())
+{
+	m_defs.resize(m_pool.GetThreadCount());
+	m_scorers.resize(m_pool.GetThreadCount());
+	m_recorders.resize(m_pool.GetThreadCount());
+}
+
+bool Evaluator::Run(const float *params, int32 count, int32 paramCount, float *output, int32 maxSteps)
+{
+	if (params == NULL || output == NULL || count < 0 || maxSteps <= 0)
+	{
+		return false;
+	}
+
+	if (BallRunIsValidParamCount(paramCount) == false)
+	{
+		return false;
+	}
+
+	RunTask task;
+	task.m_defs = &m_defs;
+	task.m_runs = &m_runs;
+	task.m_params = params;
+	task.m_paramCount = paramCount;
+	task.m_output = output;
+	task.m_maxSteps = maxSteps;
+	m_pool.ParallelFor(&task, count, 1);
+	return true;
+}
+
+bool Evaluator::RunRecord(const float *params, int32 count, int32 paramCount, const BallRunRecording &recording,
+						  int32 maxSteps)
+{
+	if (params == NULL || count < 0 || maxSteps <= 0)
+	{
+		return false;
+	}
+
+	if (BallRunIsValidParamCount(paramCount) == false)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < m_recorders.size(); ++i)
+	{
+		if (m_recorders[i].Set(recording) == false)
+		{
+			return false;
+		}
+	}
+
+	RecordTask task;
+	task.m_defs = &m_defs;
+	task.m_runs = &m_runs;
+	task.m_recorders = &m_recorders;
+	task.m_params = params;
+	task.m_paramCount = paramCount;
+	task.m_recording = &recording;
+	task.m_maxSteps = maxSteps;
+	m_pool.ParallelFor(&task, count, 1);
+	return true;
+}
+
+bool Evaluator::RunCost(const float *params, int32 count, int32 paramCount, const BallRunObjective &objective,
+						float *costs, int32 *stepCounts, int32 maxSteps)
+{
+	if (params == NULL || costs == NULL || count < 0 || maxSteps <= 0)
+	{
+		return false;
+	}
+
+	if (BallRunIsValidParamCount(paramCount) == false)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < m_scorers.size(); ++i)
+	{
+		if (m_scorers[i].Configure(objective) == false)
+		{
+			return false;
+		}
+	}
+
+	CostTask task;
+	task.m_defs = &m_defs;
+	task.m_runs = &m_runs;
+	task.m_scorers = &m_scorers;
+	task.m_params = params;
+	task.m_paramCount = paramCount;
+	task.m_costs = costs;
+	task.m_stepCounts = stepCounts;
+	task.m_maxSteps = maxSteps;
+	m_pool.ParallelFor(&task, count, 1);
+	return true;
+}
@@ -0,0 +1,64 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include "BallRun.h"
+#include "BallRunMonitor.h"
+#include "BallRunRecorder.h"
+
+/// Evaluates batches of ball run scenes on a persistent pool of threads. Each
+/// thread simulates its scenes in its own world, so the result of a scene
+/// does not depend on the thread count. The worlds are kept between batches
+/// and restored from a snapshot while the scene layout stays the same.
+class Evaluator
+{
+  public:
+	/// @param threadCount the number of threads including the calling thread.
+	/// Zero uses the hardware concurrency.
+	Evaluator(int32 threadCount);
+
+	int32 GetThreadCount() const { return m_pool.GetThreadCount(); }
+
+	/// Run a batch of scenes. The layout of params and output is the same as
+	/// for my_func_batch.
+	/// @return false if the arguments are invalid.
+	bool Run(const float *params, int32 count, int32 paramCount, float *output, int32 maxSteps);
+
+	/// Run a batch of scenes and record them. The arguments are the same as
+	/// for my_func_batch_record.
+	/// @return false if the arguments are invalid.
+	bool RunRecord(const float *params, int32 count, int32 paramCount, const BallRunRecording &recording,
+				   int32 maxSteps);
+
+	/// Evaluate the cost of a batch of scenes. The arguments are the same as
+	/// for my_func_batch_cost.
+	/// @return false if the arguments are invalid.
+	bool RunCost(const float *params, int32 count, int32 paramCount, const BallRunObjective &objective,
+				 float *costs, int32 *stepCounts, int32 maxSteps);
+
+  private:
+	b2ThreadPool m_pool;
+	std::vector<BallRun> m_runs;
+	std::vector<BallRunDef> m_defs;
+	std::vector<BallRunScorer> m_scorers;
+	std::vector<BallRunRecorder> m_recorders;
+};
+
+#endif
@@ -0,0 +1,233 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "Simulation.h"
+#include "BallRun.h"
+#include "BallRunMonitor.h"
+#include "BallRunRecorder.h"
+#include "Evaluator.h"
+#include "SimulationContext.h"
+
+#include <string.h>
+
+int my_func_batch(const float *params, int count, int paramCount, float *output, int maxSteps)
+{
+	if (params == NULL || output == NULL || count < 0 || maxSteps <= 0)
+	{
+		return -1;
+	}
+
+	BallRunDef def;
+	BallRun run;
+	const int32 stride = 1 + 2 * maxSteps;
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (def.Load(params + i * paramCount, paramCount) == false)
+		{
+			return -1;
+		}
+
+		float *row = output + i * stride;
+		run.Reset(def);
+		row[0] = float(run.Run(row + 1, maxSteps));
+	}
+
+	return 0;
+}
+
+int ball_run_sample_width(int channels)
+{
+	return BallRunRecorder::GetWidth(channels);
+}
+
+int ball_run_sample_capacity(int maxSteps, int interval)
+{
+	return BallRunRecorder::GetCapacity(maxSteps, interval);
+}
+
+int my_func_batch_record(const float *params, int count, int paramCount, const BallRunRecording *recording,
+						 int maxSteps)
+{
+	if (params == NULL || recording == NULL || count < 0 || maxSteps <= 0)
+	{
+		return -1;
+	}
+
+	BallRunRecorder recorder;
+	if (recorder.Set(*recording) == false)
+	{
+		return -1;
+	}
+
+	BallRunDef def;
+	BallRun run;
+	BallRunMonitor *monitor = &recorder;
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (def.Load(params + i * paramCount, paramCount) == false)
+		{
+			return -1;
+		}
+
+		recorder.SetOutput(recording->output + i * recording->sceneStride);
+		run.Reset(def);
+		run.Run(maxSteps, &monitor, 1);
+
+		if (recording->sampleCounts)
+		{
+			recording->sampleCounts[i] = recorder.GetSampleCount();
+		}
+	}
+
+	return 0;
+}
+
+int my_func_batch_cost(const float *params, int count, int paramCount, const BallRunObjective *objective,
+					   float *costs, int *stepCounts, int maxSteps)
+{
+	if (params == NULL || objective == NULL || costs == NULL || count < 0 || maxSteps <= 0)
+	{
+		return -1;
+	}
+
+	BallRunScorer scorer;
+	if (scorer.Configure(*objective) == false)
+	{
+		return -1;
+	}
+
+	BallRunDef def;
+	BallRun run;
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (def.Load(params + i * paramCount, paramCount) == false)
+		{
+			return -1;
+		}
+
+		run.Reset(def);
+		costs[i] = scorer.Score(&run, maxSteps, stepCounts ? stepCounts + i : NULL);
+	}
+
+	return 0;
+}
+
+SimulationContext *context_create(void)
+{
+	return new SimulationContext;
+}
+
+void context_destroy(SimulationContext *context)
+{
+	delete context;
+}
+
+int context_configure(SimulationContext *context, const float *params, int paramCount, int maxSteps)
+{
+	if (context == NULL)
+	{
+		return -1;
+	}
+
+	return context->Configure(params, paramCount, maxSteps) ? 0 : -1;
+}
+
+int context_run(SimulationContext *context)
+{
+	if (context == NULL)
+	{
+		return -1;
+	}
+
+	return context->Run();
+}
+
+const float *context_get_trajectory(const SimulationContext *context, int *count)
+{
+	if (count)
+	{
+		*count = context ? context->GetTrajectoryCount() : 0;
+	}
+
+	return context ? context->GetTrajectory() : NULL;
+}
+
+int context_read_trajectory(const SimulationContext *context, float *output, int capacity)
+{
+	if (context == NULL || output == NULL || capacity <= 0)
+	{
+		return 0;
+	}
+
+	int count = b2Min(context->GetTrajectoryCount(), capacity);
+	memcpy(output, context->GetTrajectory(), count * sizeof(float));
+	return count;
+}
+
+Evaluator *evaluator_create(int threadCount)
+{
+	return new Evaluator(threadCount);
+}
+
+void evaluator_destroy(Evaluator *evaluator)
+{
+	delete evaluator;
+}
+
+int evaluator_get_thread_count(const Evaluator *evaluator)
+{
+	if (evaluator == NULL)
+	{
+		return 0;
+	}
+
+	return evaluator->GetThreadCount();
+}
+
+int evaluator_run(Evaluator *evaluator, const float *params, int count, int paramCount, float *output, int maxSteps)
+{
+	if (evaluator == NULL)
+	{
+		return -1;
+	}
+
+	return evaluator->Run(params, count, paramCount, output, maxSteps) ? 0 : -1;
+}
+
+int evaluator_run_record(Evaluator *evaluator, const float *params, int count, int paramCount,
+						 const BallRunRecording *recording, int maxSteps)
+{
+	if (evaluator == NULL || recording == NULL)
+	{
+		return -1;
+	}
+
+	return evaluator->RunRecord(params, count, paramCount, *recording, maxSteps) ? 0 : -1;
+}
+
+int evaluator_run_cost(Evaluator *evaluator, const float *params, int count, int paramCount,
+					   const BallRunObjective *objective, float *costs, int *stepCounts, int maxSteps)
+{
+	if (evaluator == NULL || objective == NULL)
+	{
+		return -1;
+	}
+
+	return evaluator->RunCost(params, count, paramCount, *objective, costs, stepCounts, maxSteps) ? 0 : -1;
+}
@@ -0,0 +1,204 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+// C interface of the headless ball run library. This is loaded with ctypes
+// by optimize.py and has no dependency on the GUI.
+
+#ifdef __cplusplus
+class Evaluator;
+class SimulationContext;
+extern "C" {
+#else
+typedef struct Evaluator Evaluator;
+typedef struct SimulationContext SimulationContext;
+#endif
+
+/// Cost types of a BallRunObjective.
+enum
+{
+	/// Squared distance between the ball and the goal where the run ended.
+	BALL_RUN_COST_GOAL = 0,
+	/// Discounted mean squared error against a per step reference trajectory.
+	BALL_RUN_COST_TRAJECTORY = 1
+};
+
+/// Describes the cost of a ball run and when it may end early. These are
+/// evaluated while the world is stepped, so no trajectory is recorded.
+typedef struct BallRunObjective
+{
+	/// One of the BALL_RUN_COST values.
+	int cost;
+	float goalX;
+	float goalY;
+
+	/// End the run once the ball is slower than restSpeed for restSteps
+	/// consecutive steps within restRadius of the goal. A sleeping ball ends the
+	/// run right away. Zero restSteps disables this and zero restRadius accepts
+	/// any position.
+	float restRadius;
+	float restSpeed;
+	int restSteps;
+
+	/// If non-zero, end the run once the ball can no longer climb to
+	/// reachHeight. Only valid for scenes with static obstacles and restitution
+	/// at most one.
+	int reachEnabled;
+	float reachHeight;
+
+	/// Reference x,y pairs, one per step, for BALL_RUN_COST_TRAJECTORY. The
+	/// weight of step i is discount^i.
+	const float *reference;
+	int referenceCount;
+	float discount;
+} BallRunObjective;
+
+/// Channels of a BallRunRecording. A sample holds the selected channels in
+/// this order.
+enum
+{
+	/// The step index, one float.
+	BALL_RUN_CHANNEL_STEP = 0x01,
+	/// The ball x,y position.
+	BALL_RUN_CHANNEL_POSITION = 0x02,
+	/// The ball linear velocity.
+	BALL_RUN_CHANNEL_VELOCITY = 0x04,
+	/// The ball angle in radians.
+	BALL_RUN_CHANNEL_ANGLE = 0x08,
+	/// The ball angular velocity.
+	BALL_RUN_CHANNEL_ANGULAR_VELOCITY = 0x10,
+	/// The number of touching contacts on the ball. Contacts begin and end
+	/// where this changes.
+	BALL_RUN_CHANNEL_CONTACTS = 0x20,
+
+	BALL_RUN_CHANNEL_ALL = 0x3f
+};
+
+/// Describes where and what to record during a batch of ball runs. Scene i
+/// writes its samples to output + i * sceneStride, each sample sampleStride
+/// floats after the previous one. The output is never reallocated, so it can
+/// be a NumPy array of shape (count, sampleCapacity, sampleStride).
+typedef struct BallRunRecording
+{
+	/// A combination of BALL_RUN_CHANNEL flags.
+	int channels;
+	/// Record every interval steps. The last step is always recorded.
+	int interval;
+	float *output;
+	/// Distance between scenes in floats.
+	int sceneStride;
+	/// Distance between samples in floats, at least ball_run_sample_width(channels).
+	int sampleStride;
+	/// The number of samples that fit in a scene. Further samples are dropped.
+	int sampleCapacity;
+	/// Receives the number of samples recorded per scene, may be NULL.
+	int *sampleCounts;
+} BallRunRecording;
+
+/// Get the number of floats in a sample of these channels.
+int ball_run_sample_width(int channels);
+
+/// Get the number of samples a run of maxSteps records at this interval.
+int ball_run_sample_capacity(int maxSteps, int interval);
+
+/// Evaluate a batch of ball run scenes.
+/// @param params row-major matrix of count x paramCount scene parameters. Each row
+/// holds gravity, friction and restitution followed by 6 values per obstacle.
+/// @param output caller owned buffer of count x (1 + 2 * maxSteps) floats. Each row
+/// receives the number of recorded floats followed by the ball x,y pairs.
+/// @return 0 on success, -1 if the arguments are invalid.
+int my_func_batch(const float *params, int count, int paramCount, float *output, int maxSteps);
+
+/// Evaluate a batch of ball run scenes and record the selected channels into
+/// the recording output. The layout of params is the same as for my_func_batch.
+/// @return 0 on success, -1 if the arguments are invalid.
+int my_func_batch_record(const float *params, int count, int paramCount, const BallRunRecording *recording,
+						 int maxSteps);
+
+/// Evaluate the cost of a batch of ball run scenes. The layout of params is the
+/// same as for my_func_batch.
+/// @param costs caller owned buffer of count floats.
+/// @param stepCounts caller owned buffer of count ints that receives the number
+/// of steps taken by each scene, may be NULL.
+/// @return 0 on success, -1 if the arguments are invalid.
+int my_func_batch_cost(const float *params, int count, int paramCount, const BallRunObjective *objective,
+					   float *costs, int *stepCounts, int maxSteps);
+
+/// Create a simulation context. Each context owns its scene and results, so
+/// independent contexts can be used from different threads at the same time.
+SimulationContext *context_create(void);
+
+/// Destroy a context and release its results.
+void context_destroy(SimulationContext *context);
+
+/// Set the scene parameters: gravity, friction and restitution followed by
+/// 6 values per obstacle. Clears the previous results.
+/// @return 0 on success, -1 if the arguments are invalid.
+int context_configure(SimulationContext *context, const float *params, int paramCount, int maxSteps);
+
+/// Simulate the configured scene.
+/// @return the number of floats recorded, or -1 if the context is not configured.
+int context_run(SimulationContext *context);
+
+/// Get the ball x,y pairs of the last run. The pointer is owned by the context
+/// and stays valid until the next configure, run or destroy on that context.
+/// @param count receives the number of floats.
+const float *context_get_trajectory(const SimulationContext *context, int *count);
+
+/// Copy the ball x,y pairs of the last run into a caller owned buffer.
+/// @return the number of floats copied.
+int context_read_trajectory(const SimulationContext *context, float *output, int capacity);
+
+/// Create a parallel evaluator. Its worker threads persist until it is destroyed.
+/// @param threadCount the number of threads including the calling thread. Zero
+/// uses the hardware concurrency.
+Evaluator *evaluator_create(int threadCount);
+
+/// Destroy an evaluator and join its threads.
+void evaluator_destroy(Evaluator *evaluator);
+
+/// Get the number of threads including the calling thread.
+/// @return 0 for a null evaluator.
+int evaluator_get_thread_count(const Evaluator *evaluator);
+
+/// Evaluate a batch of ball run scenes in parallel. The layout of params and
+/// output is the same as for my_func_batch and the results do not depend on
+/// the thread count. Only one batch may run on an evaluator at a time.
+/// @return 0 on success, -1 if the arguments are invalid.
+int evaluator_run(Evaluator *evaluator, const float *params, int count, int paramCount, float *output, int maxSteps);
+
+/// Evaluate a batch of ball run scenes in parallel and record them. The
+/// arguments are the same as for my_func_batch_record.
+/// @return 0 on success, -1 if the arguments are invalid.
+int evaluator_run_record(Evaluator *evaluator, const float *params, int count, int paramCount,
+						 const BallRunRecording *recording, int maxSteps);
+
+/// Evaluate the cost of a batch of ball run scenes in parallel. The arguments
+/// are the same as for my_func_batch_cost.
+/// @return 0 on success, -1 if the arguments are invalid.
+int evaluator_run_cost(Evaluator *evaluator, const float *params, int count, int paramCount,
+					   const BallRunObjective *objective, float *costs, int *stepCounts, int maxSteps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,54 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SimulationContext.h"
+
+SimulationContext::SimulationContext()
+{
+	m_configured = false;
+	m_maxSteps = 0;
+	m_trajectoryCount = 0;
+}
+
+bool SimulationContext::Configure(const float *params, int32 paramCount, int32 maxSteps)
+{
+	m_trajectoryCount = 0;
+
+	if (params == NULL || maxSteps <= 0 || m_def.Load(params, paramCount) == false)
+	{
+		m_configured = false;
+		return false;
+	}
+
+	m_maxSteps = maxSteps;
+	m_trajectory.resize(2 * maxSteps);
+	m_configured = true;
+	return true;
+}
+
+int32 SimulationContext::Run()
+{
+	if (m_configured == false)
+	{
+		return -1;
+	}
+
+	m_run.Reset(m_def);
+	m_trajectoryCount = m_run.Run(m_trajectory.data(), m_maxSteps);
+	return m_trajectoryCount;
+}
@@ -0,0 +1,55 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SIMULATION_CONTEXT_H
+#define SIMULATION_CONTEXT_H
+
+#include "BallRun.h"
+
+/// Holds everything needed for one ball run: the scene parameters, the step
+/// limit and the recorded trajectory. Contexts share no state, so independent
+/// contexts can run at the same time on different threads.
+class SimulationContext
+{
+  public:
+	SimulationContext();
+
+	/// Set the scene parameters using the flat layout of BallRunDef::Load.
+	/// This clears the previous results.
+	/// @return false if the arguments are invalid.
+	bool Configure(const float *params, int32 paramCount, int32 maxSteps);
+
+	/// Simulate the configured scene.
+	/// @return the number of floats recorded, or -1 if not configured.
+	int32 Run();
+
+	/// Get the ball positions of the last run as x,y pairs. The pointer is
+	/// valid until the next call to Configure or Run.
+	const float *GetTrajectory() const { return m_trajectory.data(); }
+	int32 GetTrajectoryCount() const { return m_trajectoryCount; }
+
+  private:
+	BallRunDef m_def;
+	BallRun m_run;
+	bool m_configured;
+	int32 m_maxSteps;
+	std::vector<float> m_trajectory;
+	int32 m_trajectoryCount;
+};
+
+#endif
@@ -386,8 +386,15 @@ static void sInterface()
 
 		ImGui::Checkbox("Sleep", &settings.enableSleep);
 		ImGui::Checkbox("Warm Starting", &settings.enableWarmStarting);
+		ImGui::Checkbox("Graph Coloring", &settings.enableGraphColoring);
+		ImGui::Checkbox("Wide Contacts", &settings.enableWideContactSolver);
+		ImGui::Checkbox("Wide Queries", &settings.enableWideTreeQueries);
+		ImGui::Checkbox("Sweep and Prune", &settings.enableSweepAndPrune);
+		ImGui::Checkbox("Static Tree", &settings.enableStaticTree);
+		ImGui::Checkbox("Manifold Cache", &settings.enableManifoldCache);
 		ImGui::Checkbox("Time of Impact", &settings.enableContinuous);
 		ImGui::Checkbox("Sub-Stepping", &settings.enableSubStepping);
+		ImGui::Checkbox("TOI Batching", &settings.enableTOIBatching);
 
 		ImGui::Separator();
 
@@ -428,51 +435,27 @@ void glfwErrorCallback(int error, const char *description)
 	fprintf(stderr, "GLFW error occured. Code: %d. Description: %s\n", error, description);
 }
 
-#define SQR(x) ((x) * (x))
+// Step limit used when running without the GUI.
+const int32 k_maxSteps = 750;
+
 //
 extern "C" float *my_func(int argc, char **argv)
 {
-	settings.bodies.clear();
-	settings.rotations.clear();
-	settings.sizes.clear();
-
 	doGUI = argc > 1 ? std::atoi(argv[1]) : 1;
-	settings.gravity = argc > 2 ? std::atof(argv[2]) : -100;
-	settings.friction = argc > 3 ? std::atof(argv[3]) : 0.2;
-	settings.rest = argc > 4 ? std::atof(argv[4]) : 0.75;
 
-	int skip = 5;
-	for (int i = skip; i < argc; i++)
+	std::vector<float> params;
+	params.push_back(argc > 2 ? std::atof(argv[2]) : -100.0f);
+	params.push_back(argc > 3 ? std::atof(argv[3]) : 0.2f);
+	params.push_back(argc > 4 ? std::atof(argv[4]) : 0.75f);
+	for (int i = 5; i < argc; i++)
 	{
-		auto idx = (i - skip) % 6;
-		if (idx == 0)
-		{
-			settings.bodies.push_back({0.0, 0.0});
-			settings.rotations.push_back({0.0});
-			settings.sizes.push_back({1.0, 0.1});
-			settings.gravity_on.push_back(false);
-			settings.bodies[settings.bodies.size() - 1].x = std::atof(argv[i]);
-		}
-		else if (idx == 1)
-		{
-			settings.bodies[settings.bodies.size() - 1].y = std::atof(argv[i]);
-		}
-		else if (idx == 2)
-		{
-			settings.rotations[settings.bodies.size() - 1] = std::atof(argv[i]);
-		}
-		else if (idx == 3)
-		{
-			settings.sizes[settings.bodies.size() - 1].x = std::atof(argv[i]);
-		}
-		else if (idx == 4)
-		{
-			settings.sizes[settings.bodies.size() - 1].y = std::atof(argv[i]);
-		}
-		else if (idx == 5)
-		{
-			settings.gravity_on[settings.bodies.size() - 1] = std::atoi(argv[i]);
-		}
+		params.push_back(std::atof(argv[i]));
+	}
+
+	if (settings.ballRun.Load(params.data(), int32(params.size())) == false)
+	{
+		fprintf(stderr, "Expected %d values per obstacle.\n", k_obstacleParamCount);
+		return NULL;
 	}
 
 	//doGUI = std::atoi(argv[1]);
@@ -571,16 +554,10 @@ extern "C" float *my_func(int argc, char **argv)
 	auto run_loop = doGUI ? !glfwWindowShouldClose(mainWindow) : true;
 	auto run_sim = true;
 
-	auto xMin = -40.0f;
-	auto xMax = 40.0f;
-	auto yMin = 0.26f;
-	auto yMax = 50.0f;
-	auto vMin = 0.3f;
-
 	positions.clear();
 	positions.push_back(0.0);
 
-	for (int i = 0; run_loop && (i < 750 || doGUI); i++)
+	for (int i = 0; run_loop && (i < k_maxSteps || doGUI); i++)
 	{
 		if (doGUI)
 		{
@@ -635,11 +612,7 @@ extern "C" float *my_func(int argc, char **argv)
 			glfwPollEvents();
 		}
 
-		auto totalV = SQR(settings.v1.x) + SQR(settings.v1.y);
-
-		auto world_bounds = settings.p1.x > xMin && settings.p1.x < xMax && settings.p1.y > yMin && settings.p1.y < yMax;
-
-		run_sim = world_bounds ? true : false;
+		run_sim = BallRunInBounds(settings.p1);
 		run_loop = doGUI ? !glfwWindowShouldClose(mainWindow) : run_sim;
 	}
 	//printf("%f %f\n", settings.p1.x, settings.p1.y);
@@ -663,6 +636,10 @@ extern "C" float *my_func(int argc, char **argv)
 int main(int argc, char **argv)
 {
 	float *rets = my_func(argc, argv);
+	if (rets == NULL)
+	{
+		return 1;
+	}
 	auto size = positions.size();
 	printf("%f %f\n", positions[size - 2], positions[size - 1]);
 	return 0;
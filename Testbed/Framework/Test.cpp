@@ -298,8 +298,15 @@ void Test::Step(Settings *settings)
 
 	m_world->SetAllowSleeping(settings->enableSleep);
 	m_world->SetWarmStarting(settings->enableWarmStarting);
+	m_world->SetGraphColoring(settings->enableGraphColoring);
+	m_world->SetWideContactSolver(settings->enableWideContactSolver);
+	m_world->SetWideTreeQueries(settings->enableWideTreeQueries);
+	m_world->SetSweepAndPrune(settings->enableSweepAndPrune);
+	m_world->SetStaticTree(settings->enableStaticTree);
+	m_world->SetManifoldCacheTolerance(settings->enableManifoldCache ? b2_manifoldCacheTolerance : 0.0f);
 	m_world->SetContinuousPhysics(settings->enableContinuous);
 	m_world->SetSubStepping(settings->enableSubStepping);
+	m_world->SetTOIBatching(settings->enableTOIBatching);
 
 	m_pointCount = 0;
 
@@ -342,6 +349,8 @@ void Test::Step(Settings *settings)
 		m_maxProfile.solvePosition = b2Max(m_maxProfile.solvePosition, p.solvePosition);
 		m_maxProfile.solveTOI = b2Max(m_maxProfile.solveTOI, p.solveTOI);
 		m_maxProfile.broadphase = b2Max(m_maxProfile.broadphase, p.broadphase);
+		m_maxProfile.stackPeak = b2Max(m_maxProfile.stackPeak, p.stackPeak);
+		m_maxProfile.manifoldError = b2Max(m_maxProfile.manifoldError, p.manifoldError);
 
 		m_totalProfile.step += p.step;
 		m_totalProfile.collide += p.collide;
@@ -351,6 +360,14 @@ void Test::Step(Settings *settings)
 		m_totalProfile.solvePosition += p.solvePosition;
 		m_totalProfile.solveTOI += p.solveTOI;
 		m_totalProfile.broadphase += p.broadphase;
+		m_totalProfile.stackOverflows += p.stackOverflows;
+		m_totalProfile.manifoldHits += p.manifoldHits;
+		m_totalProfile.manifoldMisses += p.manifoldMisses;
+		m_totalProfile.toiEvents += p.toiEvents;
+		m_totalProfile.toiRounds += p.toiRounds;
+		m_totalProfile.toiQueries += p.toiQueries;
+		m_totalProfile.toiIters += p.toiIters;
+		m_totalProfile.toiRootIters += p.toiRootIters;
 	}
 
 	if (settings->doGUI && settings->drawProfile)
@@ -388,6 +405,21 @@ void Test::Step(Settings *settings)
 		m_textLine += DRAW_STRING_NEW_LINE;
 		g_debugDraw.DrawString(5, m_textLine, "broad-phase [ave] (max) = %5.2f [%6.2f] (%6.2f)", p.broadphase, aveProfile.broadphase, m_maxProfile.broadphase);
 		m_textLine += DRAW_STRING_NEW_LINE;
+		g_debugDraw.DrawString(5, m_textLine, "stack peak (max) = %d KB (%d KB)", p.stackPeak / 1024, m_maxProfile.stackPeak / 1024);
+		m_textLine += DRAW_STRING_NEW_LINE;
+		g_debugDraw.DrawString(5, m_textLine, "stack overflows [total] = %d [%d]", p.stackOverflows, m_totalProfile.stackOverflows);
+		m_textLine += DRAW_STRING_NEW_LINE;
+		g_debugDraw.DrawString(5, m_textLine, "manifold hits/misses [total] = %d/%d [%d/%d]", p.manifoldHits, p.manifoldMisses,
+							   m_totalProfile.manifoldHits, m_totalProfile.manifoldMisses);
+		m_textLine += DRAW_STRING_NEW_LINE;
+		g_debugDraw.DrawString(5, m_textLine, "manifold error (max) = %.6f (%.6f)", p.manifoldError, m_maxProfile.manifoldError);
+		m_textLine += DRAW_STRING_NEW_LINE;
+		g_debugDraw.DrawString(5, m_textLine, "toi events/rounds [total] = %d/%d [%d/%d]", p.toiEvents, p.toiRounds,
+							   m_totalProfile.toiEvents, m_totalProfile.toiRounds);
+		m_textLine += DRAW_STRING_NEW_LINE;
+		g_debugDraw.DrawString(5, m_textLine, "toi queries/iters/root iters [total] = %d/%d/%d [%d/%d/%d]", p.toiQueries, p.toiIters,
+							   p.toiRootIters, m_totalProfile.toiQueries, m_totalProfile.toiIters, m_totalProfile.toiRootIters);
+		m_textLine += DRAW_STRING_NEW_LINE;
 	}
 
 	if (settings->doGUI && m_mouseJoint)
@@ -20,6 +20,7 @@
 #define TEST_H
 
 #include "Box2D/Box2D.h"
+#include "Simulation/BallRun.h"
 #include "DebugDraw.h"
 
 #if defined(__APPLE__)
@@ -76,8 +77,15 @@ struct Settings
 		drawStats = false;
 		drawProfile = false;
 		enableWarmStarting = true;
+		enableGraphColoring = false;
+		enableWideContactSolver = false;
+		enableWideTreeQueries = false;
+		enableSweepAndPrune = false;
+		enableStaticTree = false;
+		enableManifoldCache = false;
 		enableContinuous = true;
 		enableSubStepping = false;
+		enableTOIBatching = false;
 		enableSleep = true;
 		pause = false;
 		singleStep = false;
@@ -98,23 +106,23 @@ struct Settings
 	bool drawStats;
 	bool drawProfile;
 	bool enableWarmStarting;
+	bool enableGraphColoring;
+	bool enableWideContactSolver;
+	bool enableWideTreeQueries;
+	bool enableSweepAndPrune;
+	bool enableStaticTree;
+	bool enableManifoldCache;
 	bool enableContinuous;
 	bool enableSubStepping;
+	bool enableTOIBatching;
 	bool enableSleep;
 	bool pause;
 	bool singleStep;
 	bool doGUI;
-	std::vector<b2Vec2> bodies;
-	std::vector<float> rotations;
-	std::vector<b2Vec2> sizes;
-	std::vector<bool> gravity_on;
+	BallRunDef ballRun;
 
 	b2Vec2 p1;
 	b2Vec2 v1;
-
-	float gravity;
-	float friction;
-	float rest;
 };
 
 struct TestEntry
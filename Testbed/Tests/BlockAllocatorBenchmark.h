@@ -0,0 +1,218 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BLOCK_ALLOCATOR_BENCHMARK_H
+#define BLOCK_ALLOCATOR_BENCHMARK_H
+
+/// Every step replaces random blocks of a set of live blocks, with the sizes of
+/// the objects a world allocates, once with b2BlockAllocator and once with
+/// b2ConcurrentBlockAllocator on one thread, and averages the times. It also
+/// has the threads of a b2ThreadPool free and allocate blocks that other
+/// threads allocated, and checks that every block still holds what its owner
+/// wrote into it.
+class BlockAllocatorBenchmark : public Test
+{
+public:
+
+	enum
+	{
+		e_blockCount = 4096,
+		e_replaceCount = 16384,
+		e_sizeCount = 8,
+		e_stressCount = 20000
+	};
+
+	struct Block
+	{
+		void* memory;
+		int32 size;
+	};
+
+	// Checks and frees the block of each item, then allocates a new one and
+	// writes the item index to both ends. The ranges go to whichever thread is
+	// free, so most blocks are freed by another thread than their owner.
+	class StressTask : public b2ParallelTask
+	{
+	public:
+
+		void Execute(int32 begin, int32 end, int32 threadIndex)
+		{
+			for (int32 i = begin; i < end; ++i)
+			{
+				Block* block = m_blocks + i;
+				if (block->memory)
+				{
+					int32* first = (int32*)block->memory;
+					int32* last = (int32*)((int8*)block->memory + block->size) - 1;
+					if (*first != i || *last != i)
+					{
+						m_errorCount.fetch_add(1, std::memory_order_relaxed);
+					}
+					m_allocator->Free(block->memory, block->size, threadIndex);
+				}
+
+				block->size = 16 + 4 * ((i * 7919 + m_round * 31 + threadIndex) % 157);
+				block->memory = m_allocator->Allocate(block->size, threadIndex);
+
+				int32* first = (int32*)block->memory;
+				int32* last = (int32*)((int8*)block->memory + block->size) - 1;
+				*first = i;
+				*last = i;
+			}
+		}
+
+		b2ConcurrentBlockAllocator* m_allocator;
+		Block* m_blocks;
+		int32 m_round;
+		std::atomic<int32> m_errorCount;
+	};
+
+	BlockAllocatorBenchmark()
+	{
+		m_sizes[0] = sizeof(b2Body);
+		m_sizes[1] = sizeof(b2Fixture);
+		m_sizes[2] = sizeof(b2FixtureProxy);
+		m_sizes[3] = sizeof(b2Contact);
+		m_sizes[4] = sizeof(b2PolygonShape);
+		m_sizes[5] = sizeof(b2CircleShape);
+		m_sizes[6] = sizeof(b2ChainShape);
+		m_sizes[7] = sizeof(b2RevoluteJoint);
+
+		m_blockAllocator = new b2BlockAllocator;
+		m_concurrentAllocator = new b2ConcurrentBlockAllocator(1);
+		for (int32 i = 0; i < e_blockCount; ++i)
+		{
+			int32 size = m_sizes[i % e_sizeCount];
+			m_blocks[i].size = size;
+			m_blocks[i].memory = m_blockAllocator->Allocate(size);
+			m_concurrentBlocks[i].size = size;
+			m_concurrentBlocks[i].memory = m_concurrentAllocator->Allocate(size, 0);
+		}
+
+		// Zero uses the hardware concurrency.
+		m_threadPool = new b2ThreadPool(0);
+		m_stressAllocator = new b2ConcurrentBlockAllocator(m_threadPool->GetThreadCount());
+		for (int32 i = 0; i < e_stressCount; ++i)
+		{
+			m_stressBlocks[i].memory = NULL;
+			m_stressBlocks[i].size = 0;
+		}
+		m_stressTask.m_allocator = m_stressAllocator;
+		m_stressTask.m_blocks = m_stressBlocks;
+		m_stressTask.m_round = 0;
+		m_stressTask.m_errorCount.store(0, std::memory_order_relaxed);
+
+		m_blockTime = 0.0f;
+		m_concurrentTime = 0.0f;
+		m_stressTime = 0.0f;
+		m_stepCount = 0;
+	}
+
+	~BlockAllocatorBenchmark()
+	{
+		// The allocators release their chunks, and so the blocks, on deletion.
+		delete m_stressAllocator;
+		delete m_threadPool;
+		delete m_concurrentAllocator;
+		delete m_blockAllocator;
+	}
+
+	void RunBenchmark()
+	{
+		// Both allocators replace the same blocks with the same sizes.
+		for (int32 i = 0; i < e_replaceCount; ++i)
+		{
+			m_replaceIndices[i] = rand() % e_blockCount;
+			m_replaceSizes[i] = m_sizes[rand() % e_sizeCount];
+		}
+
+		b2Timer timer;
+		for (int32 i = 0; i < e_replaceCount; ++i)
+		{
+			Block* block = m_blocks + m_replaceIndices[i];
+			m_blockAllocator->Free(block->memory, block->size);
+			block->size = m_replaceSizes[i];
+			block->memory = m_blockAllocator->Allocate(block->size);
+		}
+		m_blockTime += timer.GetMilliseconds();
+
+		timer.Reset();
+		for (int32 i = 0; i < e_replaceCount; ++i)
+		{
+			Block* block = m_concurrentBlocks + m_replaceIndices[i];
+			m_concurrentAllocator->Free(block->memory, block->size, 0);
+			block->size = m_replaceSizes[i];
+			block->memory = m_concurrentAllocator->Allocate(block->size, 0);
+		}
+		m_concurrentTime += timer.GetMilliseconds();
+
+		// Vary the range size so the items move between the threads.
+		timer.Reset();
+		m_threadPool->ParallelFor(&m_stressTask, e_stressCount, 64 + 16 * (m_stepCount % 7));
+		m_stressTime += timer.GetMilliseconds();
+		++m_stressTask.m_round;
+
+		++m_stepCount;
+	}
+
+	void Step(Settings* settings)
+	{
+		Test::Step(settings);
+
+		if (settings->pause == false || settings->singleStep)
+		{
+			RunBenchmark();
+		}
+
+		float32 count = float32(b2Max(m_stepCount, 1));
+		g_debugDraw.DrawString(5, m_textLine, "block allocator ave = %5.3f ms, concurrent allocator ave = %5.3f ms over %d steps",
+			m_blockTime / count, m_concurrentTime / count, m_stepCount);
+		m_textLine += DRAW_STRING_NEW_LINE;
+
+		g_debugDraw.DrawString(5, m_textLine, "stress: threads = %d, ave = %5.3f ms, chunks = %d, errors = %d",
+			m_threadPool->GetThreadCount(), m_stressTime / count, m_stressAllocator->GetChunkCount(),
+			m_stressTask.m_errorCount.load(std::memory_order_relaxed));
+		m_textLine += DRAW_STRING_NEW_LINE;
+	}
+
+	static Test* Create()
+	{
+		return new BlockAllocatorBenchmark;
+	}
+
+	int32 m_sizes[e_sizeCount];
+
+	b2BlockAllocator* m_blockAllocator;
+	b2ConcurrentBlockAllocator* m_concurrentAllocator;
+	Block m_blocks[e_blockCount];
+	Block m_concurrentBlocks[e_blockCount];
+	int32 m_replaceIndices[e_replaceCount];
+	int32 m_replaceSizes[e_replaceCount];
+
+	b2ThreadPool* m_threadPool;
+	b2ConcurrentBlockAllocator* m_stressAllocator;
+	Block m_stressBlocks[e_stressCount];
+	StressTask m_stressTask;
+
+	float32 m_blockTime;
+	float32 m_concurrentTime;
+	float32 m_stressTime;
+	int32 m_stepCount;
+};
+
+#endif
@@ -0,0 +1,137 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BROAD_PHASE_BENCHMARK_H
+#define BROAD_PHASE_BENCHMARK_H
+
+/// A drum that keeps a granular pile of small bodies moving. The broad-phase
+/// time is averaged separately for tree queries and sweep and prune, so the
+/// two can be compared by toggling "Sweep and Prune".
+class BroadPhaseBenchmark : public Test
+{
+public:
+
+	enum
+	{
+		e_columns = 40,
+		e_rows = 50
+	};
+
+	BroadPhaseBenchmark()
+	{
+		b2Body* ground = NULL;
+		{
+			b2BodyDef bd;
+			ground = m_world->CreateBody(&bd);
+		}
+
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.allowSleep = false;
+			bd.position.Set(0.0f, 20.0f);
+			b2Body* body = m_world->CreateBody(&bd);
+
+			b2PolygonShape shape;
+			shape.SetAsBox(0.5f, 15.0f, b2Vec2( 15.0f, 0.0f), 0.0);
+			body->CreateFixture(&shape, 5.0f);
+			shape.SetAsBox(0.5f, 15.0f, b2Vec2(-15.0f, 0.0f), 0.0);
+			body->CreateFixture(&shape, 5.0f);
+			shape.SetAsBox(15.0f, 0.5f, b2Vec2(0.0f, 15.0f), 0.0);
+			body->CreateFixture(&shape, 5.0f);
+			shape.SetAsBox(15.0f, 0.5f, b2Vec2(0.0f, -15.0f), 0.0);
+			body->CreateFixture(&shape, 5.0f);
+
+			b2RevoluteJointDef jd;
+			jd.bodyA = ground;
+			jd.bodyB = body;
+			jd.localAnchorA.Set(0.0f, 20.0f);
+			jd.localAnchorB.Set(0.0f, 0.0f);
+			jd.referenceAngle = 0.0f;
+			jd.motorSpeed = 0.05f * b2_pi;
+			jd.maxMotorTorque = 1e8f;
+			jd.enableMotor = true;
+			m_world->CreateJoint(&jd);
+		}
+
+		{
+			b2CircleShape circle;
+			circle.m_radius = 0.2f;
+
+			b2PolygonShape box;
+			box.SetAsBox(0.2f, 0.2f);
+
+			for (int32 i = 0; i < e_rows; ++i)
+			{
+				for (int32 j = 0; j < e_columns; ++j)
+				{
+					b2BodyDef bd;
+					bd.type = b2_dynamicBody;
+					bd.position.Set(-12.0f + 0.6f * j, 8.0f + 0.5f * i);
+					b2Body* body = m_world->CreateBody(&bd);
+
+					if ((i + j) & 1)
+					{
+						body->CreateFixture(&circle, 1.0f);
+					}
+					else
+					{
+						body->CreateFixture(&box, 1.0f);
+					}
+				}
+			}
+		}
+
+		for (int32 i = 0; i < 2; ++i)
+		{
+			m_totalTimes[i] = 0.0f;
+			m_stepCounts[i] = 0;
+		}
+	}
+
+	void Step(Settings* settings)
+	{
+		Test::Step(settings);
+
+		if (settings->pause == false || settings->singleStep)
+		{
+			int32 method = m_world->GetSweepAndPrune() ? 1 : 0;
+			m_totalTimes[method] += m_world->GetProfile().broadphase;
+			++m_stepCounts[method];
+		}
+
+		const char* names[2] = { "tree queries", "sweep and prune" };
+		for (int32 i = 0; i < 2; ++i)
+		{
+			float32 average = m_stepCounts[i] > 0 ? m_totalTimes[i] / m_stepCounts[i] : 0.0f;
+			g_debugDraw.DrawString(5, m_textLine, "%s: broad-phase ave = %5.3f ms over %d steps",
+				names[i], average, m_stepCounts[i]);
+			m_textLine += DRAW_STRING_NEW_LINE;
+		}
+	}
+
+	static Test* Create()
+	{
+		return new BroadPhaseBenchmark;
+	}
+
+	float32 m_totalTimes[2];
+	int32 m_stepCounts[2];
+};
+
+#endif
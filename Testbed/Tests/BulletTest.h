@@ -19,51 +19,12 @@
 #ifndef BULLET_TEST_H
 #define BULLET_TEST_H
 
-#include <cmath>
-#define USE_NGON (1)
 class BulletTest : public Test
 {
   public:
 	BulletTest()
 	{
-
-		{
-			b2BodyDef bd;
-			bd.type = b2_dynamicBody;
-			bd.position.Set(0.0f, 4.0f);
-#if USE_NGON // use an ngon, has friction
-			b2PolygonShape shape;
-			float rad = 0.25;
-			int n = 8;
-			b2Vec2 points[n];
-			for (int i = 0; i < n; i++)
-			{
-				points[i].x = rad * std::sin(2.0 * M_PI * (float(i) / n));
-				points[i].y = rad * std::cos(2.0 * M_PI * (float(i) / n));
-			}
-
-			shape.Set(points, n);
-#else // use circle, has no friction
-			b2CircleShape shape;
-			shape.m_radius = 0.25f;
-#endif
-			//m_x = RandomFloat(-1.0f, 1.0f);
-			m_x = 0.20352793f;
-			bd.position.Set(m_x, 10.0f);
-			bd.bullet = true;
-
-			b2FixtureDef fd;
-
-			fd.shape = &shape;
-			fd.friction = 1.0;
-			fd.restitution = 0.00;
-			fd.density = 1.0f;
-
-			m_bullet = m_world->CreateBody(&bd);
-			//auto fix = m_bullet->CreateFixture(&shape, 100.0f);
-			m_bullet->CreateFixture(&fd);
-			//m_bullet->SetFixedRotation(true);
-		}
+		m_bullet = BallRunCreateBullet(m_world);
 	}
 
 	void Launch()
@@ -73,61 +34,16 @@ class BulletTest : public Test
 		//m_body->SetLinearVelocity(b2Vec2_zero);
 		//m_body->SetAngularVelocity(0.0f);
 
-		extern int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
-		extern int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
-		extern int32 b2_toiRootIters, b2_toiMaxRootIters;
+		extern thread_local int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
 
 		b2_gjkCalls = 0;
 		b2_gjkIters = 0;
 		b2_gjkMaxIters = 0;
-
-		b2_toiCalls = 0;
-		b2_toiIters = 0;
-		b2_toiMaxIters = 0;
-		b2_toiRootIters = 0;
-		b2_toiMaxRootIters = 0;
 	}
 
 	void Setup(Settings *settings)
 	{
-		m_world->SetGravity(b2Vec2(0.0f, settings->gravity));
-		m_bodies.resize(settings->bodies.size());
-		b2BodyDef bd;
-
-		b2PolygonShape box;
-		for (int i = 0; i < settings->bodies.size(); i++)
-		{
-			b2FixtureDef fd;
-
-			bd.type = b2_staticBody;
-			if (settings->gravity_on[i])
-			{
-				bd.type = b2_dynamicBody;
-			}
-
-			fd.shape = &box;
-			fd.friction = settings->friction;
-			fd.restitution = settings->rest;
-			fd.density = 1.0f;
-
-			bd.position.Set(0.0f, 0.0f);
-			bd.angle = 0.0;
-			box.SetAsBox(settings->sizes[i].x, settings->sizes[i].y);
-			m_bodies[i] = m_world->CreateBody(&bd);
-			m_bodies[i]->CreateFixture(&fd);
-			//auto fix = m_bodies[i]->CreateFixture(&box, 1.0f);
-			//a
-			//fix->SetRestitution(0.75);
-
-			m_bodies[i]->SetTransform(settings->bodies[i], settings->rotations[i]);
-			m_bodies[i]->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
-			m_bodies[i]->SetAngularVelocity(0.0f);
-		}
-		m_bullet->SetTransform(b2Vec2(-30.0f, 40.0f), 0.0f);
-		//m_bullet->SetLinearVelocity(b2Vec2(2.2f, 0.0f));
-		m_bullet->SetLinearVelocity(b2Vec2(3.0f, -1.0f));
-		//m_bullet->SetLinearVelocity(b2Vec2(20.0f, 0.0f));
-		m_bullet->SetAngularVelocity(0.0f);
+		BallRunSetup(m_world, m_bullet, settings->ballRun, &m_bodies);
 	}
 	void Step(Settings *settings)
 	{
@@ -139,9 +55,7 @@ class BulletTest : public Test
 		settings->v1 = v;
 		if (settings->doGUI)
 			printf("%f %f %f %f\n", p.x, p.y, v.x, v.y);
-		extern int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
-		extern int32 b2_toiCalls, b2_toiIters;
-		extern int32 b2_toiRootIters, b2_toiMaxRootIters;
+		extern thread_local int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
 		if (settings->doGUI)
 		{
 			if (b2_gjkCalls > 0)
@@ -151,14 +65,13 @@ class BulletTest : public Test
 				m_textLine += DRAW_STRING_NEW_LINE;
 			}
 
-			if (b2_toiCalls > 0)
+			// The world counts the TOI queries, which may run on the thread pool.
+			const b2Profile &total = m_totalProfile;
+			if (total.toiQueries > 0)
 			{
-				g_debugDraw.DrawString(5, m_textLine, "toi calls = %d, ave toi iters = %3.1f, max toi iters = %d",
-									   b2_toiCalls, b2_toiIters / float32(b2_toiCalls), b2_toiMaxRootIters);
-				m_textLine += DRAW_STRING_NEW_LINE;
-
-				g_debugDraw.DrawString(5, m_textLine, "ave toi root iters = %3.1f, max toi root iters = %d",
-									   b2_toiRootIters / float32(b2_toiCalls), b2_toiMaxRootIters);
+				g_debugDraw.DrawString(5, m_textLine, "toi queries = %d, ave toi iters = %3.1f, ave toi root iters = %3.1f",
+									   total.toiQueries, total.toiIters / float32(total.toiQueries),
+									   total.toiRootIters / float32(total.toiQueries));
 				m_textLine += DRAW_STRING_NEW_LINE;
 			}
 		}
@@ -170,9 +83,7 @@ class BulletTest : public Test
 	}
 
 	std::vector<b2Body *> m_bodies;
-	int m_num = 0;
 	b2Body *m_bullet;
-	float32 m_x;
 };
 
 #endif
@@ -78,10 +78,10 @@ public:
 		}
 #endif
 
-		extern int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
-		extern int32 b2_toiCalls, b2_toiIters;
-		extern int32 b2_toiRootIters, b2_toiMaxRootIters;
-		extern float32 b2_toiTime, b2_toiMaxTime;
+		extern thread_local int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+		extern thread_local int32 b2_toiCalls, b2_toiIters;
+		extern thread_local int32 b2_toiRootIters, b2_toiMaxRootIters;
+		extern thread_local float32 b2_toiTime, b2_toiMaxTime;
 
 		b2_gjkCalls = 0; b2_gjkIters = 0; b2_gjkMaxIters = 0;
 		b2_toiCalls = 0; b2_toiIters = 0;
@@ -91,10 +91,10 @@ public:
 
 	void Launch()
 	{
-		extern int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
-		extern int32 b2_toiCalls, b2_toiIters;
-		extern int32 b2_toiRootIters, b2_toiMaxRootIters;
-		extern float32 b2_toiTime, b2_toiMaxTime;
+		extern thread_local int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+		extern thread_local int32 b2_toiCalls, b2_toiIters;
+		extern thread_local int32 b2_toiRootIters, b2_toiMaxRootIters;
+		extern thread_local float32 b2_toiTime, b2_toiMaxTime;
 
 		b2_gjkCalls = 0; b2_gjkIters = 0; b2_gjkMaxIters = 0;
 		b2_toiCalls = 0; b2_toiIters = 0;
@@ -111,7 +111,7 @@ public:
 	{
 		Test::Step(settings);
 
-		extern int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+		extern thread_local int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
 
 		if (b2_gjkCalls > 0)
 		{
@@ -120,9 +120,9 @@ public:
 			m_textLine += DRAW_STRING_NEW_LINE;
 		}
 
-		extern int32 b2_toiCalls, b2_toiIters;
-		extern int32 b2_toiRootIters, b2_toiMaxRootIters;
-		extern float32 b2_toiTime, b2_toiMaxTime;
+		extern thread_local int32 b2_toiCalls, b2_toiIters;
+		extern thread_local int32 b2_toiRootIters, b2_toiMaxRootIters;
+		extern thread_local float32 b2_toiTime, b2_toiMaxTime;
 
 		if (b2_toiCalls > 0)
 		{
@@ -0,0 +1,159 @@
+/*
+* Copyright (c) 2006-2016 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef TOI_BATCHING_H
+#define TOI_BATCHING_H
+
+/// Two bullets fly at each other. The first one hits a deflector early in the
+/// step and the second one hits a wall late in the step, so both TOI events are
+/// in the first round with batching. The deflected bullet meets the second one
+/// in between, which batching must not skip. The test steps the scene once
+/// with and once without batching in worlds of its own and compares the
+/// bullets. Press 'r' to launch the bullets again in the test world.
+class TOIBatching : public Test
+{
+public:
+
+	struct BulletListener : public b2ContactListener
+	{
+		void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override
+		{
+			B2_NOT_USED(oldManifold);
+
+			b2Body* bodyA = contact->GetFixtureA()->GetBody();
+			b2Body* bodyB = contact->GetFixtureB()->GetBody();
+			if ((bodyA == m_bullet1 && bodyB == m_bullet2) || (bodyA == m_bullet2 && bodyB == m_bullet1))
+			{
+				++m_hitCount;
+			}
+		}
+
+		b2Body* m_bullet1;
+		b2Body* m_bullet2;
+		int32 m_hitCount;
+	};
+
+	TOIBatching()
+	{
+		m_world->SetGravity(b2Vec2(0.0f, 0.0f));
+		CreateScene(m_world, &m_bullet1, &m_bullet2);
+
+		for (int32 i = 0; i < 2; ++i)
+		{
+			b2World world(b2Vec2(0.0f, 0.0f));
+			world.SetTOIBatching(i == 1);
+
+			BulletListener listener;
+			CreateScene(&world, &listener.m_bullet1, &listener.m_bullet2);
+			listener.m_hitCount = 0;
+			world.SetContactListener(&listener);
+
+			world.Step(1.0f / 60.0f, 8, 3);
+
+			m_positions[i][0] = listener.m_bullet1->GetPosition();
+			m_positions[i][1] = listener.m_bullet2->GetPosition();
+			m_hitCounts[i] = listener.m_hitCount;
+		}
+	}
+
+	static void CreateScene(b2World* world, b2Body** bullet1, b2Body** bullet2)
+	{
+		b2BodyDef bd;
+		b2Body* ground = world->CreateBody(&bd);
+
+		b2PolygonShape box;
+		box.SetAsBox(0.1f, 0.02f, b2Vec2(0.62f, 0.02f), 0.25f * b2_pi);
+		ground->CreateFixture(&box, 0.0f);
+
+		box.SetAsBox(0.05f, 0.5f, b2Vec2(-0.7f, 0.35f), 0.0f);
+		ground->CreateFixture(&box, 0.0f);
+
+		b2CircleShape circle;
+		circle.m_radius = 0.05f;
+
+		b2FixtureDef fd;
+		fd.shape = &circle;
+		fd.density = 1.0f;
+		fd.restitution = 1.0f;
+		fd.friction = 0.0f;
+
+		bd.type = b2_dynamicBody;
+		bd.bullet = true;
+
+		bd.position.Set(0.0f, 0.0f);
+		bd.linearVelocity.Set(120.0f, 0.0f);
+		*bullet1 = world->CreateBody(&bd);
+		(*bullet1)->CreateFixture(&fd);
+
+		bd.position.Set(1.24f, 0.35f);
+		bd.linearVelocity.Set(-120.0f, 0.0f);
+		*bullet2 = world->CreateBody(&bd);
+		(*bullet2)->CreateFixture(&fd);
+	}
+
+	void Launch()
+	{
+		m_bullet1->SetTransform(b2Vec2(0.0f, 0.0f), 0.0f);
+		m_bullet1->SetLinearVelocity(b2Vec2(120.0f, 0.0f));
+		m_bullet1->SetAngularVelocity(0.0f);
+
+		m_bullet2->SetTransform(b2Vec2(1.24f, 0.35f), 0.0f);
+		m_bullet2->SetLinearVelocity(b2Vec2(-120.0f, 0.0f));
+		m_bullet2->SetAngularVelocity(0.0f);
+	}
+
+	void Keyboard(int key) override
+	{
+		switch (key)
+		{
+		case GLFW_KEY_R:
+			Launch();
+			break;
+		}
+	}
+
+	void Step(Settings* settings)
+	{
+		Test::Step(settings);
+
+		for (int32 i = 0; i < 2; ++i)
+		{
+			g_debugDraw.DrawString(5, m_textLine, "%s: bullet hits = %d, bullet 1 = (%5.3f, %5.3f), bullet 2 = (%5.3f, %5.3f)",
+				i == 0 ? "sequential" : "batched", m_hitCounts[i],
+				m_positions[i][0].x, m_positions[i][0].y, m_positions[i][1].x, m_positions[i][1].y);
+			m_textLine += DRAW_STRING_NEW_LINE;
+		}
+
+		bool match = m_hitCounts[0] == m_hitCounts[1] &&
+			m_positions[0][0] == m_positions[1][0] && m_positions[0][1] == m_positions[1][1];
+		g_debugDraw.DrawString(5, m_textLine, match ? "batching matches the sequential order" : "batching DIFFERS from the sequential order");
+		m_textLine += DRAW_STRING_NEW_LINE;
+	}
+
+	static Test* Create()
+	{
+		return new TOIBatching;
+	}
+
+	b2Body* m_bullet1;
+	b2Body* m_bullet2;
+	b2Vec2 m_positions[2][2];
+	int32 m_hitCounts[2];
+};
+
+#endif
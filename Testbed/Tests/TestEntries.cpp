@@ -21,9 +21,11 @@
 #include "AddPair.h"
 #include "ApplyForce.h"
 #include "BasicSliderCrank.h"
+#include "BlockAllocatorBenchmark.h"
 #include "BodyTypes.h"
 #include "Breakable.h"
 #include "Bridge.h"
+#include "BroadPhaseBenchmark.h"
 #include "BulletTest.h"
 #include "Cantilever.h"
 #include "Car.h"
@@ -65,6 +67,7 @@
 #include "TheoJansen.h"
 #include "Tiles.h"
 #include "TimeOfImpact.h"
+#include "TOIBatching.h"
 #include "Tumbler.h"
 #include "VaryingFriction.h"
 #include "VaryingRestitution.h"
@@ -84,11 +87,14 @@ TestEntry g_testEntries[] =
 	{"Sphere Stack", SphereStack::Create},
 	{"Convex Hull", ConvexHull::Create},
 	{"Tumbler", Tumbler::Create},
+	{"Broad-phase Benchmark", BroadPhaseBenchmark::Create},
+	{"Block Allocator Benchmark", BlockAllocatorBenchmark::Create},
 	{"Ray-Cast", RayCast::Create},
 	{"Dump Shell", DumpShell::Create},
 	{"Apply Force", ApplyForce::Create},
 	{"Continuous Test", ContinuousTest::Create},
 	{"Time of Impact", TimeOfImpact::Create},
+	{"TOI Batching", TOIBatching::Create},
 	{"Motor Joint", MotorJoint::Create},
 	{"One-Sided Platform", OneSidedPlatform::Create},
 	{"Mobile", Mobile::Create},
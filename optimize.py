@@ -21,31 +21,96 @@ def get_prog_path():
 
 def get_lib_path():
   from sys import platform
-  return get_prog_path_name("libTestbed_lib" + ('.dylib' if platform == "darwin" else '.so'))
+  return get_prog_path_name("libSimulation_lib" + ('.dylib' if platform == "darwin" else '.so'))
 
 def run_prog_process(args):
   return list(map(float, subprocess.check_output([get_prog_path()] + args).strip().split()))
 
 import ctypes
-#prog_lib = ctypes.cdll.LoadLibrary(get_lib_path())
 prog_lib = ctypes.CDLL(get_lib_path())
-
-def run_prog_lib(args):
-  argc = len(args) + 1
-  argv_l = ["asdf"] + args
-
-  argv_type = ctypes.POINTER(ctypes.POINTER(ctypes.c_char))
-  ret_type = ctypes.c_float * 2
-
-  argv = (ctypes.POINTER(ctypes.c_char) * (argc + 1))()
-  for i, arg in enumerate(argv_l):
-    argv[i] = ctypes.create_string_buffer(arg.encode())
-
-  prog_lib.my_func.restype = ctypes.POINTER(ctypes.c_float)
-  rets = prog_lib.my_func(argc, argv)
-  size = int(round(np.ctypeslib.as_array(rets, shape=(1,))[0]))
-  positions = np.frombuffer((ctypes.c_float * (size + 1)).from_address(ctypes.addressof(rets.contents)), np.float32).copy()
-  return positions[1:]
+prog_lib.evaluator_create.restype = ctypes.c_void_p
+prog_lib.evaluator_run.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.c_int,
+                                   ctypes.c_int, ctypes.POINTER(ctypes.c_float), ctypes.c_int]
+# Uses every core, the worker threads live as long as the script.
+evaluator = prog_lib.evaluator_create(0)
+
+max_steps = 750
+
+class BallRunObjective(ctypes.Structure):
+  """ Mirrors BallRunObjective in Simulation/Simulation.h """
+  _fields_ = [("cost", ctypes.c_int),
+              ("goalX", ctypes.c_float), ("goalY", ctypes.c_float),
+              ("restRadius", ctypes.c_float), ("restSpeed", ctypes.c_float), ("restSteps", ctypes.c_int),
+              ("reachEnabled", ctypes.c_int), ("reachHeight", ctypes.c_float),
+              ("reference", ctypes.POINTER(ctypes.c_float)), ("referenceCount", ctypes.c_int),
+              ("discount", ctypes.c_float)]
+
+BALL_RUN_COST_GOAL = 0
+
+prog_lib.evaluator_run_cost.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.c_int,
+                                        ctypes.c_int, ctypes.POINTER(BallRunObjective),
+                                        ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_int),
+                                        ctypes.c_int]
+
+def run_prog_lib_batch_cost(params, objective):
+  """ Runs one scene per row of params, returns the cost of each evaluated in the engine """
+  params = np.ascontiguousarray(params, dtype=np.float32)
+  count, param_count = params.shape
+  costs = np.empty(count, dtype=np.float32)
+
+  float_p = ctypes.POINTER(ctypes.c_float)
+  ret = prog_lib.evaluator_run_cost(evaluator, params.ctypes.data_as(float_p), count, param_count,
+                                    ctypes.byref(objective), costs.ctypes.data_as(float_p), None, max_steps)
+  assert ret == 0
+  return costs.astype(np.float64)
+
+def run_prog_lib_batch(params):
+  """ Runs one scene per row of params, returns a list of position arrays """
+  params = np.ascontiguousarray(params, dtype=np.float32)
+  count, param_count = params.shape
+  output = np.empty((count, 1 + 2 * max_steps), dtype=np.float32)
+
+  float_p = ctypes.POINTER(ctypes.c_float)
+  ret = prog_lib.evaluator_run(evaluator, params.ctypes.data_as(float_p), count, param_count,
+                               output.ctypes.data_as(float_p), max_steps)
+  assert ret == 0
+  return [row[1:1 + int(row[0])] for row in output]
+
+class BallRunRecording(ctypes.Structure):
+  """ Mirrors BallRunRecording in Simulation/Simulation.h """
+  _fields_ = [("channels", ctypes.c_int), ("interval", ctypes.c_int),
+              ("output", ctypes.POINTER(ctypes.c_float)),
+              ("sceneStride", ctypes.c_int), ("sampleStride", ctypes.c_int), ("sampleCapacity", ctypes.c_int),
+              ("sampleCounts", ctypes.POINTER(ctypes.c_int))]
+
+BALL_RUN_CHANNEL_STEP = 0x01
+BALL_RUN_CHANNEL_POSITION = 0x02
+BALL_RUN_CHANNEL_VELOCITY = 0x04
+BALL_RUN_CHANNEL_ANGLE = 0x08
+BALL_RUN_CHANNEL_ANGULAR_VELOCITY = 0x10
+BALL_RUN_CHANNEL_CONTACTS = 0x20
+
+prog_lib.evaluator_run_record.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.c_int,
+                                          ctypes.c_int, ctypes.POINTER(BallRunRecording), ctypes.c_int]
+
+def run_prog_lib_record(params, channels=BALL_RUN_CHANNEL_POSITION, interval=1):
+  """ Runs one scene per row of params, returns a list of (samples, width) views of one
+      preallocated buffer holding the selected channels """
+  params = np.ascontiguousarray(params, dtype=np.float32)
+  count, param_count = params.shape
+  width = prog_lib.ball_run_sample_width(channels)
+  capacity = prog_lib.ball_run_sample_capacity(max_steps, interval)
+  output = np.empty((count, capacity, width), dtype=np.float32)
+  sample_counts = np.empty(count, dtype=np.int32)
+
+  recording = BallRunRecording(channels, interval, output.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+                               capacity * width, width, capacity,
+                               sample_counts.ctypes.data_as(ctypes.POINTER(ctypes.c_int)))
+  float_p = ctypes.POINTER(ctypes.c_float)
+  ret = prog_lib.evaluator_run_record(evaluator, params.ctypes.data_as(float_p), count, param_count,
+                                      ctypes.byref(recording), max_steps)
+  assert ret == 0
+  return [output[i, :n] for i, n in enumerate(sample_counts)]
 
 def go_right(positions):
   return -positions[-2]
@@ -58,6 +123,12 @@ def cost_part_4(positions):
   x, y = positions[-2], positions[-1]
   return (x - box_x_4) ** 2 + (y - box_y_4) ** 2
 
+# The same cost evaluated while stepping. All obstacles are static, so the run
+# can end once the ball sleeps (a zero rest speed leaves only sleeping): its
+# final position no longer changes.
+objective_part_4 = BallRunObjective(cost=BALL_RUN_COST_GOAL, goalX=box_x_4, goalY=box_y_4,
+                                    restSteps=1, restSpeed=0.0)
+
 def my_normalize(vec):
   """ Vec is n by 2 """
   start = vec[0, :]
@@ -112,6 +183,10 @@ def cost_part_6(positions):
   x, y = positions[-2], positions[-1]
   return (x - box_x_6) ** 2 + (y - box_y_6) ** 2
 
+# The falling obstacles can still hit a resting ball, so this only moves the
+# cost into the engine.
+objective_part_6 = BallRunObjective(cost=BALL_RUN_COST_GOAL, goalX=box_x_6, goalY=box_y_6)
+
 # params are
 # gravity, friction, restitution
 # then N times of
@@ -180,11 +255,13 @@ def fdlib(*args):
   return f(args)
 
 def f(x, *args):
-  real_x = get_params(x)
-  positions = run_prog_lib(['0'] + list(map(str, real_x)))
-  cost = cost_function(positions)
+  return f_batch([x])[0]
 
-  return cost
+def f_batch(xs):
+  params = np.array([get_params(x) for x in xs])
+  if objective is not None:
+    return run_prog_lib_batch_cost(params, objective)
+  return np.array([cost_function(positions) for positions in run_prog_lib_batch(params)])
 
 def method_basinhopping():
   class MyBounds(object):
@@ -205,7 +282,9 @@ def method_basinhopping():
   return result.fun, result.x
 
 def method_differential_evolution():
-  result = differential_evolution(f, bounds, maxiter=args.opt_iters, disp=True)
+  # The map-like workers callable hands each whole generation to the evaluator.
+  result = differential_evolution(f, bounds, maxiter=args.opt_iters, disp=True,
+                                  updating='deferred', workers=lambda func, xs: f_batch(list(xs)))
   return result.fun, result.x
 
 def get_random_x0():
@@ -233,13 +312,14 @@ def method_slsqp_low():
 def method_random():
   best = 1e20
   best_x = None
-  for i in range(args.opt_iters):
-    x0 = get_random_x0()
-    cost = f(x0)
+  batch_size = 1000
+  for i in range(0, args.opt_iters, batch_size):
+    xs = [get_random_x0() for _ in range(min(batch_size, args.opt_iters - i))]
+    costs = f_batch(xs)
 
-    if cost < best:
-      best = cost
-      best_x = x0
+    if costs.min() < best:
+      best = costs.min()
+      best_x = xs[np.argmin(costs)]
 
   return best, best_x
 
@@ -286,6 +366,7 @@ if __name__ == "__main__":
   params_map = get_map('get_params_part_')
   bounds_map = get_map('get_bounds_part_')
   cost_map = get_map('cost_part_')
+  objective_map = get_map('objective_part_')
 
   parser = argparse.ArgumentParser()
   parser.add_argument("method", default="random", type=str, nargs='?', choices=method_map.keys())
@@ -295,6 +376,7 @@ if __name__ == "__main__":
   args = parser.parse_args()
 
   cost_function = cost_map[args.part]
+  objective = objective_map.get(args.part)
   method = method_map[args.method]
   get_params = params_map[args.part]
   bounds = bounds_map[args.part]()
@@ -128,7 +128,7 @@ project "Testbed"
 	kind "ConsoleApp"
 	language "C++"
 	defines { "GLEW_STATIC" }
-	files { "Testbed/**.h", "Testbed/**.cpp" }
+	files { "Testbed/**.h", "Testbed/**.cpp", "Simulation/BallRun*.h", "Simulation/BallRun*.cpp" }
 	includedirs { "." }
 	links { "Box2D", "GLFW", "IMGUI"}
 	configuration { "windows" }
@@ -143,7 +143,7 @@ project "Testbed_lib"
 	kind "SharedLib"
 	language "C++"
 	defines { "GLEW_STATIC" }
-	files { "Testbed/**.h", "Testbed/**.cpp" }
+	files { "Testbed/**.h", "Testbed/**.cpp", "Simulation/BallRun*.h", "Simulation/BallRun*.cpp" }
 	includedirs { "." }
 	links { "Box2D", "GLFW", "IMGUI"}
 	configuration { "windows" }
@@ -153,3 +153,12 @@ project "Testbed_lib"
 		links { "OpenGL.framework", "Cocoa.framework", "IOKit.framework", "CoreFoundation.framework", "CoreVideo.framework"}
 	configuration { "linux" }
 		links { "GL", "GLU", "GLEW", "X11", "Xrandr", "Xinerama", "Xcursor", "pthread", "dl" }
+
+project "Simulation_lib"
+	kind "SharedLib"
+	language "C++"
+	files { "Simulation/**.h", "Simulation/**.cpp" }
+	includedirs { "." }
+	links { "Box2D" }
+	configuration { "linux" }
+		links { "pthread" }